@@ -16,6 +16,7 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  2026-10-19: Misc: Added ImGui_ImplSDL2_InitForSDLRenderer() for use with imgui_impl_sdlrenderer.cpp.
 //  2018-08-01: Inputs: Workaround for Emscripten which doesn't seem to handle focus related calls.
 //  2018-06-29: Inputs: Added support for the ImGuiMouseCursor_Hand cursor.
 //  2018-06-08: Misc: Extracted imgui_impl_sdl.cpp/.h away from the old combined SDL2+OpenGL/Vulkan examples.
@@ -176,6 +177,11 @@ bool ImGui_ImplSDL2_InitForOpenGL(struct SDL_Window* window, void* sdl_gl_contex
     return ImGui_ImplSDL2_Init(window);
 }
 
+bool ImGui_ImplSDL2_InitForSDLRenderer(struct SDL_Window* window)
+{
+    return ImGui_ImplSDL2_Init(window);
+}
+
 bool ImGui_ImplSDL2_InitForVulkan(struct SDL_Window* window)
 {
     #if !SDL_HAS_VULKAN
@@ -18,6 +18,7 @@ struct SDL_Window;
 typedef union SDL_Event SDL_Event;
 
 IMGUI_IMPL_API bool     ImGui_ImplSDL2_InitForOpenGL(struct SDL_Window* window, void* sdl_gl_context);
+IMGUI_IMPL_API bool     ImGui_ImplSDL2_InitForSDLRenderer(struct SDL_Window* window);
 IMGUI_IMPL_API bool     ImGui_ImplSDL2_InitForVulkan(struct SDL_Window* window);
 IMGUI_IMPL_API void     ImGui_ImplSDL2_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplSDL2_NewFrame(struct SDL_Window* window);
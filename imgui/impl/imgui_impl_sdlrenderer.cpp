@@ -0,0 +1,188 @@
+// dear imgui: Renderer for SDL_Renderer (SDL 2.0.18+)
+// This needs to be used along with the SDL2 Platform Binding (imgui_impl_sdl.cpp)
+// (Info: draws through SDL_RenderGeometryRaw() on the same SDL_Renderer as the game, so a frame needs only one SDL_RenderPresent())
+
+// Implemented features:
+//  [X] Renderer: User texture binding. Use 'SDL_Texture*' as ImTextureID.
+// Missing features:
+//  [ ] Renderer: Multi-viewport support (multiple windows).
+
+// You can copy and use unmodified imgui_impl_* files in your project. See main.cpp for an example of using this.
+// If you are new to dear imgui, read examples/README.txt and read the documentation at the top of imgui.cpp.
+// https://github.com/ocornut/imgui
+
+// CHANGELOG
+//  2026-10-19: Initial version, replaces the OpenGL3 renderer so ImGui and the game share one SDL_Renderer and one present per frame.
+
+#include "imgui.h"
+#include "imgui_impl_sdlrenderer.h"
+#include <stdint.h>     // intptr_t
+
+// SDL
+#include <SDL.h>
+#if !SDL_VERSION_ATLEAST(2,0,18)
+#error This backend requires SDL 2.0.18+ because of SDL_RenderGeometryRaw() function
+#endif
+
+// SDL_Renderer Data
+static SDL_Renderer*    g_Renderer = NULL;
+static SDL_Texture*     g_FontTexture = NULL;
+
+// Functions
+bool    ImGui_ImplSDLRenderer_Init(SDL_Renderer* renderer)
+{
+    IM_ASSERT(renderer != NULL && "SDL_Renderer not initialized!");
+    g_Renderer = renderer;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "imgui_impl_sdlrenderer";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // We can honor the ImDrawCmd::VtxOffset field, allowing for large meshes.
+    return true;
+}
+
+void    ImGui_ImplSDLRenderer_Shutdown()
+{
+    ImGui_ImplSDLRenderer_DestroyDeviceObjects();
+    g_Renderer = NULL;
+}
+
+void    ImGui_ImplSDLRenderer_NewFrame()
+{
+    if (!g_FontTexture)
+        ImGui_ImplSDLRenderer_CreateDeviceObjects();
+}
+
+// Render function.
+// Submits every ImDrawCmd as one SDL_RenderGeometryRaw() call into the current frame. Does not present:
+// the caller calls SDL_RenderPresent() once after both the game world and ImGui have been drawn.
+void    ImGui_ImplSDLRenderer_RenderDrawData(ImDrawData* draw_data)
+{
+    // If there's a scale factor set by the user, use that instead
+    // If the user has specified a scale factor to SDL_Renderer already via SDL_RenderSetScale(), SDL will scale whatever we pass
+    // to SDL_RenderGeometryRaw() by that scale factor. In that case we don't want to be also scaling it ourselves here.
+    float rsx = 1.0f;
+    float rsy = 1.0f;
+    SDL_RenderGetScale(g_Renderer, &rsx, &rsy);
+    ImVec2 render_scale;
+    render_scale.x = (rsx == 1.0f) ? draw_data->FramebufferScale.x : 1.0f;
+    render_scale.y = (rsy == 1.0f) ? draw_data->FramebufferScale.y : 1.0f;
+
+    // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
+    int fb_width = (int)(draw_data->DisplaySize.x * render_scale.x);
+    int fb_height = (int)(draw_data->DisplaySize.y * render_scale.y);
+    if (fb_width == 0 || fb_height == 0)
+        return;
+
+    // Backup SDL_Renderer state that will be modified to restore it afterwards
+    SDL_Rect last_viewport;
+    SDL_Rect last_clip_rect;
+    bool last_clip_enabled = SDL_RenderIsClipEnabled(g_Renderer) == SDL_TRUE;
+    SDL_RenderGetViewport(g_Renderer, &last_viewport);
+    SDL_RenderGetClipRect(g_Renderer, &last_clip_rect);
+
+    // Setup viewport: ImGui draws over the whole output regardless of what the game set up
+    SDL_RenderSetViewport(g_Renderer, NULL);
+    SDL_RenderSetClipRect(g_Renderer, NULL);
+
+    // Will project scissor/clipping rectangles into framebuffer space
+    ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
+    ImVec2 clip_scale = render_scale;
+
+    // Render command lists
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        const ImDrawVert* vtx_buffer = cmd_list->VtxBuffer.Data;
+        const ImDrawIdx* idx_buffer = cmd_list->IdxBuffer.Data;
+
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback)
+            {
+                // User callback (registered via ImDrawList::AddCallback)
+                pcmd->UserCallback(cmd_list, pcmd);
+                continue;
+            }
+
+            // Project scissor/clipping rectangles into framebuffer space
+            ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
+            ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+            if (clip_min.x < 0.0f) { clip_min.x = 0.0f; }
+            if (clip_min.y < 0.0f) { clip_min.y = 0.0f; }
+            if (clip_max.x > (float)fb_width) { clip_max.x = (float)fb_width; }
+            if (clip_max.y > (float)fb_height) { clip_max.y = (float)fb_height; }
+            if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+                continue;
+
+            SDL_Rect r = { (int)(clip_min.x), (int)(clip_min.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y) };
+            SDL_RenderSetClipRect(g_Renderer, &r);
+
+            // ImDrawVert is { ImVec2 pos; ImVec2 uv; ImU32 col; }, so the three attribute streams are strided views into one buffer
+            const ImDrawVert* vtx = vtx_buffer + pcmd->VtxOffset;
+            const float* xy = (const float*)(const void*)((const char*)vtx + IM_OFFSETOF(ImDrawVert, pos));
+            const float* uv = (const float*)(const void*)((const char*)vtx + IM_OFFSETOF(ImDrawVert, uv));
+            const SDL_Color* color = (const SDL_Color*)(const void*)((const char*)vtx + IM_OFFSETOF(ImDrawVert, col)); // SDL 2.0.19+
+
+            // Bind texture, Draw
+            SDL_Texture* tex = (SDL_Texture*)(intptr_t)pcmd->GetTexID();
+            SDL_RenderGeometryRaw(g_Renderer, tex,
+                xy, (int)sizeof(ImDrawVert),
+                color, (int)sizeof(ImDrawVert),
+                uv, (int)sizeof(ImDrawVert),
+                cmd_list->VtxBuffer.Size - pcmd->VtxOffset,
+                idx_buffer + pcmd->IdxOffset, pcmd->ElemCount, sizeof(ImDrawIdx));
+        }
+    }
+
+    // Restore modified SDL_Renderer state
+    SDL_RenderSetViewport(g_Renderer, &last_viewport);
+    SDL_RenderSetClipRect(g_Renderer, last_clip_enabled ? &last_clip_rect : NULL);
+}
+
+bool ImGui_ImplSDLRenderer_CreateFontsTexture()
+{
+    // Build texture atlas
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bits (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders.
+
+    // Upload texture to graphics system
+    // (Bilinear sampling is required by default. Set 'io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines' or 'style.AntiAliasedLinesUseTex = false' to allow point/nearest sampling)
+    g_FontTexture = SDL_CreateTexture(g_Renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (g_FontTexture == NULL)
+    {
+        SDL_Log("error creating texture");
+        return false;
+    }
+    SDL_UpdateTexture(g_FontTexture, NULL, pixels, 4 * width);
+    SDL_SetTextureBlendMode(g_FontTexture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(g_FontTexture, SDL_ScaleModeLinear);
+
+    // Store our identifier
+    io.Fonts->SetTexID((ImTextureID)(intptr_t)g_FontTexture);
+
+    return true;
+}
+
+void ImGui_ImplSDLRenderer_DestroyFontsTexture()
+{
+    if (g_FontTexture)
+    {
+        ImGuiIO& io = ImGui::GetIO();
+        io.Fonts->SetTexID(0);
+        SDL_DestroyTexture(g_FontTexture);
+        g_FontTexture = NULL;
+    }
+}
+
+bool    ImGui_ImplSDLRenderer_CreateDeviceObjects()
+{
+    return ImGui_ImplSDLRenderer_CreateFontsTexture();
+}
+
+void    ImGui_ImplSDLRenderer_DestroyDeviceObjects()
+{
+    ImGui_ImplSDLRenderer_DestroyFontsTexture();
+}
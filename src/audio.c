@@ -0,0 +1,391 @@
+#include "audio.h"
+#include "stream.h"
+
+#define AUDIO_PI 3.14159265358979323846f
+
+static const char* soundFiles[SOUND_COUNT] = {
+    "Assets/Audio/shot.wav",
+    "Assets/Audio/hit.wav",
+    "Assets/Audio/pickup.wav",
+    "Assets/Audio/explosion.wav",
+};
+
+static const char* musicFile = "Assets/Audio/music.wav";
+
+// Decodes a WAV of any format SDL reads to the mixer's float stereo at AUDIO_RATE
+static bool loadSample(AudioSample* sample, const char* path) {
+    SDL_AudioSpec spec;
+    Uint8* data = NULL;
+    Uint32 length = 0;
+    if (SDL_LoadWAV(path, &spec, &data, &length) == NULL) return false;
+
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_F32SYS, 2, AUDIO_RATE) < 0) {
+        SDL_FreeWAV(data);
+        return false;
+    }
+    cvt.len = (int)length;
+    cvt.buf = (Uint8*)malloc((size_t)cvt.len * cvt.len_mult);
+    if (cvt.buf == NULL) {
+        SDL_FreeWAV(data);
+        return false;
+    }
+    memcpy(cvt.buf, data, length);
+    SDL_FreeWAV(data);
+    if (SDL_ConvertAudio(&cvt) < 0) {
+        free(cvt.buf);
+        return false;
+    }
+    sample->pcm = (float*)cvt.buf;
+    sample->frames = cvt.len_cvt / (int)(2 * sizeof(float));
+    return true;
+}
+
+// Stand-ins until there are recorded effects: short decaying tones and noise bursts
+static bool synthesiseSample(AudioSample* sample, SoundId sound) {
+    const float seconds[SOUND_COUNT] = {0.12f, 0.3f, 0.18f, 0.5f};
+    int frames = (int)(seconds[sound] * AUDIO_RATE);
+    sample->pcm = (float*)malloc((size_t)frames * 2 * sizeof(float));
+    if (sample->pcm == NULL) return false;
+    sample->frames = frames;
+
+    uint32_t noise = 0x1234567u;
+    float lowpass = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        float t = (float)i / AUDIO_RATE;
+        float fade = 1.0f - (float)i / frames;
+        float white = simRandomFloat(&noise) * 2.0f - 1.0f;
+        float value = 0.0f;
+        switch (sound) {
+        case SOUND_SHOT:
+            value = (0.6f * white + 0.4f * sinf(2.0f * AUDIO_PI * 880.0f * t)) * fade * fade;
+            break;
+        case SOUND_HIT:
+            // Falling tone
+            value = sinf(2.0f * AUDIO_PI * (220.0f - 140.0f * t / seconds[SOUND_HIT]) * t) * fade;
+            break;
+        case SOUND_PICKUP:
+            value = sinf(2.0f * AUDIO_PI * (t < seconds[SOUND_PICKUP] / 2 ? 660.0f : 990.0f) * t) * fade * 0.6f;
+            break;
+        case SOUND_EXPLOSION:
+            lowpass += 0.08f * (white - lowpass);
+            value = 2.5f * lowpass * fade * fade;
+            break;
+        default:
+            break;
+        }
+        sample->pcm[2 * i] = value;
+        sample->pcm[2 * i + 1] = value;
+    }
+    return true;
+}
+
+// Finds the format and data chunks of a RIFF WAV so the data can be read a piece at a time
+static bool openMusic(AudioEngine* a, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    Uint8 header[12];
+    Uint16 format = 0, channels = 0, bits = 0;
+    Uint32 rate = 0;
+    bool haveFormat = false;
+    if (fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return false;
+    }
+    Uint8 chunk[8];
+    while (fread(chunk, 1, 8, f) == 8) {
+        Uint32 size = chunk[4] | chunk[5] << 8 | chunk[6] << 16 | (Uint32)chunk[7] << 24;
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            Uint8 fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            format = fmt[0] | fmt[1] << 8;
+            channels = fmt[2] | fmt[3] << 8;
+            rate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | (Uint32)fmt[7] << 24;
+            bits = fmt[14] | fmt[15] << 8;
+            haveFormat = true;
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0 && haveFormat) {
+            // PCM 8/16/32-bit integer and 32-bit float, the formats SDL_AudioStream converts
+            SDL_AudioFormat source = 0;
+            if (format == 1 && bits == 8) source = AUDIO_U8;
+            else if (format == 1 && bits == 16) source = AUDIO_S16LSB;
+            else if (format == 1 && bits == 32) source = AUDIO_S32LSB;
+            else if (format == 3 && bits == 32) source = AUDIO_F32LSB;
+            if (source == 0 || channels == 0) break;
+            a->musicStream = SDL_NewAudioStream(source, (Uint8)channels, (int)rate, AUDIO_F32SYS, 2, AUDIO_RATE);
+            if (a->musicStream == NULL) break;
+            a->musicFile = f;
+            a->musicStart = ftell(f);
+            a->musicSize = (long)size;
+            a->musicRead = 0;
+            return true;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    printf("Music %s is not a WAV format the mixer streams\n", path);
+    fclose(f);
+    return false;
+}
+
+// Reads, converts and queues music until the ring is nearly full, looping the file
+static void streamMusic(AudioEngine* a) {
+    if (a->musicFile == NULL) return;
+    Uint8 raw[AUDIO_MUSIC_CHUNK];
+    float converted[AUDIO_MUSIC_CHUNK];
+    while (true) {
+        uint32_t tail = __atomic_load_n(&a->musicTail, __ATOMIC_ACQUIRE);
+        uint32_t space = AUDIO_MUSIC_RING - (a->musicHead - tail);
+        int available = SDL_AudioStreamAvailable(a->musicStream);
+        if (available > 0) {
+            // Whole stereo frames that fit the ring
+            int bytes = available < (int)sizeof(converted) ? available : (int)sizeof(converted);
+            int samples = bytes / (int)sizeof(float) & ~1;
+            if ((uint32_t)samples > space) samples = (int)space & ~1;
+            if (samples == 0) return;
+            samples = SDL_AudioStreamGet(a->musicStream, converted, samples * (int)sizeof(float)) / (int)sizeof(float);
+            if (samples <= 0) return;
+            uint32_t head = a->musicHead;
+            for (int i = 0; i < samples; i++) a->musicRing[(head + i) % AUDIO_MUSIC_RING] = converted[i];
+            a->musicHead = head + samples;
+            __atomic_store_n(&a->musicHead, a->musicHead, __ATOMIC_RELEASE);
+            continue;
+        }
+        if (space < AUDIO_MUSIC_CHUNK) return;
+        if (a->musicRead >= a->musicSize) {
+            fseek(a->musicFile, a->musicStart, SEEK_SET);
+            a->musicRead = 0;
+        }
+        long want = a->musicSize - a->musicRead < AUDIO_MUSIC_CHUNK ? a->musicSize - a->musicRead : AUDIO_MUSIC_CHUNK;
+        size_t got = fread(raw, 1, (size_t)want, a->musicFile);
+        if (got == 0) {
+            // Truncated file: start over from the top next time
+            a->musicRead = a->musicSize;
+            return;
+        }
+        a->musicRead += (long)got;
+        SDL_AudioStreamPut(a->musicStream, raw, (int)got);
+    }
+}
+
+static void startVoice(AudioEngine* a, const AudioCommand* command) {
+    const AudioSample* sample = &a->samples[command->sound];
+    if (sample->pcm == NULL) return;
+
+    // A free voice, or else the lowest priority one, the oldest among equals
+    AudioVoice* chosen = NULL;
+    for (int i = 0; i < AUDIO_MAX_VOICES; i++) {
+        AudioVoice* v = &a->voices[i];
+        if (v->sample == NULL) {
+            chosen = v;
+            break;
+        }
+        if (chosen == NULL || v->priority < chosen->priority ||
+            (v->priority == chosen->priority && (Sint32)(v->started - chosen->started) < 0)) {
+            chosen = v;
+        }
+    }
+    if (chosen->sample != NULL) {
+        if (chosen->priority > command->priority) return;
+        a->steals++;
+    }
+
+    // Equal-power pan
+    float angle = (command->pan + 1.0f) * AUDIO_PI / 4.0f;
+    chosen->sample = sample;
+    chosen->position = 0;
+    chosen->gainLeft = command->gain * cosf(angle);
+    chosen->gainRight = command->gain * sinf(angle);
+    chosen->priority = command->priority;
+    chosen->started = a->voiceCounter++;
+}
+
+static void drainCommands(AudioEngine* a) {
+    uint32_t head = __atomic_load_n(&a->commandHead, __ATOMIC_ACQUIRE);
+    uint32_t tail = a->commandTail;
+    for (; tail != head; tail++) {
+        const AudioCommand* command = &a->commands[tail % AUDIO_COMMAND_RING];
+        switch (command->type) {
+        case AUDIO_CMD_PLAY:
+            startVoice(a, command);
+            break;
+        case AUDIO_CMD_STOP_ALL:
+            for (int i = 0; i < AUDIO_MAX_VOICES; i++) a->voices[i].sample = NULL;
+            break;
+        case AUDIO_CMD_MUSIC_GAIN:
+            a->musicGain = command->gain;
+            break;
+        }
+    }
+    __atomic_store_n(&a->commandTail, tail, __ATOMIC_RELEASE);
+}
+
+// Runs on SDL's audio thread: no allocation, no locks, no I/O
+static void audioCallback(void* userData, Uint8* stream, int length) {
+    AudioEngine* a = (AudioEngine*)userData;
+    Uint64 start = SDL_GetPerformanceCounter();
+    float* out = (float*)stream;
+    int frames = length / (int)(2 * sizeof(float));
+
+    drainCommands(a);
+
+    // Music first, silence where the ring ran dry
+    uint32_t head = __atomic_load_n(&a->musicHead, __ATOMIC_ACQUIRE);
+    uint32_t tail = a->musicTail;
+    int musicSamples = (int)(head - tail) < 2 * frames ? (int)(head - tail) : 2 * frames;
+    for (int i = 0; i < musicSamples; i++) out[i] = a->musicRing[(tail + i) % AUDIO_MUSIC_RING] * a->musicGain;
+    for (int i = musicSamples; i < 2 * frames; i++) out[i] = 0.0f;
+    if (a->musicFile && musicSamples < 2 * frames) a->musicUnderruns++;
+    __atomic_store_n(&a->musicTail, tail + musicSamples, __ATOMIC_RELEASE);
+
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++) {
+        AudioVoice* voice = &a->voices[v];
+        if (voice->sample == NULL) continue;
+        const float* pcm = voice->sample->pcm + 2 * voice->position;
+        int count = voice->sample->frames - voice->position;
+        if (count > frames) count = frames;
+        for (int i = 0; i < count; i++) {
+            out[2 * i] += pcm[2 * i] * voice->gainLeft;
+            out[2 * i + 1] += pcm[2 * i + 1] * voice->gainRight;
+        }
+        voice->position += count;
+        if (voice->position >= voice->sample->frames) voice->sample = NULL;
+    }
+
+    for (int i = 0; i < 2 * frames; i++) {
+        out[i] = out[i] > 1.0f ? 1.0f : out[i] < -1.0f ? -1.0f : out[i];
+    }
+
+    float us = (float)((SDL_GetPerformanceCounter() - start) * 1e6 / SDL_GetPerformanceFrequency());
+    a->totalCallbackUs += us;
+    if (us > a->worstCallbackUs) a->worstCallbackUs = us;
+    a->callbacks++;
+}
+
+bool audioStart(AudioEngine* a) {
+    memset(a, 0, sizeof(*a));
+    a->musicGain = 0.5f;
+    for (int i = 0; i < SOUND_COUNT; i++) {
+        if (!loadSample(&a->samples[i], soundFiles[i]) && !synthesiseSample(&a->samples[i], (SoundId)i)) {
+            printf("Audio: no memory for %s\n", soundFiles[i]);
+        }
+    }
+    if (!openMusic(a, musicFile)) a->musicFile = NULL;
+    streamMusic(a);
+
+    SDL_AudioSpec want, have;
+    SDL_zero(want);
+    want.freq = AUDIO_RATE;
+    want.format = AUDIO_F32SYS;
+    want.channels = 2;
+    want.samples = AUDIO_BUFFER_FRAMES;
+    want.callback = audioCallback;
+    want.userdata = a;
+    // No allowed changes: SDL converts to whatever the hardware wants after the callback
+    a->device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    if (a->device == 0) {
+        printf("Audio: cannot open a device, playing silent: %s\n", SDL_GetError());
+        return false;
+    }
+    printf("Audio: %s driver, %d Hz, %d frame buffer%s\n", SDL_GetCurrentAudioDriver(), have.freq, have.samples,
+           a->musicFile ? ", streaming music" : "");
+    SDL_PauseAudioDevice(a->device, 0);
+    return true;
+}
+
+void audioStop(AudioEngine* a) {
+    if (a->device) SDL_CloseAudioDevice(a->device);
+    a->device = 0;
+    for (int i = 0; i < SOUND_COUNT; i++) {
+        free(a->samples[i].pcm);
+        a->samples[i].pcm = NULL;
+    }
+    if (a->musicFile) fclose(a->musicFile);
+    a->musicFile = NULL;
+    if (a->musicStream) SDL_FreeAudioStream(a->musicStream);
+    a->musicStream = NULL;
+}
+
+static void pushCommand(AudioEngine* a, const AudioCommand* command) {
+    uint32_t head = a->commandHead;
+    uint32_t tail = __atomic_load_n(&a->commandTail, __ATOMIC_ACQUIRE);
+    if (head - tail >= AUDIO_COMMAND_RING) {
+        a->commandsDropped++;
+        return;
+    }
+    a->commands[head % AUDIO_COMMAND_RING] = *command;
+    __atomic_store_n(&a->commandHead, head + 1, __ATOMIC_RELEASE);
+}
+
+void playSound(AudioEngine* a, SoundId sound, float gain, float pan, int priority) {
+    if (a->device == 0) return;
+    AudioCommand command = {AUDIO_CMD_PLAY, (uint8_t)sound, (uint8_t)priority, gain, pan};
+    pushCommand(a, &command);
+}
+
+void audioUpdate(AudioEngine* a, const SimContext* ctx) {
+    const SimEvent* event;
+    while ((event = nextSimEvent(ctx, &a->events)) != NULL) {
+        if (a->device == 0 || ctx->sim == NULL) continue;
+        // Events are in world x, the cameras in the state's
+        float x = (float)(event->x - streamOriginX(ctx->sim));
+        float pan = ctx->viewWidth > 0 ? (x - ctx->sim->cameraX) / ctx->viewWidth * 2.0f - 1.0f : 0.0f;
+        if (ctx->sim->splitScreen && ctx->viewWidth > 0) {
+            // Each player's sounds come from their own half of the screen
+            int p = event->player ? 1 : 0;
+            float across = (x - ctx->sim->splitCameraX[p]) / ctx->viewWidth;
+            across = across < 0.0f ? 0.0f : across > 1.0f ? 1.0f : across;
+            pan = p + across - 1.0f;
+        }
+        pan = pan < -1.0f ? -1.0f : pan > 1.0f ? 1.0f : pan;
+        switch (event->type) {
+        case SIM_EVENT_SHOT:
+            playSound(a, SOUND_SHOT, 0.5f, pan, 1);
+            break;
+        case SIM_EVENT_PICKUP:
+            playSound(a, SOUND_PICKUP, 0.6f, pan, 2);
+            break;
+        case SIM_EVENT_KILL:
+            playSound(a, SOUND_EXPLOSION, event->kind == 2 ? 0.9f : 0.7f, pan, 2);
+            break;
+        case SIM_EVENT_HIT:
+            playSound(a, SOUND_HIT, 0.9f, pan, 3);
+            break;
+        default:
+            break;
+        }
+    }
+    streamMusic(a);
+}
+
+void printAudioSummary(const AudioEngine* a) {
+    if (a->device == 0 || a->callbacks == 0) return;
+    printf("[audio] %u callbacks, %.1f us average, %.1f us worst, %u voices stolen, %u commands dropped, %u music underruns\n",
+           a->callbacks, a->totalCallbackUs / a->callbacks, a->worstCallbackUs, a->steals, a->commandsDropped,
+           a->musicUnderruns);
+}
+
+void runAudioTest(void) {
+    if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_TIMER) != 0) {
+        printf("SDL audio could not initialize: %s\n", SDL_GetError());
+        return;
+    }
+    AudioEngine* a = (AudioEngine*)malloc(sizeof(AudioEngine));
+    if (a && audioStart(a)) {
+        // Bursts well past the voice count, to exercise stealing
+        for (int frame = 0; frame < 180; frame++) {
+            if (frame % 15 == 0) {
+                for (int k = 0; k < 32; k++) playSound(a, (SoundId)(k % SOUND_COUNT), 0.3f, (k % 5) / 2.0f - 1.0f, k % 4);
+            }
+            streamMusic(a);
+            SDL_Delay(16);
+        }
+        SDL_Delay(200);
+        SDL_PauseAudioDevice(a->device, 1);
+        printAudioSummary(a);
+    }
+    if (a) audioStop(a);
+    free(a);
+    SDL_Quit();
+}
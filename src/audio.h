@@ -0,0 +1,100 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "init.h"
+
+// Sound effects and music on the SDL audio callback. Everything the callback
+// touches is allocated up front: effects are decoded to float PCM at load, the
+// game thread hands over play requests through a lock-free command ring and
+// tops up a ring of music PCM each frame, and the callback only reads both.
+// SDL_AUDIODRIVER=dummy or disk runs it on machines without a sound card.
+
+#define AUDIO_RATE 48000
+#define AUDIO_BUFFER_FRAMES 512         // per callback, about 11 ms
+#define AUDIO_MAX_VOICES 24
+#define AUDIO_COMMAND_RING 256          // power of two
+#define AUDIO_MUSIC_RING (1 << 17)      // interleaved stereo samples, about 1.4 s
+#define AUDIO_MUSIC_CHUNK 4096          // bytes read from the music file per top-up
+
+typedef enum {
+    SOUND_SHOT,
+    SOUND_HIT,
+    SOUND_PICKUP,
+    SOUND_EXPLOSION,
+    SOUND_COUNT
+} SoundId;
+
+// Interleaved stereo float frames at AUDIO_RATE
+typedef struct {
+    float* pcm;
+    int frames;
+} AudioSample;
+
+typedef enum {
+    AUDIO_CMD_PLAY,
+    AUDIO_CMD_STOP_ALL,
+    AUDIO_CMD_MUSIC_GAIN
+} AudioCommandType;
+
+typedef struct {
+    uint8_t type;
+    uint8_t sound;
+    uint8_t priority;       // a full pool gives up its lowest priority voice, oldest first
+    float gain;
+    float pan;              // -1 left to 1 right
+} AudioCommand;
+
+typedef struct {
+    const AudioSample* sample;  // NULL when free
+    int position;               // frames played
+    float gainLeft, gainRight;
+    int priority;
+    uint32_t started;           // start order, to steal the oldest of equal priority
+} AudioVoice;
+
+typedef struct {
+    SDL_AudioDeviceID device;
+    AudioSample samples[SOUND_COUNT];
+    SimEventCursor events;
+
+    // Game thread to callback, head stored by the game thread only, tail by the callback only
+    uint32_t commandHead;
+    uint32_t commandTail;
+    AudioCommand commands[AUDIO_COMMAND_RING];
+
+    // Callback only
+    AudioVoice voices[AUDIO_MAX_VOICES];
+    uint32_t voiceCounter;
+    float musicGain;
+
+    // Music decoded and converted on the game thread, played by the callback
+    FILE* musicFile;
+    long musicStart, musicSize, musicRead;  // data chunk of the WAV, bytes
+    SDL_AudioStream* musicStream;
+    uint32_t musicHead;
+    uint32_t musicTail;
+    float musicRing[AUDIO_MUSIC_RING];
+
+    // Counters written by the callback
+    Uint32 callbacks;
+    Uint32 steals;
+    Uint32 musicUnderruns;
+    float worstCallbackUs;
+    double totalCallbackUs;
+    // Written by the game thread
+    Uint32 commandsDropped;
+} AudioEngine;
+
+// Opens the device and decodes the effects, Assets/Audio/<name>.wav when present and
+// a synthesised stand-in otherwise. Streams Assets/Audio/music.wav when it exists.
+bool audioStart(AudioEngine* a);
+void audioStop(AudioEngine* a);
+void playSound(AudioEngine* a, SoundId sound, float gain, float pan, int priority);
+// Game thread, once per frame: plays the sounds for new gameplay events and tops up the music
+void audioUpdate(AudioEngine* a, const SimContext* ctx);
+void printAudioSummary(const AudioEngine* a);
+
+// Plays every effect over music for a few seconds and prints the callback cost
+void runAudioTest(void);
+
+#endif
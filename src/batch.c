@@ -0,0 +1,356 @@
+// Headless balance sweeps: runs many single-player episodes of one level across
+// all cores and writes per-parameter-point aggregates as CSV.
+//
+//   amsim-batch <level.json> [--sweep name=from:to:step]... [--episodes n]
+//               [--policy bot|run|random] [--seconds s] [--threads n] [--seed n] [--out file.csv]
+//
+// The CSV goes to batch.csv unless --out says otherwise, the level loader logs to stdout.
+//
+// Sweepable parameters: enemySpeed (multiplier on every enemy), health and ammo
+// (player 1 at start) and pickupShift (pixels added to every collectible and ammo x).
+
+// pthreads and clock_gettime are POSIX, hidden by -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "level.h"
+#include "bot.h"
+#include "stream.h"
+
+// Lives lost per tenth of the level, however wide it is
+#define DEATH_BUCKETS 10
+
+typedef enum {
+    PARAM_ENEMY_SPEED,
+    PARAM_HEALTH,
+    PARAM_AMMO,
+    PARAM_PICKUP_SHIFT,
+    PARAM_COUNT
+} BatchParam;
+
+static const char* paramNames[PARAM_COUNT] = {"enemySpeed", "health", "ammo", "pickupShift"};
+
+typedef struct {
+    bool swept;
+    double from, to, step;
+    int count;              // values in the range, 1 when not swept
+} SweepRange;
+
+typedef enum {
+    POLICY_BOT,             // the built-in computer player, see bot.h
+    POLICY_RUN,             // hold right, hop over what is ahead, shoot the nearest enemy
+    POLICY_RANDOM           // seeded random walk biased to the right
+} BatchPolicy;
+
+// Written by exactly one worker, read by main after all workers have joined
+typedef struct {
+    bool completed;
+    bool dead;
+    float time;
+    int score;
+    int deaths;
+    float deathXSum;
+    unsigned char deathBuckets[DEATH_BUCKETS];
+} EpisodeResult;
+
+// Everything a worker reads is set up before the threads start and never changes
+typedef struct {
+    LevelData level;
+    SweepRange ranges[PARAM_COUNT];
+    int numPoints;
+    int episodesPerPoint;
+    int totalEpisodes;
+    int maxTicks;
+    uint32_t seed;
+    BatchPolicy policy;
+    int numWorkers;
+    EpisodeResult* results;
+} BatchJob;
+
+typedef struct {
+    const BatchJob* job;
+    int index;
+    pthread_t thread;
+    long long ticks;
+} BatchWorker;
+
+static double wallSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// "name=from:to:step"
+static bool parseSweep(BatchJob* job, const char* spec) {
+    const char* eq = strchr(spec, '=');
+    if (eq == NULL) return false;
+    for (int p = 0; p < PARAM_COUNT; p++) {
+        if (strlen(paramNames[p]) != (size_t)(eq - spec) || strncmp(spec, paramNames[p], eq - spec) != 0) continue;
+        SweepRange* r = &job->ranges[p];
+        if (sscanf(eq + 1, "%lf:%lf:%lf", &r->from, &r->to, &r->step) != 3 || r->step <= 0 || r->to < r->from) return false;
+        r->swept = true;
+        r->count = (int)((r->to - r->from) / r->step + 1e-9) + 1;
+        return true;
+    }
+    return false;
+}
+
+// Parameter point index -> value of parameter p, mixed radix over the swept ranges
+static double paramValue(const BatchJob* job, int point, int p) {
+    for (int q = 0; q < p; q++) point /= job->ranges[q].count;
+    const SweepRange* r = &job->ranges[p];
+    return r->from + (point % r->count) * r->step;
+}
+
+static void applyParams(const BatchJob* job, SimContext* ctx, int point) {
+    Shooter* shooter = &ctx->shooters[0];
+    if (job->ranges[PARAM_ENEMY_SPEED].swept) {
+        float scale = (float)paramValue(job, point, PARAM_ENEMY_SPEED);
+        for (int i = 0; i < ctx->numEnemies1; i++) ctx->enemies1[i].speed *= scale;
+        for (int i = 0; i < ctx->numEnemies2; i++) ctx->enemies2[i].speed *= scale;
+    }
+    if (job->ranges[PARAM_HEALTH].swept) {
+        shooter->health = (int)paramValue(job, point, PARAM_HEALTH);
+    }
+    if (job->ranges[PARAM_AMMO].swept) {
+        // Bullet slots are fixed, more ammo than that could never be fired
+        int ammo = (int)paramValue(job, point, PARAM_AMMO);
+        shooter->ammo = ammo < SIM_MAX_BULLETS ? ammo : SIM_MAX_BULLETS;
+    }
+    if (job->ranges[PARAM_PICKUP_SHIFT].swept) {
+        float shift = (float)paramValue(job, point, PARAM_PICKUP_SHIFT);
+        for (int i = 0; i < ctx->numCollectibles; i++) ctx->collectibles[i].x += shift;
+        for (int i = 0; i < ctx->numAmmos; i++) ctx->ammos[i].x += shift;
+    }
+}
+
+static const Enemy* nearestEnemyAhead(const SimContext* ctx, const Shooter* shooter, float range) {
+    const Enemy* nearest = NULL;
+    float best = range;
+    for (int list = 0; list < 2; list++) {
+        const Enemy* enemies = list ? ctx->enemies2 : ctx->enemies1;
+        int count = list ? ctx->numEnemies2 : ctx->numEnemies1;
+        for (int i = 0; i < count; i++) {
+            float dx = enemies[i].x - shooter->x;
+            if (enemies[i].active && dx > -50.0f && dx < best) {
+                best = dx;
+                nearest = &enemies[i];
+            }
+        }
+    }
+    return nearest;
+}
+
+static SimInput policyInput(BatchPolicy policy, const SimContext* ctx, int tick, uint32_t* random) {
+    const Shooter* shooter = &ctx->shooters[0];
+    SimInput input = {0};
+
+    if (policy == POLICY_RANDOM) {
+        // New intent every quarter second
+        if (tick % 15 == 0) *random = simRandom(random) | 1;
+        uint32_t intent = *random;
+        input.buttons |= (intent % 5 == 0) ? INPUT_LEFT : INPUT_RIGHT;
+        if ((intent >> 8) % 4 == 0) input.buttons |= INPUT_JUMP;
+        if ((intent >> 16) % 3 == 0 && tick % 15 == 0) {
+            input.buttons |= INPUT_SHOOT;
+            input.aimX = (int16_t)(shooter->x + 400);
+            input.aimY = (int16_t)(shooter->y - 100 + (intent >> 24) % 200);
+        }
+        return input;
+    }
+
+    input.buttons = INPUT_RIGHT;
+    const Enemy* enemy = nearestEnemyAhead(ctx, shooter, 600.0f);
+    if (enemy && enemy->x - shooter->x < 160.0f) input.buttons |= INPUT_JUMP;
+    if (enemy && shooter->ammo > 0 && tick % 20 == 0) {
+        input.buttons |= INPUT_SHOOT;
+        input.aimX = (int16_t)(enemy->x + enemy->width / 2);
+        input.aimY = (int16_t)(enemy->y + enemy->height / 2);
+    }
+    // Hop now and then so platforms in the way do not stall the run
+    if (tick % 90 == 45) input.buttons |= INPUT_JUMP;
+    return input;
+}
+
+static int runEpisode(const BatchJob* job, SimContext* ctx, int episode, EpisodeResult* result) {
+    int point = episode / job->episodesPerPoint;
+    restoreSimState(ctx->sim, job->level.sim);
+    seedSimState(ctx->sim, job->seed + episode);
+    ctx->sim->isPlayer1Turn = true;
+    ctx->sim->versus = false;
+    applyParams(job, ctx, point);
+
+    uint32_t random = job->seed ^ (uint32_t)(episode * 2654435761u);
+    if (random == 0) random = 1;
+    Bot bot;
+    resetBot(&bot);
+    Shooter* shooter = &ctx->shooters[0];
+    int lastHealth = shooter->health;
+    double lastX = streamOriginX(ctx->sim) + shooter->x;
+    int tick = 0;
+
+    memset(result, 0, sizeof(*result));
+    while (tick < job->maxTicks) {
+        SimInput inputs[2] = {{0}, {0}};
+        inputs[0] = job->policy == POLICY_BOT ? botInput(&bot, ctx, 0) : policyInput(job->policy, ctx, tick, &random);
+        SimStatus status = sim_step(ctx, inputs);
+        tick++;
+
+        // A hit sends the shooter back to the start, so the life was lost where it stood last tick
+        if (shooter->health < lastHealth) {
+            int bucket = (int)(lastX * DEATH_BUCKETS / ctx->sim->worldWidth);
+            bucket = bucket < 0 ? 0 : bucket >= DEATH_BUCKETS ? DEATH_BUCKETS - 1 : bucket;
+            if (result->deathBuckets[bucket] < 255) result->deathBuckets[bucket]++;
+            result->deaths++;
+            result->deathXSum += lastX;
+        }
+        lastHealth = shooter->health;
+        lastX = streamOriginX(ctx->sim) + shooter->x;
+        if (status != SIM_RUNNING) break;
+    }
+
+    result->dead = shooter->dead;
+    result->completed = !shooter->dead && shooterFinished(ctx, shooter);
+    result->time = (float)shooter->time;
+    result->score = shooter->score;
+    return tick;
+}
+
+// One sim instance per worker, reset from the shared read-only level each episode
+static void* runWorker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    const BatchJob* job = worker->job;
+    SimContext* ctx = sim_create(job->level.sim, job->level.platforms, job->level.numPlatforms, job->seed);
+    if (ctx == NULL) return NULL;
+    // Streamed levels share the one chunk cache, it locks around its reads
+    if (job->level.stream) {
+        ctx->chunks = readLevelChunk;
+        ctx->chunkSource = job->level.stream;
+    }
+    for (int e = worker->index; e < job->totalEpisodes; e += job->numWorkers) {
+        worker->ticks += runEpisode(job, ctx, e, &job->results[e]);
+    }
+    sim_destroy(ctx);
+    return NULL;
+}
+
+static void writeCsv(const BatchJob* job, FILE* out) {
+    const Shooter* start = &job->level.sim->shooters[0];
+    for (int p = 0; p < PARAM_COUNT; p++) fprintf(out, "%s,", paramNames[p]);
+    fprintf(out, "episodes,completionRate,deathRate,meanTime,meanScore,livesLost,meanLifeLostX");
+    for (int b = 0; b < DEATH_BUCKETS; b++) fprintf(out, ",lost_%d", (int)(b * job->level.sim->worldWidth / DEATH_BUCKETS));
+    fprintf(out, "\n");
+
+    for (int point = 0; point < job->numPoints; point++) {
+        int completed = 0, dead = 0, lost = 0;
+        double time = 0.0, score = 0.0, lostX = 0.0;
+        int buckets[DEATH_BUCKETS] = {0};
+        for (int e = point * job->episodesPerPoint; e < (point + 1) * job->episodesPerPoint; e++) {
+            const EpisodeResult* r = &job->results[e];
+            completed += r->completed;
+            dead += r->dead;
+            time += r->time;
+            score += r->score;
+            lost += r->deaths;
+            lostX += r->deathXSum;
+            for (int b = 0; b < DEATH_BUCKETS; b++) buckets[b] += r->deathBuckets[b];
+        }
+
+        double defaults[PARAM_COUNT] = {1.0, start->health, start->ammo, 0.0};
+        for (int p = 0; p < PARAM_COUNT; p++) {
+            fprintf(out, "%g,", job->ranges[p].swept ? paramValue(job, point, p) : defaults[p]);
+        }
+        double n = job->episodesPerPoint;
+        fprintf(out, "%d,%.4f,%.4f,%.3f,%.2f,%d,%.1f", job->episodesPerPoint, completed / n, dead / n,
+                time / n, score / n, lost, lost ? lostX / lost : 0.0);
+        for (int b = 0; b < DEATH_BUCKETS; b++) fprintf(out, ",%d", buckets[b]);
+        fprintf(out, "\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <level.json> [--sweep name=from:to:step]... [--episodes n] "
+                        "[--policy bot|run|random] [--seconds s] [--threads n] [--seed n] [--out file.csv]\n", argv[0]);
+        return 1;
+    }
+
+    BatchJob job;
+    memset(&job, 0, sizeof(job));
+    for (int p = 0; p < PARAM_COUNT; p++) job.ranges[p].count = 1;
+    job.episodesPerPoint = 100;
+    job.maxTicks = 120 * SIM_TICK_RATE;
+    job.seed = 1;
+    job.policy = POLICY_BOT;
+    job.numWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char* outPath = "batch.csv";
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            if (!parseSweep(&job, argv[++i])) {
+                fprintf(stderr, "Bad sweep %s, expected name=from:to:step with name one of "
+                                "enemySpeed, health, ammo, pickupShift\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--episodes") == 0 && i + 1 < argc) job.episodesPerPoint = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) job.maxTicks = (int)(atof(argv[++i]) * SIM_TICK_RATE);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) job.numWorkers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) job.seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            i++;
+            job.policy = strcmp(argv[i], "random") == 0 ? POLICY_RANDOM :
+                         strcmp(argv[i], "run") == 0 ? POLICY_RUN : POLICY_BOT;
+        }
+    }
+    if (job.numWorkers < 1) job.numWorkers = 1;
+    if (job.episodesPerPoint < 1) job.episodesPerPoint = 1;
+
+    if (!loadLevelData(argv[1], &job.level, NULL, NULL)) return 1;
+    job.numPoints = 1;
+    for (int p = 0; p < PARAM_COUNT; p++) job.numPoints *= job.ranges[p].count;
+    job.totalEpisodes = job.numPoints * job.episodesPerPoint;
+    job.results = (EpisodeResult*)calloc(job.totalEpisodes, sizeof(EpisodeResult));
+    BatchWorker* workers = (BatchWorker*)calloc(job.numWorkers, sizeof(BatchWorker));
+    if (job.results == NULL || workers == NULL) {
+        fprintf(stderr, "Out of memory for %d episodes\n", job.totalEpisodes);
+        return 1;
+    }
+
+    double start = wallSeconds();
+    for (int w = 0; w < job.numWorkers; w++) {
+        workers[w].job = &job;
+        workers[w].index = w;
+        pthread_create(&workers[w].thread, NULL, runWorker, &workers[w]);
+    }
+    long long ticks = 0;
+    for (int w = 0; w < job.numWorkers; w++) {
+        pthread_join(workers[w].thread, NULL);
+        ticks += workers[w].ticks;
+    }
+    double elapsed = wallSeconds() - start;
+
+    FILE* out = fopen(outPath, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Failed to open %s\n", outPath);
+        return 1;
+    }
+    writeCsv(&job, out);
+    fclose(out);
+
+    double simulated = (double)ticks / SIM_TICK_RATE;
+    fprintf(stderr, "%d episodes (%d points x %d) on %d threads: %.0f simulated s in %.2f s, %.0f simulated s per wall minute, wrote %s\n",
+            job.totalEpisodes, job.numPoints, job.episodesPerPoint, job.numWorkers, simulated, elapsed,
+            elapsed > 0 ? simulated * 60.0 / elapsed : 0.0, outPath);
+
+    free(workers);
+    free(job.results);
+    free(job.level.sim);
+    free(job.level.platforms);
+    free(job.level.nav);
+    closeLevelStream(job.level.stream);
+    return 0;
+}
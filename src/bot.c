@@ -0,0 +1,192 @@
+#include "bot.h"
+#include <math.h>
+#include <string.h>
+
+// Shooter box is 100x100 with x, y at the top left (see updateShooterPosition)
+#define BOT_SHOOTER_SIZE 100.0f
+// Extra height to clear a platform edge by, jumps are frame-rate dependent
+#define BOT_CLEARANCE 16.0f
+// Highest rise a jump can land on: apex height JUMP_SPEED^2 / 2g less the clearance
+#define BOT_MAX_RISE ((float)JUMP_SPEED * JUMP_SPEED / (2.0f * GRAVITY) - BOT_CLEARANCE)
+// Hop over enemies that come this close along the run
+#define BOT_DODGE_DISTANCE 140.0f
+#define BOT_FIRE_RANGE 600.0f
+#define BOT_FIRE_INTERVAL 0.4f
+// This long without getting BOT_STUCK_DISTANCE from where it was means a wall,
+// or a plan that goes nowhere: jump, then back off
+#define BOT_STUCK_DISTANCE 10.0f
+#define BOT_STUCK_JUMP 0.3f
+#define BOT_STUCK_BACKOFF 1.2f
+#define BOT_BACKOFF_TIME 0.4f
+
+void resetBot(Bot* bot) {
+    memset(bot, 0, sizeof(*bot));
+}
+
+// Seconds from take-off until the feet have risen by height, on the way up
+static float riseTime(float height) {
+    float v = (float)JUMP_SPEED;
+    float d = v * v - 2.0f * GRAVITY * height;
+    if (d < 0.0f) d = 0.0f;
+    return (v - sqrtf(d)) / GRAVITY;
+}
+
+// Walks to the graph's next jump towards the finish, then tracks the jump's arc
+// in the air so the landing is where the graph planned it. The span and the
+// jump planned from it are kept across ticks, so the walk goes on through the
+// ticks where onGround drops out on a platform, and only a real fall off the
+// span ends it. On the finish span it is a walk to the end. False when the
+// graph has no advice: no graph, or over a gap.
+static bool followNavGraph(Bot* bot, const SimContext* ctx, const Shooter* shooter, SimInput* input) {
+    NavGraph* nav = ctx->nav;
+    float cx = shooter->x + BOT_SHOOTER_SIZE / 2;
+    float feet = shooter->y + BOT_SHOOTER_SIZE;
+    float step = SHOOTER_SPEED * ctx->deltaTime;
+
+    // A streamed level rebuilds the graph as chunks come and go, and the links with it
+    if (bot->navBuild != ctx->navBuilds) {
+        bot->link = NULL;
+        bot->next = NULL;
+    }
+    if (bot->link) {
+        bot->linkTime += ctx->deltaTime;
+        if (shooter->onGround && bot->linkTime > ctx->deltaTime) {
+            bot->link = NULL;
+        } else {
+            float t = fminf(bot->linkTime, bot->link->duration);
+            float dx = bot->link->takeoffX + bot->link->vx * t - cx;
+            input->buttons = fabsf(dx) <= step / 2 ? 0 : dx > 0 ? INPUT_RIGHT : INPUT_LEFT;
+            return true;
+        }
+    }
+    if (nav == NULL) return false;
+
+    if (shooter->onGround) {
+        bot->node = navNodeAt(nav, cx, feet);
+        bot->next = navNextLink(nav, bot->node, nav->finishNode);
+        bot->navBuild = ctx->navBuilds;
+    } else if (bot->next && (feet > nav->nodes[bot->node].y + BOT_CLEARANCE ||
+                             cx < nav->nodes[bot->node].left || cx > nav->nodes[bot->node].right)) {
+        // Dropped off the span, the plan from it no longer applies
+        bot->next = NULL;
+    }
+    const NavLink* link = bot->next;
+    if (link == NULL && shooter->onGround && bot->node >= 0 && bot->node == nav->finishNode) {
+        // On the finish span: walk it to the end rather than hop onto what is over it
+        input->buttons = cx < nav->finishX ? INPUT_RIGHT : 0;
+        return true;
+    }
+    if (link == NULL) return false;
+    float dx = link->takeoffX - cx;
+    if (fabsf(dx) > step) {
+        input->buttons = dx > 0 ? INPUT_RIGHT : INPUT_LEFT;
+    } else if (shooter->onGround) {
+        input->buttons = INPUT_JUMP;
+        bot->link = link;
+        bot->linkTime = 0.0f;
+        bot->next = NULL;
+    } else {
+        // At the takeoff: wait for the ground under the feet to jump
+        input->buttons = 0;
+    }
+    return true;
+}
+
+// Next platform along the run whose top is above the feet but within a jump:
+// something to hop onto, or a ledge to hop over before it blocks the way
+static const Platform* nextStep(const SimContext* ctx, const Shooter* shooter, float* gap, float* rise) {
+    const Platform* next = NULL;
+    float feet = shooter->y + BOT_SHOOTER_SIZE;
+    for (int i = 0; i < ctx->numPlatforms; i++) {
+        const Platform* p = &ctx->platforms[i];
+        float ahead = p->x - (shooter->x + BOT_SHOOTER_SIZE);
+        float up = feet - p->y;
+        // Behind or overhead, below the feet (walked or fallen onto), or out of reach
+        if (ahead < 0.0f || up <= 0.0f || up > BOT_MAX_RISE) continue;
+        if (next == NULL || ahead < *gap) {
+            next = p;
+            *gap = ahead;
+            *rise = up;
+        }
+    }
+    return next;
+}
+
+static bool overlapsBand(const Shooter* shooter, const Enemy* enemy) {
+    return enemy->y + enemy->height >= shooter->y && enemy->y <= shooter->y + BOT_SHOOTER_SIZE;
+}
+
+SimInput botInput(Bot* bot, const SimContext* ctx, int player) {
+    const Shooter* shooter = &ctx->shooters[player];
+    float dt = ctx->deltaTime;
+    SimInput input = {0};
+
+    // The finish line is always to the right
+    input.buttons = INPUT_RIGHT;
+
+    // Walls: without progress, try a jump, and if that fails walk back for a run-up
+    if (bot->backoffTime > 0.0f) {
+        bot->backoffTime -= dt;
+        input.buttons = INPUT_LEFT;
+    } else if (bot->link == NULL && fabsf(shooter->x - bot->lastX) < BOT_STUCK_DISTANCE) {
+        // Net progress, so pacing back and forth on the spot counts as stuck too
+        bot->stuckTime += dt;
+        if (bot->stuckTime >= BOT_STUCK_BACKOFF) {
+            bot->stuckTime = 0.0f;
+            bot->backoffTime = BOT_BACKOFF_TIME;
+            input.buttons = INPUT_LEFT;
+        } else if (bot->stuckTime >= BOT_STUCK_JUMP) {
+            input.buttons |= INPUT_JUMP;
+        }
+    } else {
+        bot->stuckTime = 0.0f;
+        bot->lastX = shooter->x;
+    }
+
+    // The nav graph plans the route; off the graph, take off early enough that
+    // the feet are above the next edge when the box reaches it
+    float gap = 0.0f, rise = 0.0f;
+    if (bot->backoffTime > 0.0f || bot->stuckTime >= BOT_STUCK_JUMP) {
+        // Unsticking overrides the plan
+        bot->link = NULL;
+        bot->next = NULL;
+    } else if (followNavGraph(bot, ctx, shooter, &input)) {
+        // Route and arc handled
+    } else if (shooter->onGround && nextStep(ctx, shooter, &gap, &rise) &&
+        gap <= SHOOTER_SPEED * riseTime(rise + BOT_CLEARANCE)) {
+        input.buttons |= INPUT_JUMP;
+    }
+
+    // Enemies: hop over close ones in the running band, shoot the nearest in range
+    const Enemy* target = NULL;
+    float targetDistance = BOT_FIRE_RANGE * BOT_FIRE_RANGE;
+    float cx = shooter->x + BOT_SHOOTER_SIZE / 2;
+    float cy = shooter->y + BOT_SHOOTER_SIZE / 2;
+    for (int list = 0; list < 2; list++) {
+        const Enemy* enemies = list ? ctx->enemies2 : ctx->enemies1;
+        int count = list ? ctx->numEnemies2 : ctx->numEnemies1;
+        for (int i = 0; i < count; i++) {
+            const Enemy* enemy = &enemies[i];
+            if (!enemy->active) continue;
+            float dx = enemy->x + enemy->width / 2 - cx;
+            float dy = enemy->y + enemy->height / 2 - cy;
+            if (shooter->onGround && dx > -BOT_SHOOTER_SIZE && dx < BOT_DODGE_DISTANCE && overlapsBand(shooter, enemy)) {
+                input.buttons |= INPUT_JUMP;
+            }
+            float distance = dx * dx + dy * dy;
+            if (distance < targetDistance) {
+                targetDistance = distance;
+                target = enemy;
+            }
+        }
+    }
+
+    bot->fireCooldown -= dt;
+    if (target && shooter->ammo > 0 && bot->fireCooldown <= 0.0f) {
+        input.buttons |= INPUT_SHOOT;
+        input.aimX = (int16_t)(target->x + target->width / 2);
+        input.aimY = (int16_t)(target->y + target->height / 2);
+        bot->fireCooldown = BOT_FIRE_INTERVAL;
+    }
+    return input;
+}
@@ -0,0 +1,25 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "sim.h"
+#include "navgraph.h"
+
+// Computer player: reads the same world the sim steps and answers with the
+// buttons and aim a person would press, so it can stand in for either player
+// in the window, in netplay or in a headless batch run.
+typedef struct {
+    float fireCooldown;     // seconds until the next shot
+    float stuckTime;        // seconds without getting far from lastX
+    float backoffTime;      // seconds left walking away from a wall before retrying
+    float lastX;            // where the shooter last made progress from
+    int node;               // nav graph span last stood on
+    const NavLink* next;    // jump planned from it, walked to until taken or off the span
+    const NavLink* link;    // nav graph jump being made, NULL on the ground
+    float linkTime;         // seconds since its takeoff
+    uint32_t navBuild;      // the context's navBuilds when they were taken, both are gone once that moves on
+} Bot;
+
+void resetBot(Bot* bot);
+SimInput botInput(Bot* bot, const SimContext* ctx, int player);
+
+#endif
@@ -0,0 +1,265 @@
+#include "decodepool.h"
+#include "level.h"
+
+static double msSince(Uint64 start) {
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Worker side of glRendererLoadPage; the SDL_Renderer path takes the same format
+static SDL_Surface* decodeImage(const char* path) {
+    SDL_Surface* loaded = IMG_Load(path);
+    if (loaded == NULL) {
+        printf("Failed to load %s! SDL_image Error: %s\n", path, IMG_GetError());
+        return NULL;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (rgba == NULL) printf("Failed to convert %s: %s\n", path, SDL_GetError());
+    return rgba;
+}
+
+static DecodeJob* nextQueued(DecodePool* p) {
+    for (int i = 0; i < DECODE_MAX_JOBS; i++) {
+        if (p->jobs[i].state == DECODE_QUEUED) return &p->jobs[i];
+    }
+    return NULL;
+}
+
+static int decodeThread(void* data) {
+    DecodePool* p = (DecodePool*)data;
+    SDL_LockMutex(p->lock);
+    while (p->running) {
+        DecodeJob* job = nextQueued(p);
+        if (job == NULL) {
+            SDL_CondWait(p->work, p->lock);
+            continue;
+        }
+        // The path is not touched by anyone else until the job is handed back
+        job->state = DECODE_DECODING;
+        SDL_UnlockMutex(p->lock);
+        SDL_Surface* surface = decodeImage(job->path);
+        SDL_LockMutex(p->lock);
+        job->surface = surface;
+        job->state = DECODE_DECODED;
+        p->decoded++;
+        SDL_CondSignal(p->done);
+    }
+    SDL_UnlockMutex(p->lock);
+    return 0;
+}
+
+bool decodePoolStart(DecodePool* p, int threads) {
+    memset(p, 0, sizeof(*p));
+    if (threads < 1) threads = 1;
+    if (threads > DECODE_MAX_THREADS) threads = DECODE_MAX_THREADS;
+
+    // SDL_image sets its PNG loader up on first use, do that here rather than racing on it
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        printf("Decode pool: PNG support is not available: %s\n", IMG_GetError());
+        return false;
+    }
+    p->lock = SDL_CreateMutex();
+    p->work = SDL_CreateCond();
+    p->done = SDL_CreateCond();
+    if (p->lock == NULL || p->work == NULL || p->done == NULL) {
+        printf("Decode pool: cannot create its lock: %s\n", SDL_GetError());
+        decodePoolStop(p);
+        return false;
+    }
+    p->running = 1;
+    for (int i = 0; i < threads; i++) {
+        SDL_Thread* thread = SDL_CreateThread(decodeThread, "decode", p);
+        if (thread == NULL) break;
+        p->threads[p->numThreads++] = thread;
+    }
+    if (p->numThreads == 0) {
+        printf("Decode pool: cannot start a decode thread: %s\n", SDL_GetError());
+        decodePoolStop(p);
+        return false;
+    }
+    return true;
+}
+
+bool decodePoolSubmit(DecodePool* p, const char* path, SDL_Texture** texture, int* page, bool* loaded) {
+    SDL_LockMutex(p->lock);
+    DecodeJob* slot = NULL;
+    for (int i = 0; i < DECODE_MAX_JOBS; i++) {
+        DecodeJob* job = &p->jobs[i];
+        if (job->state == DECODE_FREE) {
+            if (slot == NULL) slot = job;
+        } else if (job->texture == texture) {
+            SDL_UnlockMutex(p->lock);
+            return true;
+        }
+    }
+    if (slot != NULL) {
+        snprintf(slot->path, sizeof(slot->path), "%s", path);
+        slot->surface = NULL;
+        slot->texture = texture;
+        slot->page = page;
+        slot->loaded = loaded;
+        slot->state = DECODE_QUEUED;
+        SDL_CondSignal(p->work);
+    }
+    SDL_UnlockMutex(p->lock);
+    return slot != NULL;
+}
+
+// Main thread, with the job handed back: the surface becomes a texture or GL page
+static void uploadJob(DecodePool* p, GameData* g, DecodeJob* job) {
+    SDL_Texture* texture = NULL;
+    int page = -1;
+    if (job->surface != NULL) {
+        if (g->gl) {
+            page = glRendererAddSurface(g->gl, job->path, job->surface);
+        } else {
+            texture = SDL_CreateTextureFromSurface(g->renderer, job->surface);
+            if (texture == NULL) printf("Failed to create a texture for %s: %s\n", job->path, SDL_GetError());
+        }
+        SDL_FreeSurface(job->surface);
+        job->surface = NULL;
+    }
+    *job->texture = texture;
+    *job->page = page;
+    bool ok = g->gl ? page >= 0 : texture != NULL;
+    if (job->loaded) *job->loaded = ok;
+    if (ok) {
+        p->uploaded++;
+    } else {
+        p->failed++;
+    }
+}
+
+int decodePoolUpload(DecodePool* p, GameData* g, float budgetMs) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    int uploads = 0;
+    int inFlight = 0;
+    for (int i = 0; i < DECODE_MAX_JOBS; i++) {
+        DecodeJob* job = &p->jobs[i];
+        SDL_LockMutex(p->lock);
+        DecodeState state = job->state;
+        SDL_UnlockMutex(p->lock);
+        if (state == DECODE_FREE) continue;
+        if (state != DECODE_DECODED || (uploads > 0 && msSince(start) >= budgetMs)) {
+            inFlight++;
+            continue;
+        }
+        // Workers leave a decoded job alone, so it is uploaded without the lock
+        uploadJob(p, g, job);
+        uploads++;
+        SDL_LockMutex(p->lock);
+        job->state = DECODE_FREE;
+        SDL_UnlockMutex(p->lock);
+    }
+    return inFlight;
+}
+
+static bool anyDecoded(const DecodePool* p) {
+    for (int i = 0; i < DECODE_MAX_JOBS; i++) {
+        if (p->jobs[i].state == DECODE_DECODED) return true;
+    }
+    return false;
+}
+
+void decodePoolFinish(DecodePool* p, GameData* g) {
+    // Uploads overlap the decodes still running, the main thread only sleeps when
+    // nothing is ready yet
+    while (decodePoolUpload(p, g, 1e9f) > 0) {
+        SDL_LockMutex(p->lock);
+        if (!anyDecoded(p)) SDL_CondWait(p->done, p->lock);
+        SDL_UnlockMutex(p->lock);
+    }
+}
+
+void decodePoolStop(DecodePool* p) {
+    if (p->lock) {
+        SDL_LockMutex(p->lock);
+        p->running = 0;
+        if (p->work) SDL_CondBroadcast(p->work);
+        SDL_UnlockMutex(p->lock);
+    }
+    for (int i = 0; i < p->numThreads; i++) SDL_WaitThread(p->threads[i], NULL);
+    p->numThreads = 0;
+
+    // Queued jobs are dropped, decoded ones never reach their textures
+    for (int i = 0; i < DECODE_MAX_JOBS; i++) {
+        if (p->jobs[i].surface) SDL_FreeSurface(p->jobs[i].surface);
+        p->jobs[i].surface = NULL;
+        p->jobs[i].state = DECODE_FREE;
+    }
+    if (p->work) SDL_DestroyCond(p->work);
+    if (p->done) SDL_DestroyCond(p->done);
+    if (p->lock) SDL_DestroyMutex(p->lock);
+    p->work = NULL;
+    p->done = NULL;
+    p->lock = NULL;
+}
+
+typedef struct {
+    char paths[DECODE_MAX_JOBS][256];
+    int count;
+} BenchImages;
+
+static void addBenchImage(BenchImages* images, const char* path) {
+    for (int i = 0; i < images->count; i++) {
+        if (strcmp(images->paths[i], path) == 0) return;
+    }
+    if (images->count >= DECODE_MAX_JOBS) return;
+    snprintf(images->paths[images->count++], sizeof(images->paths[0]), "%s", path);
+}
+
+static int recordBenchImage(void* userData, const char* path) {
+    addBenchImage((BenchImages*)userData, path);
+    return -1;
+}
+
+void runDecodeBenchmark(GameData* g) {
+    if (g->gl) {
+        // Pages are cached by path for the renderer's lifetime, later runs would skip the uploads
+        printf("--bench-decode measures the SDL_Renderer path, run it without --gl\n");
+        return;
+    }
+    BenchImages* images = (BenchImages*)calloc(1, sizeof(BenchImages));
+    if (images == NULL) return;
+
+    // What loadMedia loads, over every level
+    addBenchImage(images, "images/background.png");
+    addBenchImage(images, "images/pause.png");
+    addBenchImage(images, "Assets/Fx/Spritesheets/player-shoot.png");
+    for (int i = 0; i < FX_SHEETS; i++) addBenchImage(images, fxSheetInfo[i].path);
+    for (int i = 0; i < g->levelCount; i++) {
+        LevelData level;
+        if (!loadLevelData(g->levelFiles[i], &level, recordBenchImage, images)) continue;
+        free(level.sim);
+        free(level.platforms);
+        free(level.nav);
+        closeLevelStream(level.stream);
+    }
+
+    SDL_Texture* textures[DECODE_MAX_JOBS];
+    int pages[DECODE_MAX_JOBS];
+    static const int threadCounts[] = {1, 4, 16};
+    // The first run is not timed, it only puts every file in the page cache so the
+    // timed runs all read from memory and differ in decoding alone
+    for (int run = -1; run < 3; run++) {
+        int threads = run < 0 ? 4 : threadCounts[run];
+        DecodePool pool;
+        if (!decodePoolStart(&pool, threads)) break;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < images->count; i++) {
+            textures[i] = NULL;
+            decodePoolSubmit(&pool, images->paths[i], &textures[i], &pages[i], NULL);
+        }
+        decodePoolFinish(&pool, g);
+        double ms = msSince(start);
+        if (run >= 0) {
+            printf("Cold load: %2d decode threads, %d images in %7.1f ms (%d failed)\n",
+                   pool.numThreads, images->count, ms, pool.failed);
+        }
+        decodePoolStop(&pool);
+        for (int i = 0; i < images->count; i++) {
+            if (textures[i]) SDL_DestroyTexture(textures[i]);
+        }
+    }
+    free(images);
+}
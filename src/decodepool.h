@@ -0,0 +1,64 @@
+#ifndef DECODEPOOL_H
+#define DECODEPOOL_H
+
+#include "init.h"
+
+#define DECODE_MAX_THREADS 16
+#define DECODE_MAX_JOBS 64
+// Main thread time given to texture uploads per frame while playing
+#define DECODE_UPLOAD_BUDGET_MS 2.0f
+
+typedef enum {
+    DECODE_FREE,
+    DECODE_QUEUED,
+    DECODE_DECODING,
+    DECODE_DECODED          // surface (or failure) waiting for the main thread
+} DecodeState;
+
+// One image on its way from disk to a texture or GL page. The destinations are
+// written on upload and must outlive the job.
+typedef struct {
+    DecodeState state;
+    char path[256];
+    SDL_Surface* surface;   // RGBA32, NULL when the decode failed
+    SDL_Texture** texture;
+    int* page;
+    bool* loaded;           // optional, set once the upload succeeded
+} DecodeJob;
+
+// PNG decoding off the main thread: workers run IMG_Load and the RGBA conversion
+// into surfaces, and the main thread, which owns the renderer and GL context,
+// turns finished surfaces into textures. loadMedia waits for its whole batch;
+// sheets met while playing (hot reload) are uploaded a few per frame under
+// DECODE_UPLOAD_BUDGET_MS.
+struct DecodePool {
+    SDL_Thread* threads[DECODE_MAX_THREADS];
+    int numThreads;
+    SDL_mutex* lock;
+    SDL_cond* work;         // signalled on submit and stop
+    SDL_cond* done;         // signalled when a decode finishes
+    DecodeJob jobs[DECODE_MAX_JOBS];
+    int running;            // cleared to stop the workers
+
+    // Since start, for the load summary
+    int decoded;
+    int uploaded;
+    int failed;
+};
+
+bool decodePoolStart(DecodePool* p, int threads);
+// Queues path for decoding into texture and page (see loadImage), returns false
+// when the queue is full. A destination already queued is not queued twice.
+bool decodePoolSubmit(DecodePool* p, const char* path, SDL_Texture** texture, int* page, bool* loaded);
+// Main thread: uploads finished surfaces until budgetMs has gone, at least one
+// when any is ready. Returns how many jobs are still in flight.
+int decodePoolUpload(DecodePool* p, GameData* g, float budgetMs);
+// Main thread: waits for every queued job and uploads it
+void decodePoolFinish(DecodePool* p, GameData* g);
+void decodePoolStop(DecodePool* p);
+
+// Cold-loads every image the levels use at 1, 4 and 16 decode threads and prints
+// the times (SDL_Renderer path), then returns
+void runDecodeBenchmark(GameData* g);
+
+#endif
@@ -0,0 +1,62 @@
+#include "eventbus.h"
+#include "stream.h"
+#include <string.h>
+
+void publishSimEvent(SimContext* ctx, SimEventType type, int player, int kind, int value, float x, float y) {
+    SimEvent* event = &ctx->events[ctx->eventsPublished % SIM_EVENT_RING];
+    event->tick = ctx->sim->tick;
+    // Readers outlive the state's origin, so they get plain world x
+    event->x = (float)(streamOriginX(ctx->sim) + x);
+    event->y = y;
+    event->value = value;
+    event->type = (uint8_t)type;
+    event->player = (uint8_t)player;
+    event->kind = (uint8_t)kind;
+    ctx->eventsPublished++;
+}
+
+void attachEventCursor(const SimContext* ctx, SimEventCursor* cursor) {
+    cursor->next = ctx->eventsPublished;
+    cursor->lost = 0;
+}
+
+const SimEvent* nextSimEvent(const SimContext* ctx, SimEventCursor* cursor) {
+    uint32_t behind = ctx->eventsPublished - cursor->next;
+    if (behind == 0) return NULL;
+    // A rollback withdrew events this reader had already seen
+    if (behind > UINT32_MAX / 2) {
+        cursor->next = ctx->eventsPublished;
+        return NULL;
+    }
+    if (behind > SIM_EVENT_RING) {
+        cursor->lost += behind - SIM_EVENT_RING;
+        cursor->next = ctx->eventsPublished - SIM_EVENT_RING;
+    }
+    return &ctx->events[cursor->next++ % SIM_EVENT_RING];
+}
+
+void initEventQueue(SimEventQueue* queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+bool pushEventQueue(SimEventQueue* queue, const SimEvent* event) {
+    uint32_t head = queue->head;
+    if (head - queue->tailSeen >= SIM_EVENT_QUEUE_SIZE) {
+        queue->tailSeen = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        if (head - queue->tailSeen >= SIM_EVENT_QUEUE_SIZE) return false;
+    }
+    queue->slots[head % SIM_EVENT_QUEUE_SIZE] = *event;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool popEventQueue(SimEventQueue* queue, SimEvent* event) {
+    uint32_t tail = queue->tail;
+    if (queue->headSeen == tail) {
+        queue->headSeen = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (queue->headSeen == tail) return false;
+    }
+    *event = queue->slots[tail % SIM_EVENT_QUEUE_SIZE];
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
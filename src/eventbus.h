@@ -0,0 +1,42 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include "sim.h"
+
+// The step publishes into the context's ring and never waits for anyone. Each
+// reader keeps its own cursor, so adding one costs the sim nothing and readers
+// never touch the state. Readers on other threads get events handed over
+// through a SimEventQueue from the thread that steps the sim.
+
+typedef struct {
+    uint32_t next;          // count of events published before the next one to read
+    uint32_t lost;          // overwritten before this reader got to them
+} SimEventCursor;
+
+void publishSimEvent(SimContext* ctx, SimEventType type, int player, int kind, int value, float x, float y);
+// Starts a reader at the next event to be published
+void attachEventCursor(const SimContext* ctx, SimEventCursor* cursor);
+// Next unread event, NULL when the reader has caught up. Valid until the ring wraps.
+const SimEvent* nextSimEvent(const SimContext* ctx, SimEventCursor* cursor);
+
+// Single-producer single-consumer ring, lock-free: each index is written by one
+// side only and published with release/acquire ordering. Size is a power of two.
+#define SIM_EVENT_QUEUE_SIZE 4096
+
+typedef struct {
+    uint32_t head;          // next slot to write, stored by the producer only
+    uint32_t tailSeen;      // producer's last look at tail, reloaded only when the queue seems full
+    uint8_t padHead[56];    // keep the two sides on separate cache lines
+    uint32_t tail;          // next slot to read, stored by the consumer only
+    uint32_t headSeen;      // consumer's last look at head, reloaded only when the queue seems empty
+    uint8_t padTail[56];
+    SimEvent slots[SIM_EVENT_QUEUE_SIZE];
+} SimEventQueue;
+
+void initEventQueue(SimEventQueue* queue);
+// False when the queue is full, the event is not queued
+bool pushEventQueue(SimEventQueue* queue, const SimEvent* event);
+// False when the queue is empty
+bool popEventQueue(SimEventQueue* queue, SimEvent* event);
+
+#endif
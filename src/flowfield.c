@@ -0,0 +1,117 @@
+#include "flowfield.h"
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Neighbour steps, orthogonal first so ties go straight rather than diagonal
+static const int stepX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int stepY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+static const float unitX[8] = {1.0f, -1.0f, 0.0f, 0.0f, 0.70710678f, 0.70710678f, -0.70710678f, -0.70710678f};
+static const float unitY[8] = {0.0f, 0.0f, 1.0f, -1.0f, 0.70710678f, -0.70710678f, 0.70710678f, -0.70710678f};
+
+static int clampIndex(int value, int count) {
+    return value < 0 ? 0 : value >= count ? count - 1 : value;
+}
+
+// Anything off the grid samples the nearest edge cell
+static int cellAt(float originX, float x, float y) {
+    x -= originX;
+    int col = clampIndex(x < 0.0f ? -1 : (int)(x / FLOW_CELL_SIZE), FLOW_COLS);
+    int row = clampIndex(y < 0.0f ? -1 : (int)(y / FLOW_CELL_SIZE), FLOW_ROWS);
+    return row * FLOW_COLS + col;
+}
+
+static void markPlatforms(const SimContext* ctx, FlowField* field) {
+    memset(field->blocked, 0, sizeof(field->blocked));
+    for (int i = 0; i < ctx->numPlatforms; i++) {
+        const Platform* p = &ctx->platforms[i];
+        float x = p->x - field->originX;
+        // Parked slot of a streamed level, or a chunk outside the grid
+        if (p->width <= 0.0f || x + p->width <= 0.0f) continue;
+        int col0 = clampIndex((int)(x / FLOW_CELL_SIZE), FLOW_COLS);
+        int col1 = clampIndex((int)((x + p->width - 1) / FLOW_CELL_SIZE), FLOW_COLS);
+        int row0 = clampIndex((int)(p->y / FLOW_CELL_SIZE), FLOW_ROWS);
+        int row1 = clampIndex((int)((p->y + p->height - 1) / FLOW_CELL_SIZE), FLOW_ROWS);
+        for (int row = row0; row <= row1; row++) {
+            memset(&field->blocked[row * FLOW_COLS + col0], 1, col1 - col0 + 1);
+        }
+    }
+}
+
+// Breadth-first distances out from the target around the platforms, then every
+// open cell points at its nearest neighbour. Diagonals need both cells beside
+// them open so the flyers do not cut through platform corners.
+static void buildFlowField(const SimContext* ctx, FlowField* field, int target) {
+    uint16_t queue[FLOW_CELLS];
+    int head = 0, tail = 0;
+
+    markPlatforms(ctx, field);
+    for (int c = 0; c < FLOW_CELLS; c++) field->distance[c] = FLOW_UNREACHABLE;
+    field->distance[target] = 0;
+    queue[tail++] = (uint16_t)target;
+    while (head < tail) {
+        int c = queue[head++];
+        int col = c % FLOW_COLS, row = c / FLOW_COLS;
+        for (int k = 0; k < 4; k++) {
+            int ncol = col + stepX[k], nrow = row + stepY[k];
+            if (ncol < 0 || ncol >= FLOW_COLS || nrow < 0 || nrow >= FLOW_ROWS) continue;
+            int n = nrow * FLOW_COLS + ncol;
+            if (field->blocked[n] || field->distance[n] != FLOW_UNREACHABLE) continue;
+            field->distance[n] = field->distance[c] + 1;
+            queue[tail++] = (uint16_t)n;
+        }
+    }
+
+    for (int c = 0; c < FLOW_CELLS; c++) {
+        int col = c % FLOW_COLS, row = c / FLOW_COLS;
+        int best = field->distance[c];
+        int direction = FLOW_DIRECT;
+        if (c != target && best != FLOW_UNREACHABLE) {
+            for (int k = 0; k < 8; k++) {
+                int ncol = col + stepX[k], nrow = row + stepY[k];
+                if (ncol < 0 || ncol >= FLOW_COLS || nrow < 0 || nrow >= FLOW_ROWS) continue;
+                if (k >= 4 && (field->blocked[row * FLOW_COLS + ncol] || field->blocked[nrow * FLOW_COLS + col])) continue;
+                int n = nrow * FLOW_COLS + ncol;
+                if (field->distance[n] < best) {
+                    best = field->distance[n];
+                    direction = k;
+                }
+            }
+        }
+        field->direction[c] = (uint8_t)direction;
+    }
+    field->targetCell = target;
+}
+
+void invalidateFlowFields(SimContext* ctx) {
+    if (ctx->flow == NULL) return;
+    ctx->flow[0].targetCell = -1;
+    ctx->flow[1].targetCell = -1;
+}
+
+const FlowField* updateFlowField(SimContext* ctx, int shooterIndex) {
+    if (ctx->flow == NULL) {
+        ctx->flow = (FlowField*)calloc(2, sizeof(FlowField));
+        if (ctx->flow == NULL) return NULL;
+        invalidateFlowFields(ctx);
+    }
+    // The grid starts at the left of the resident chunks, at 0 for a whole level
+    float originX, right;
+    streamWindow(ctx, &originX, &right);
+    const Shooter* shooter = &ctx->shooters[shooterIndex];
+    int target = cellAt(originX, shooter->x + shooter->width / 2, shooter->y + shooter->height / 2);
+    FlowField* field = &ctx->flow[shooterIndex];
+    if (field->targetCell != target || field->originX != originX) {
+        field->originX = originX;
+        buildFlowField(ctx, field, target);
+    }
+    return field;
+}
+
+bool sampleFlowField(const FlowField* field, float x, float y, float* dirX, float* dirY) {
+    int direction = field->direction[cellAt(field->originX, x, y)];
+    if (direction == FLOW_DIRECT) return false;
+    *dirX = unitX[direction];
+    *dirY = unitY[direction];
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "sim.h"
+
+#define FLOW_UNREACHABLE 0xFFFF
+// Direction value for the target cell and cells with no way out: steer straight at the shooter
+#define FLOW_DIRECT 8
+
+// Marks the fields stale, call whenever the platforms change
+void invalidateFlowFields(SimContext* ctx);
+// Rebuilds the field towards a shooter if it has moved to another cell since the last build.
+// Returns NULL only when the fields cannot be allocated.
+const FlowField* updateFlowField(SimContext* ctx, int shooterIndex);
+// Unit step along the field from a point; false when the caller should steer straight instead
+bool sampleFlowField(const FlowField* field, float x, float y, float* dirX, float* dirY);
+
+#endif
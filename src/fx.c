@@ -0,0 +1,134 @@
+#include "fx.h"
+#include "stream.h"
+#include <math.h>
+#include <string.h>
+
+#define FX_PI 3.14159265358979323846f
+
+const FxSheetInfo fxSheetInfo[FX_SHEETS] = {
+    {"Assets/Fx/Spritesheets/explosion.png", 32, 32, 4},
+    {"Assets/Fx/Spritesheets/big-explosion.png", 64, 64, 9},
+    {"Assets/Fx/Spritesheets/player-shoot-hit.png", 16, 16, 4},
+    {"Assets/Fx/Spritesheets/pick-feedback.png", 16, 24, 7},
+    {"Assets/Fx/Spritesheets/pick-feedback-2.png", 16, 16, 5},
+};
+
+// Sparks thrown out of a kill or a hit: speed in pixels per second, pulled down like the shooters
+#define FX_SPARK_SPEED_MIN 150.0f
+#define FX_SPARK_SPEED_MAX 420.0f
+#define FX_SPARK_GRAVITY 900.0f
+
+void resetFx(FxPool* fx) {
+    fx->count = 0;
+    fx->peak = 0;
+    fx->dropped = 0;
+    fx->random = 0x9E3779B9u;
+    fx->originX = 0.0;
+    fx->events.next = 0;
+    fx->events.lost = 0;
+}
+
+static void spawn(FxPool* fx, FxSheet sheet, float x, float y, float vx, float vy, float gravity, float life, float scale) {
+    if (fx->count >= FX_MAX_PARTICLES) {
+        fx->dropped++;
+        return;
+    }
+    int i = fx->count++;
+    fx->x[i] = x;
+    fx->y[i] = y;
+    fx->vx[i] = vx;
+    fx->vy[i] = vy;
+    fx->gravity[i] = gravity;
+    fx->age[i] = 0.0f;
+    fx->life[i] = life;
+    fx->scale[i] = scale;
+    fx->sheet[i] = (uint8_t)sheet;
+    if (fx->count > fx->peak) fx->peak = fx->count;
+}
+
+static void spawnSparks(FxPool* fx, float x, float y, int count) {
+    for (int k = 0; k < count; k++) {
+        float angle = simRandomFloat(&fx->random) * 2.0f * FX_PI;
+        float speed = FX_SPARK_SPEED_MIN + simRandomFloat(&fx->random) * (FX_SPARK_SPEED_MAX - FX_SPARK_SPEED_MIN);
+        float life = 0.35f + simRandomFloat(&fx->random) * 0.3f;
+        spawn(fx, FX_SHOOT_HIT, x, y, cosf(angle) * speed, sinf(angle) * speed, FX_SPARK_GRAVITY, life, 1.5f);
+    }
+}
+
+void playSimEvents(FxPool* fx, const SimContext* ctx) {
+    // Particles move with the rest of the world when a streamed level rebases
+    double origin = streamOriginX(ctx->sim);
+    if (origin != fx->originX) {
+        float shift = (float)(fx->originX - origin);
+        for (int i = 0; i < fx->count; i++) fx->x[i] += shift;
+        fx->originX = origin;
+    }
+    const SimEvent* event;
+    while ((event = nextSimEvent(ctx, &fx->events)) != NULL) {
+        float x = (float)(event->x - origin);
+        switch (event->type) {
+        case SIM_EVENT_KILL:
+            if (event->kind == 2) {
+                spawn(fx, FX_BIG_EXPLOSION, x, event->y, 0.0f, 0.0f, 0.0f, 0.6f, 2.0f);
+                spawnSparks(fx, x, event->y, 24);
+            } else {
+                spawn(fx, FX_EXPLOSION, x, event->y, 0.0f, 0.0f, 0.0f, 0.4f, 3.0f);
+                spawnSparks(fx, x, event->y, 12);
+            }
+            break;
+        case SIM_EVENT_HIT:
+            spawn(fx, FX_SHOOT_HIT, x, event->y, 0.0f, 0.0f, 0.0f, 0.3f, 5.0f);
+            spawnSparks(fx, x, event->y, 8);
+            break;
+        case SIM_EVENT_PICKUP:
+            // Drifts up off the spot it was picked from
+            spawn(fx, event->kind ? FX_PICK_FEEDBACK_2 : FX_PICK_FEEDBACK, x, event->y,
+                  0.0f, -40.0f, 0.0f, 0.5f, 3.0f);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Integrates every live particle in one branch-free pass over the arrays, which
+// the compiler vectorises, then swaps the expired ones out from the back
+void updateFx(FxPool* fx, float dt) {
+    int count = fx->count;
+    float* restrict x = fx->x;
+    float* restrict y = fx->y;
+    float* restrict vx = fx->vx;
+    float* restrict vy = fx->vy;
+    const float* restrict gravity = fx->gravity;
+    float* restrict age = fx->age;
+    for (int i = 0; i < count; i++) {
+        vy[i] += gravity[i] * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+
+    for (int i = 0; i < count; ) {
+        if (age[i] < fx->life[i]) {
+            i++;
+            continue;
+        }
+        int last = --count;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        fx->gravity[i] = gravity[last];
+        age[i] = age[last];
+        fx->life[i] = fx->life[last];
+        fx->scale[i] = fx->scale[last];
+        fx->sheet[i] = fx->sheet[last];
+    }
+    fx->count = count;
+}
+
+int fxFrame(const FxPool* fx, int i) {
+    int frames = fxSheetInfo[fx->sheet[i]].frames;
+    int frame = (int)(fx->age[i] / fx->life[i] * frames);
+    return frame < frames ? frame : frames - 1;
+}
@@ -0,0 +1,57 @@
+#ifndef FX_H
+#define FX_H
+
+#include "eventbus.h"
+
+// Particle effects for kills, hits and pickups, played from the Assets/Fx sheets.
+// Purely cosmetic: a reader on the sim's event bus, never read back by the sim.
+
+#define FX_MAX_PARTICLES 8192
+
+typedef enum {
+    FX_EXPLOSION,
+    FX_BIG_EXPLOSION,
+    FX_SHOOT_HIT,
+    FX_PICK_FEEDBACK,
+    FX_PICK_FEEDBACK_2,
+    FX_SHEETS
+} FxSheet;
+
+// One horizontal strip of equally sized frames
+typedef struct {
+    const char* path;
+    int frameWidth, frameHeight;
+    int frames;
+} FxSheetInfo;
+
+extern const FxSheetInfo fxSheetInfo[FX_SHEETS];
+
+// Fixed-capacity pool, one array per field so the integration loop runs over
+// plain float streams. Live particles are packed at the front; spawning writes
+// the next slot and expiry swaps the last one in, so nothing is ever allocated.
+typedef struct {
+    int count;
+    int peak;
+    int dropped;            // spawns refused because the pool was full
+    uint32_t random;        // spread of the sparks, separate from the sim's PRNG
+    SimEventCursor events;
+    double originX;                     // world x of x = 0, kept at the sim's origin (see streamOriginX)
+    float x[FX_MAX_PARTICLES];          // position of the centre, in the sim's coordinates
+    float y[FX_MAX_PARTICLES];
+    float vx[FX_MAX_PARTICLES];
+    float vy[FX_MAX_PARTICLES];
+    float gravity[FX_MAX_PARTICLES];
+    float age[FX_MAX_PARTICLES];        // seconds since spawn
+    float life[FX_MAX_PARTICLES];       // seconds to play every frame of the sheet once
+    float scale[FX_MAX_PARTICLES];      // drawn size over the frame size
+    uint8_t sheet[FX_MAX_PARTICLES];
+} FxPool;
+
+void resetFx(FxPool* fx);
+// Spawns the effects for the events published since the last call
+void playSimEvents(FxPool* fx, const SimContext* ctx);
+void updateFx(FxPool* fx, float dt);
+// Frame of its sheet particle i shows at its current age
+int fxFrame(const FxPool* fx, int i);
+
+#endif
@@ -0,0 +1,395 @@
+#include "glrender.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+// Unit quad expanded per instance: dst rect in pixels -> clip space, src rect -> uv
+static const char* vertexShaderSource =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 Corner;\n"
+    "layout(location = 1) in vec4 DstRect;\n"
+    "layout(location = 2) in vec4 SrcRect;\n"
+    "layout(location = 3) in vec4 Tint;\n"
+    "layout(location = 4) in float Depth;\n"
+    "uniform vec2 ScreenSize;\n"
+    "uniform vec2 ViewOffset;\n"
+    "out vec2 Frag_UV;\n"
+    "out vec4 Frag_Color;\n"
+    "void main() {\n"
+    "    vec2 pos = DstRect.xy + Corner * DstRect.zw - ViewOffset;\n"
+    "    vec2 ndc = vec2(pos.x / ScreenSize.x * 2.0 - 1.0, 1.0 - pos.y / ScreenSize.y * 2.0);\n"
+    "    Frag_UV = mix(SrcRect.xy, SrcRect.zw, Corner);\n"
+    "    Frag_Color = Tint;\n"
+    "    gl_Position = vec4(ndc, Depth, 1.0);\n"
+    "}\n";
+
+// Alpha-tested at AlphaCutoff: 0.5 in the opaque pass, whose sprites only have
+// clear and solid texels, so the depth buffer can restore draw order between
+// pages; just above zero in the blended pass, which skips the clear texels
+static const char* fragmentShaderSource =
+    "#version 330 core\n"
+    "in vec2 Frag_UV;\n"
+    "in vec4 Frag_Color;\n"
+    "uniform sampler2D Texture;\n"
+    "uniform float AlphaCutoff;\n"
+    "out vec4 Out_Color;\n"
+    "void main() {\n"
+    "    vec4 color = Frag_Color * texture(Texture, Frag_UV);\n"
+    "    if (color.a < AlphaCutoff) discard;\n"
+    "    Out_Color = color;\n"
+    "}\n";
+
+static GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("Failed to compile sprite shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static int addPage(GLRenderer* r, const char* path, const void* pixels, int width, int height) {
+    if (r->numPages >= GL_MAX_PAGES) {
+        printf("Too many atlas pages, cannot load %s\n", path);
+        return -1;
+    }
+
+    AtlasPage* page = &r->pages[r->numPages];
+    snprintf(page->path, sizeof(page->path), "%s", path);
+    page->width = width;
+    page->height = height;
+    page->translucent = false;
+    const Uint8* texels = (const Uint8*)pixels;
+    for (int i = 0; i < width * height && !page->translucent; i++) {
+        Uint8 alpha = texels[i * 4 + 3];
+        page->translucent = alpha > 0 && alpha < 255;
+    }
+
+    glGenTextures(1, &page->texture);
+    glBindTexture(GL_TEXTURE_2D, page->texture);
+    // Pixel art is stretched 32 -> 100 px, keep it sharp
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    return r->numPages++;
+}
+
+static bool reserveInstances(GLRenderer* r, int needed) {
+    if (needed <= r->capacity) return true;
+
+    int capacity = r->capacity > 0 ? r->capacity : GL_INITIAL_INSTANCES;
+    while (capacity < needed) capacity *= 2;
+
+    SpriteInstance* instances = realloc(r->instances, capacity * sizeof(SpriteInstance));
+    Uint8* pages = realloc(r->instancePages, capacity * sizeof(Uint8));
+    SpriteInstance* sorted = realloc(r->sorted, capacity * sizeof(SpriteInstance));
+    Uint8* sortedPages = realloc(r->sortedPages, capacity * sizeof(Uint8));
+    if (instances) r->instances = instances;
+    if (pages) r->instancePages = pages;
+    if (sorted) r->sorted = sorted;
+    if (sortedPages) r->sortedPages = sortedPages;
+    if (!instances || !pages || !sorted || !sortedPages) return false;
+
+    r->capacity = capacity;
+    return true;
+}
+
+bool glRendererInit(GLRenderer* r) {
+    memset(r, 0, sizeof(*r));
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    if (!vertexShader || !fragmentShader) return false;
+
+    r->program = glCreateProgram();
+    glAttachShader(r->program, vertexShader);
+    glAttachShader(r->program, fragmentShader);
+    glLinkProgram(r->program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint status = 0;
+    glGetProgramiv(r->program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        char log[1024];
+        glGetProgramInfoLog(r->program, sizeof(log), NULL, log);
+        printf("Failed to link sprite shader: %s\n", log);
+        return false;
+    }
+    r->projLoc = glGetUniformLocation(r->program, "ScreenSize");
+    r->offsetLoc = glGetUniformLocation(r->program, "ViewOffset");
+    r->texLoc = glGetUniformLocation(r->program, "Texture");
+    r->cutoffLoc = glGetUniformLocation(r->program, "AlphaCutoff");
+
+    static const float corners[8] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+
+    glGenVertexArrays(1, &r->vao);
+    glBindVertexArray(r->vao);
+
+    glGenBuffers(1, &r->quadVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, r->quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glGenBuffers(1, &r->instanceVbo);
+    for (GLuint i = 1; i <= 4; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+    glBindVertexArray(0);
+
+    // 1x1 white page for untextured rectangles (terrain, platforms, pickups, hearts)
+    const Uint8 white[4] = {255, 255, 255, 255};
+    r->whitePage = addPage(r, "<white>", white, 1, 1);
+
+    if (!reserveInstances(r, GL_INITIAL_INSTANCES)) {
+        printf("Failed to allocate sprite instances\n");
+        return false;
+    }
+    return true;
+}
+
+void glRendererDestroy(GLRenderer* r) {
+    for (int i = 0; i < r->numPages; i++) {
+        glDeleteTextures(1, &r->pages[i].texture);
+    }
+    glDeleteBuffers(1, &r->instanceVbo);
+    glDeleteBuffers(1, &r->quadVbo);
+    glDeleteVertexArrays(1, &r->vao);
+    glDeleteProgram(r->program);
+    free(r->instances);
+    free(r->instancePages);
+    free(r->sorted);
+    free(r->sortedPages);
+    memset(r, 0, sizeof(*r));
+}
+
+int glRendererFindPage(const GLRenderer* r, const char* path) {
+    for (int i = 0; i < r->numPages; i++) {
+        if (strcmp(r->pages[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+int glRendererAddSurface(GLRenderer* r, const char* path, const SDL_Surface* rgba) {
+    int page = glRendererFindPage(r, path);
+    if (page >= 0) return page;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return addPage(r, path, rgba->pixels, rgba->w, rgba->h);
+}
+
+// Loads a spritesheet once, later calls with the same path return the cached page
+int glRendererLoadPage(GLRenderer* r, const char* path) {
+    int page = glRendererFindPage(r, path);
+    if (page >= 0) return page;
+
+    SDL_Surface* loaded = IMG_Load(path);
+    if (loaded == NULL) {
+        printf("Failed to load %s! SDL_image Error: %s\n", path, IMG_GetError());
+        return -1;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (rgba == NULL) {
+        printf("Failed to convert %s: %s\n", path, SDL_GetError());
+        return -1;
+    }
+
+    page = glRendererAddSurface(r, path, rgba);
+    SDL_FreeSurface(rgba);
+    return page;
+}
+
+void glRendererBegin(GLRenderer* r, int screen_width, int screen_height) {
+    r->numInstances = 0;
+    r->screenWidth = screen_width;
+    r->screenHeight = screen_height;
+}
+
+static SpriteInstance* pushInstance(GLRenderer* r, int page) {
+    if (page < 0 || page >= r->numPages) return NULL;
+    if (!reserveInstances(r, r->numInstances + 1)) return NULL;
+
+    SpriteInstance* inst = &r->instances[r->numInstances];
+    r->instancePages[r->numInstances] = (Uint8)page;
+    r->numInstances++;
+    return inst;
+}
+
+void glRendererSprite(GLRenderer* r, int page, const SDL_Rect* src, const SDL_Rect* dst, SDL_Color tint) {
+    SpriteInstance* inst = pushInstance(r, page);
+    if (inst == NULL) return;
+
+    AtlasPage* p = &r->pages[page];
+    inst->x = (float)dst->x;
+    inst->y = (float)dst->y;
+    inst->w = (float)dst->w;
+    inst->h = (float)dst->h;
+    if (src) {
+        inst->u0 = (float)src->x / p->width;
+        inst->v0 = (float)src->y / p->height;
+        inst->u1 = (float)(src->x + src->w) / p->width;
+        inst->v1 = (float)(src->y + src->h) / p->height;
+    } else {
+        inst->u0 = inst->v0 = 0.0f;
+        inst->u1 = inst->v1 = 1.0f;
+    }
+    inst->r = tint.r;
+    inst->g = tint.g;
+    inst->b = tint.b;
+    inst->a = tint.a;
+}
+
+void glRendererFill(GLRenderer* r, const SDL_Rect* dst, SDL_Color color) {
+    SpriteInstance* inst = pushInstance(r, r->whitePage);
+    if (inst == NULL) return;
+
+    inst->x = (float)dst->x;
+    inst->y = (float)dst->y;
+    inst->w = (float)dst->w;
+    inst->h = (float)dst->h;
+    inst->u0 = inst->v0 = 0.0f;
+    inst->u1 = inst->v1 = 1.0f;
+    inst->r = color.r;
+    inst->g = color.g;
+    inst->b = color.b;
+    inst->a = color.a;
+}
+
+// Opaque sprites are grouped by page and drawn with one glDrawArraysInstanced per
+// page that has anything on it; translucent ones (a tint below 255 or a page with
+// soft edges) follow, blended back to front
+void glRendererFlush(GLRenderer* r) {
+    GLView view = {{0, 0, r->screenWidth, r->screenHeight}, 0.0f};
+    glRendererFlushViews(r, &view, 1);
+}
+
+static void pointInstances(int first) {
+    // No base instance in GL 3.3, point the per-instance attributes at the run instead
+    size_t base = (size_t)first * sizeof(SpriteInstance);
+    GLsizei stride = sizeof(SpriteInstance);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SpriteInstance, x)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SpriteInstance, u0)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(SpriteInstance, r)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SpriteInstance, depth)));
+}
+
+static bool isTranslucent(const GLRenderer* r, const SpriteInstance* inst, int page) {
+    return inst->a < 255 || r->pages[page].translucent;
+}
+
+// The sort and upload happen once however many views draw the batch; each view
+// replays the same draws through its own viewport, scissor and offset
+void glRendererFlushViews(GLRenderer* r, const GLView* views, int numViews) {
+    r->drawCalls = 0;
+    r->lastInstanceCount = r->numInstances;
+    if (r->numInstances == 0) return;
+
+    // Counting sort of the opaque sprites by page, the translucent ones keep
+    // submission order after them. Depth is the submission order either way, so
+    // later sprites win over earlier ones on any page and in either pass.
+    memset(r->pageCounts, 0, sizeof(r->pageCounts));
+    r->numOpaque = 0;
+    for (int i = 0; i < r->numInstances; i++) {
+        int page = r->instancePages[i];
+        if (isTranslucent(r, &r->instances[i], page)) continue;
+        r->pageCounts[page]++;
+        r->numOpaque++;
+    }
+    int offsets[GL_MAX_PAGES];
+    int running = 0;
+    for (int p = 0; p < r->numPages; p++) {
+        offsets[p] = running;
+        running += r->pageCounts[p];
+    }
+    int cursor[GL_MAX_PAGES];
+    memcpy(cursor, offsets, sizeof(cursor));
+    int translucent = r->numOpaque;
+    for (int i = 0; i < r->numInstances; i++) {
+        SpriteInstance inst = r->instances[i];
+        int page = r->instancePages[i];
+        inst.depth = 1.0f - 2.0f * (float)(i + 1) / (float)(r->numInstances + 1);
+        int slot = isTranslucent(r, &inst, page) ? translucent++ : cursor[page]++;
+        r->sorted[slot] = inst;
+        r->sortedPages[slot] = (Uint8)page;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+
+    glUseProgram(r->program);
+    glUniform1i(r->texLoc, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(r->vao);
+
+    // Orphan and refill the instance buffer
+    glBindBuffer(GL_ARRAY_BUFFER, r->instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)r->capacity * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)r->numInstances * sizeof(SpriteInstance), r->sorted);
+
+    for (int v = 0; v < numViews; v++) {
+        // Views are in window pixels from the top left, GL counts from the bottom
+        const SDL_Rect* rect = &views[v].viewport;
+        int bottom = r->screenHeight - rect->y - rect->h;
+        glViewport(rect->x, bottom, rect->w, rect->h);
+        if (numViews > 1) {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(rect->x, bottom, rect->w, rect->h);
+        } else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        glUniform2f(r->projLoc, (float)rect->w, (float)rect->h);
+        glUniform2f(r->offsetLoc, views[v].offsetX, 0.0f);
+
+        // Opaque pass: any order, the depth buffer sorts it out
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+        glUniform1f(r->cutoffLoc, 0.5f);
+        for (int p = 0; p < r->numPages; p++) {
+            if (r->pageCounts[p] == 0) continue;
+            pointInstances(offsets[p]);
+            glBindTexture(GL_TEXTURE_2D, r->pages[p].texture);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, r->pageCounts[p]);
+            r->drawCalls++;
+        }
+
+        // Blended pass back to front, one draw per run of a page. Tested against the
+        // opaque depths so sprites submitted later still cover these, never written.
+        glEnable(GL_BLEND);
+        glDepthMask(GL_FALSE);
+        glUniform1f(r->cutoffLoc, 1.0f / 255.0f);
+        for (int first = r->numOpaque; first < r->numInstances; ) {
+            int end = first + 1;
+            while (end < r->numInstances && r->sortedPages[end] == r->sortedPages[first]) end++;
+            pointInstances(first);
+            glBindTexture(GL_TEXTURE_2D, r->pages[r->sortedPages[first]].texture);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, end - first);
+            r->drawCalls++;
+            first = end;
+        }
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glViewport(0, 0, r->screenWidth, r->screenHeight);
+}
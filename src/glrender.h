@@ -0,0 +1,74 @@
+#ifndef GLRENDER_H
+#define GLRENDER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "GL/gl3w.h"
+
+#define GL_MAX_PAGES 32
+#define GL_INITIAL_INSTANCES 8192
+
+// One sprite as uploaded to the instance buffer
+typedef struct {
+    float x, y, w, h;       // destination rect in window pixels
+    float u0, v0, u1, v1;   // source rect in normalised texture coordinates
+    Uint8 r, g, b, a;       // tint, multiplied with the texel
+    float depth;            // submission order, keeps painter's order across pages
+} SpriteInstance;
+
+// A texture that sprites are cut from, one instanced draw call each
+typedef struct {
+    char path[256];
+    GLuint texture;
+    int width, height;
+    bool translucent;       // has texels between clear and opaque (soft edges, glows)
+} AtlasPage;
+
+typedef struct GLRenderer {
+    GLuint program;
+    GLuint vao;
+    GLuint quadVbo;
+    GLuint instanceVbo;
+    GLint projLoc;
+    GLint offsetLoc;
+    GLint texLoc;
+    GLint cutoffLoc;
+
+    AtlasPage pages[GL_MAX_PAGES];
+    int numPages;
+    int whitePage;
+
+    SpriteInstance* instances;  // in submission order
+    Uint8* instancePages;
+    SpriteInstance* sorted;     // opaque grouped by page, then translucent in submission order
+    Uint8* sortedPages;
+    int numInstances;
+    int numOpaque;
+    int capacity;
+    int pageCounts[GL_MAX_PAGES];   // opaque instances per page
+
+    int screenWidth, screenHeight;
+    int drawCalls;
+    int lastInstanceCount;
+} GLRenderer;
+
+// A window rectangle showing the batch scrolled left by offsetX (split screen)
+typedef struct {
+    SDL_Rect viewport;      // window pixels from the top left
+    float offsetX;          // batch x drawn at the viewport's left edge
+} GLView;
+
+bool glRendererInit(GLRenderer* r);
+void glRendererDestroy(GLRenderer* r);
+int glRendererLoadPage(GLRenderer* r, const char* path);
+// Cached page for path, or -1
+int glRendererFindPage(const GLRenderer* r, const char* path);
+// Page from an image already decoded to RGBA32 (see decodepool.c), cached by path like a loaded one
+int glRendererAddSurface(GLRenderer* r, const char* path, const SDL_Surface* rgba);
+void glRendererBegin(GLRenderer* r, int screen_width, int screen_height);
+void glRendererSprite(GLRenderer* r, int page, const SDL_Rect* src, const SDL_Rect* dst, SDL_Color tint);
+void glRendererFill(GLRenderer* r, const SDL_Rect* dst, SDL_Color color);
+void glRendererFlush(GLRenderer* r);
+void glRendererFlushViews(GLRenderer* r, const GLView* views, int numViews);
+
+#endif
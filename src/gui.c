@@ -1,4 +1,5 @@
 #include <gui.h>
+#include "schema.h"
 
 void loadMainMenu(GameData* g, int screen_width, int screen_height) {
     ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
@@ -8,7 +9,7 @@ void loadMainMenu(GameData* g, int screen_width, int screen_height) {
     float base_height = 100.0f; // Base height for title, spacing, and buttons
     float button_height = 30.0f;
     float spacing = igGetStyle()->ItemSpacing.y;
-    float total_height = base_height + (g->levelCount + 1) * (button_height + spacing); // Levels
+    float total_height = base_height + (g->levelCount + 2) * (button_height + spacing); // Levels and split screen
 
     int saveCount;
     SaveFileInfo* saves = loadSaveFiles(&saveCount);
@@ -41,13 +42,15 @@ void loadMainMenu(GameData* g, int screen_width, int screen_height) {
     // New Game Section
     igText("New Game:");
     igSpacing();
+    igSetCursorPosX(center_pos_x);
+    igCheckbox("Split screen versus", &g->splitScreen);
     for (int i = 0; i < g->levelCount; i++) {
         igSetCursorPosX(center_pos_x);
         char buttonLabel[32];
         snprintf(buttonLabel, sizeof(buttonLabel), "Level %d", i + 1);
         if (igButton(buttonLabel, button_size)) {
             g->selectedLevelIndex = i;
-            initializeGame(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
+            resetLevel(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
             g->showLevelSelection = false;
         }
     }
@@ -115,12 +118,15 @@ void loadPause(GameData* g, int screen_width, int screen_height){
 
     igSetCursorPosX(center_pos_x);
     if (igButton("Restart", button_size)) {
-        initializeGame(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
+        resetLevel(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
         g->isPaused = false;
         SDL_Delay(100);
     }
 
+    // A streamed level only holds the chunks around the camera, see saveGame
+    bool canSave = g->world.sim == NULL || g->world.sim->numChunks <= 0;
     igSetCursorPosX(center_pos_x);
+    igBeginDisabled(!canSave);
     if (igButton("Save & Exit to Menu", button_size)) {
         if (saveGame(g)) {
             cleanupGameState(g);
@@ -132,6 +138,7 @@ void loadPause(GameData* g, int screen_width, int screen_height){
             SDL_Delay(100);
         }
     }
+    igEndDisabled();
 
     igSetCursorPosX(center_pos_x);
     if (igButton("Exit to Main Menu", button_size)) {
@@ -165,28 +172,28 @@ void loadSummary(GameData* g, int screen_width, int screen_height){
 
     igBegin("Summary", NULL, window_flags);
     igSetCursorPosX(center_pos_x);
-    igText("Player 1: Score: %d,\n Time: %.2fs,\n Health: %d\n", g->shooters[0].score, g->shooters[0].time, g->shooters[0].health);
+    igText("Player 1: Score: %d,\n Time: %.2fs,\n Health: %d\n", g->world.shooters[0].score, g->world.shooters[0].time, g->world.shooters[0].health);
     igSetCursorPosX(center_pos_x);
-    igText("Player 2: Score: %d,\n Time: %.2fs,\n Health: %d\n", g->shooters[1].score, g->shooters[1].time, g->shooters[1].health);
+    igText("Player 2: Score: %d,\n Time: %.2fs,\n Health: %d\n", g->world.shooters[1].score, g->world.shooters[1].time, g->world.shooters[1].health);
     
     igSetCursorPosX(center_pos_x);
     // Conditions of winner
     // Whoever dies will lose
-    if (g->shooters[0].health == 0 && g->shooters[1].health > 0) {
+    if (g->world.shooters[0].health == 0 && g->world.shooters[1].health > 0) {
         igText("Player 2 wins!");
-    } else if (g->shooters[1].health == 0 && g->shooters[0].health > 0) {
+    } else if (g->world.shooters[1].health == 0 && g->world.shooters[0].health > 0) {
         igText("Player 1 wins!");
-    } else if (g->shooters[0].health > 0 && g->shooters[1].health > 0) {
+    } else if (g->world.shooters[0].health > 0 && g->world.shooters[1].health > 0) {
         // Both players are alive, compare scores
-        if (g->shooters[0].score > g->shooters[1].score) {
+        if (g->world.shooters[0].score > g->world.shooters[1].score) {
             igText("Player 1 wins!");
-        } else if (g->shooters[0].score < g->shooters[1].score) {
+        } else if (g->world.shooters[0].score < g->world.shooters[1].score) {
             igText("Player 2 wins!");
         } else {
             // Scores are tied, compare time
-            if (g->shooters[0].time < g->shooters[1].time) {
+            if (g->world.shooters[0].time < g->world.shooters[1].time) {
                 igText("Player 1 wins!");
-            } else if (g->shooters[0].time > g->shooters[1].time) {
+            } else if (g->world.shooters[0].time > g->world.shooters[1].time) {
                 igText("Player 2 wins!");
             } else {
                 // Everything is tied
@@ -203,8 +210,7 @@ void loadSummary(GameData* g, int screen_width, int screen_height){
     if (igButton("Next Level", button_size)) {
         g->showSummaryWindow = false;
         g->selectedLevelIndex += 1;
-        cleanupGameState(g);
-        initializeGame(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
+        resetLevel(g, g->levelFiles[g->selectedLevelIndex], screen_width, screen_height);
     }
 
     igSetCursorPosX(center_pos_x);
@@ -265,7 +271,29 @@ void ensureSavesDirectoryExists() {
     #endif
 }
 
+static const char* spritePath(void* userData, int sprite) {
+    GameData* state = (GameData*)userData;
+    return (sprite >= 0 && sprite < state->numSprites) ? state->sprites[sprite].path : "";
+}
+
+// One array of a save, each entry written through its type's schema
+static cJSON* writeEntities(const EntitySchema* schema, const void* entities, size_t size, int count, GameData* state) {
+    cJSON* array = cJSON_CreateArray();
+    for (int i = 0; i < count; i++) {
+        cJSON* item = cJSON_CreateObject();
+        writeEntity(schema, (const char*)entities + i * size, item, spritePath, state);
+        cJSON_AddItemToArray(array, item);
+    }
+    return array;
+}
+
 bool saveGame(GameData* state) {
+    // Only the resident chunks are in the tables, relative to the streaming origin,
+    // and a save has no place for the rest or for what was consumed in them
+    if (state->world.sim && state->world.sim->numChunks > 0) {
+        printf("Saving is not supported on streamed levels\n");
+        return false;
+    }
     ensureSavesDirectoryExists();
     
     // Generate timestamp for filename
@@ -281,116 +309,15 @@ bool saveGame(GameData* state) {
     cJSON* root = cJSON_CreateObject();
 
     // Create an array for each entities
-    cJSON* shooters = cJSON_CreateArray();
-    for (int i = 0; i < 2; i++)
-    {
-        cJSON* shooter = cJSON_CreateObject();
-        cJSON_AddNumberToObject(shooter, "x", state->shooters[i].x);
-        cJSON_AddNumberToObject(shooter, "y", state->shooters[i].y);
-        cJSON_AddNumberToObject(shooter, "width", state->shooters[i].width);
-        cJSON_AddNumberToObject(shooter, "height", state->shooters[i].height);
-        cJSON_AddNumberToObject(shooter, "health", state->shooters[i].health);
-        cJSON_AddNumberToObject(shooter, "ammo", state->shooters[i].ammo);
-        cJSON_AddNumberToObject(shooter, "score", state->shooters[i].score);
-        cJSON_AddNumberToObject(shooter, "velocityY", state->shooters[i].velocityY);
-        cJSON_AddNumberToObject(shooter, "time", state->shooters[i].time);
-        cJSON_AddBoolToObject(shooter, "onGround", state->shooters[i].onGround);
-        cJSON_AddStringToObject(shooter, "textureLocation", state->shooters[i].textureLocation);
-        cJSON_AddNumberToObject(shooter, "currentFrame", state->shooters[i].currentFrame);
-        cJSON_AddNumberToObject(shooter, "spriteWidth", state->shooters[i].frameWidth);
-        cJSON_AddNumberToObject(shooter, "spriteHeight", state->shooters[i].frameHeight);
-        cJSON_AddNumberToObject(shooter, "totalFrames", state->shooters[i].totalFrames);
-        cJSON_AddNumberToObject(shooter, "animationTimer", 0.0);
-        cJSON_AddNumberToObject(shooter, "frameDelay", state->shooters[i].frameDelay);
-        cJSON_AddBoolToObject(shooter, "dead", state->shooters[i].dead);
-        cJSON_AddItemToArray(shooters, shooter);
-    }
-    cJSON_AddItemToObject(root, "shooters", shooters);
-    
-    
+    SimContext* world = &state->world;
+    cJSON_AddItemToObject(root, "shooters", writeEntities(&shooterSchema, world->shooters, sizeof(Shooter), 2, state));
     cJSON_AddNumberToObject(root, "deltaTime", state->deltaTime);
-    cJSON_AddBoolToObject(root, "isPlayer1Turn", state->isPlayer1Turn);
-
-    // Save platforms
-    cJSON* platforms = cJSON_CreateArray();
-    for (int i = 0; i < state->numPlatforms; i++) {
-        cJSON* platform = cJSON_CreateObject();
-        cJSON_AddNumberToObject(platform, "x", state->platforms[i].x);
-        cJSON_AddNumberToObject(platform, "y", state->platforms[i].y);
-        cJSON_AddNumberToObject(platform, "width", state->platforms[i].width);
-        cJSON_AddNumberToObject(platform, "height", state->platforms[i].height);
-        cJSON_AddItemToArray(platforms, platform);
-    }
-    cJSON_AddItemToObject(root, "platforms", platforms);
-    
-    // Save enemies1
-    cJSON* enemies1 = cJSON_CreateArray();
-    for (int i = 0; i < state->numEnemies1; i++) {
-        cJSON* enemy = cJSON_CreateObject();
-        cJSON_AddNumberToObject(enemy, "x", state->enemies1[i].x);
-        cJSON_AddNumberToObject(enemy, "y", state->enemies1[i].y);
-        cJSON_AddNumberToObject(enemy, "width", state->enemies1[i].width);
-        cJSON_AddNumberToObject(enemy, "height", state->enemies1[i].height);
-        cJSON_AddBoolToObject(enemy, "active", state->enemies1[i].active);
-        cJSON_AddNumberToObject(enemy, "currentFrame", state->enemies1[i].currentFrame);
-        cJSON_AddNumberToObject(enemy, "speed", state->enemies1[i].speed);
-        cJSON_AddStringToObject(enemy, "textureLocation", state->enemies1[i].textureLocation);
-        cJSON_AddNumberToObject(enemy, "spriteWidth", state->enemies1[i].frameWidth);
-        cJSON_AddNumberToObject(enemy, "spriteHeight", state->enemies1[i].frameHeight);
-        cJSON_AddNumberToObject(enemy, "totalFrames", state->enemies1[i].totalFrames);
-        cJSON_AddNumberToObject(enemy, "animationTimer", 0.0);
-        cJSON_AddNumberToObject(enemy, "frameDelay", state->enemies1[i].frameDelay);
-        cJSON_AddItemToArray(enemies1, enemy);
-    }
-    cJSON_AddItemToObject(root, "enemies1", enemies1);
-    
-    // Save enemies2
-    cJSON* enemies2 = cJSON_CreateArray();
-    for (int i = 0; i < state->numEnemies2; i++) {
-        cJSON* enemy = cJSON_CreateObject();
-        cJSON_AddNumberToObject(enemy, "x", state->enemies2[i].x);
-        cJSON_AddNumberToObject(enemy, "y", state->enemies2[i].y);
-        cJSON_AddNumberToObject(enemy, "width", state->enemies2[i].width);
-        cJSON_AddNumberToObject(enemy, "height", state->enemies2[i].height);
-        cJSON_AddBoolToObject(enemy, "active", state->enemies2[i].active);
-        cJSON_AddNumberToObject(enemy, "speed", state->enemies2[i].speed);
-        cJSON_AddNumberToObject(enemy, "platformIndex", state->enemies2[i].platformIndex);
-        cJSON_AddStringToObject(enemy, "textureLocation", state->enemies2[i].textureLocation);
-        cJSON_AddNumberToObject(enemy, "spriteWidth", state->enemies2[i].frameWidth);
-        cJSON_AddNumberToObject(enemy, "spriteHeight", state->enemies2[i].frameHeight);
-        cJSON_AddNumberToObject(enemy, "totalFrames", state->enemies2[i].totalFrames);
-        cJSON_AddNumberToObject(enemy, "currentFrame", state->enemies2[i].currentFrame);
-        cJSON_AddNumberToObject(enemy, "animationTimer", 0.0);
-        cJSON_AddNumberToObject(enemy, "frameDelay", state->enemies2[i].frameDelay);
-        cJSON_AddItemToArray(enemies2, enemy);
-    }
-    cJSON_AddItemToObject(root, "enemies2", enemies2);
-    
-    // Save collectibles
-    cJSON* collectibles = cJSON_CreateArray();
-    for (int i = 0; i < state->numCollectibles; i++) {
-        cJSON* collectible = cJSON_CreateObject();
-        cJSON_AddNumberToObject(collectible, "x", state->collectibles[i].x);
-        cJSON_AddNumberToObject(collectible, "y", state->collectibles[i].y);
-        cJSON_AddNumberToObject(collectible, "width", state->collectibles[i].width);
-        cJSON_AddNumberToObject(collectible, "height", state->collectibles[i].height);
-        cJSON_AddBoolToObject(collectible, "collected", state->collectibles[i].collected);
-        cJSON_AddItemToArray(collectibles, collectible);
-    }
-    cJSON_AddItemToObject(root, "collectibles", collectibles);
-    
-    // Save ammos
-    cJSON* ammos = cJSON_CreateArray();
-    for (int i = 0; i < state->numAmmos; i++) {
-        cJSON* ammo = cJSON_CreateObject();
-        cJSON_AddNumberToObject(ammo, "x", state->ammos[i].x);
-        cJSON_AddNumberToObject(ammo, "y", state->ammos[i].y);
-        cJSON_AddNumberToObject(ammo, "width", state->ammos[i].width);
-        cJSON_AddNumberToObject(ammo, "height", state->ammos[i].height);
-        cJSON_AddBoolToObject(ammo, "collected", state->ammos[i].collected);
-        cJSON_AddItemToArray(ammos, ammo);
-    }
-    cJSON_AddItemToObject(root, "ammos", ammos);
+    cJSON_AddBoolToObject(root, "isPlayer1Turn", world->sim->isPlayer1Turn);
+    cJSON_AddItemToObject(root, "platforms", writeEntities(&platformSchema, world->platforms, sizeof(Platform), world->numPlatforms, state));
+    cJSON_AddItemToObject(root, "enemies1", writeEntities(&enemySchema, world->enemies1, sizeof(Enemy), world->numEnemies1, state));
+    cJSON_AddItemToObject(root, "enemies2", writeEntities(&enemySchema, world->enemies2, sizeof(Enemy), world->numEnemies2, state));
+    cJSON_AddItemToObject(root, "collectibles", writeEntities(&collectibleSchema, world->collectibles, sizeof(Collectible), world->numCollectibles, state));
+    cJSON_AddItemToObject(root, "ammos", writeEntities(&collectibleSchema, world->ammos, sizeof(Collectible), world->numAmmos, state));
     
     // Write JSON to file
     char* json_str = cJSON_Print(root);
@@ -0,0 +1,319 @@
+// poll and read are POSIX, hidden by -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include "hotreload.h"
+#include "simstate.h"
+#include "stream.h"
+#include "worldcache.h"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+// How long the thread blocks on inotify before checking whether it should stop
+#define WATCH_POLL_MS 100
+
+static void freeParsedLevel(LevelData* level) {
+    free(level->sim);
+    free(level->platforms);
+    free(level->nav);
+    closeLevelStream(level->stream);
+    memset(level, 0, sizeof(*level));
+}
+
+// The loader's sprite resolver off the main thread: GameData.sprites belongs to
+// the main thread, so paths are only collected here and looked up on apply
+static int recordSprite(void* userData, const char* path) {
+    ReloadSprites* sprites = (ReloadSprites*)userData;
+    for (int i = 0; i < sprites->count; i++) {
+        if (strcmp(sprites->paths[i], path) == 0) return i;
+    }
+    if (sprites->count >= MAX_SPRITES) return -1;
+    snprintf(sprites->paths[sprites->count], sizeof(sprites->paths[0]), "%s", path);
+    return sprites->count++;
+}
+
+static bool isLevelBeingPlayed(LevelWatcher* w, const char* name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", w->directory, name);
+    SDL_LockMutex(w->lock);
+    bool match = w->path[0] != '\0' && strcmp(path, w->path) == 0;
+    SDL_UnlockMutex(w->lock);
+    return match;
+}
+
+static void reparseLevel(LevelWatcher* w) {
+    char path[256];
+    SDL_LockMutex(w->lock);
+    snprintf(path, sizeof(path), "%s", w->path);
+    SDL_UnlockMutex(w->lock);
+
+    Uint64 seen = SDL_GetPerformanceCounter();
+    ReloadSprites* sprites = (ReloadSprites*)calloc(1, sizeof(ReloadSprites));
+    if (sprites == NULL) return;
+    LevelData parsed;
+    if (!loadLevelData(path, &parsed, recordSprite, sprites)) {
+        printf("Hot reload: %s did not load, keeping the running level\n", path);
+        free(sprites);
+        return;
+    }
+    if (parsed.stream) {
+        // Chunks come and go on their own, a streamed level is picked up on restart
+        printf("Hot reload: %s is streamed, restart it to play the edit\n", path);
+        freeParsedLevel(&parsed);
+        free(sprites);
+        return;
+    }
+
+    SDL_LockMutex(w->lock);
+    if (w->ready) {
+        freeParsedLevel(&w->parsed);
+        free(w->sprites);
+    }
+    snprintf(w->parsedPath, sizeof(w->parsedPath), "%s", path);
+    w->parsed = parsed;
+    w->sprites = sprites;
+    w->savedAt = seen;
+    w->parseMs = (SDL_GetPerformanceCounter() - seen) * 1000.0 / SDL_GetPerformanceFrequency();
+    w->ready = true;
+    SDL_UnlockMutex(w->lock);
+}
+
+static int watcherThread(void* data) {
+    LevelWatcher* w = (LevelWatcher*)data;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd = {w->fd, POLLIN, 0};
+    while (__atomic_load_n(&w->running, __ATOMIC_ACQUIRE)) {
+        if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) continue;
+        ssize_t length = read(w->fd, buffer, sizeof(buffer));
+        if (length <= 0) continue;
+
+        // An editor's save can be several events (write, then rename over the old file),
+        // one parse covers them all
+        bool changed = false;
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if (event->len > 0 && isLevelBeingPlayed(w, event->name)) changed = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+        if (changed) reparseLevel(w);
+    }
+    return 0;
+}
+
+bool levelWatcherStart(LevelWatcher* w, const char* directory) {
+    memset(w, 0, sizeof(*w));
+    snprintf(w->directory, sizeof(w->directory), "%s", directory);
+    w->fd = inotify_init();
+    if (w->fd < 0) {
+        printf("Hot reload: inotify is not available: %s\n", strerror(errno));
+        return false;
+    }
+    // Saved in place, or written elsewhere and renamed over the level
+    if (inotify_add_watch(w->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        printf("Hot reload: cannot watch %s: %s\n", directory, strerror(errno));
+        close(w->fd);
+        return false;
+    }
+    w->lock = SDL_CreateMutex();
+    w->running = 1;
+    w->thread = w->lock ? SDL_CreateThread(watcherThread, "level-watch", w) : NULL;
+    if (w->thread == NULL) {
+        printf("Hot reload: cannot start the watcher thread: %s\n", SDL_GetError());
+        if (w->lock) SDL_DestroyMutex(w->lock);
+        close(w->fd);
+        return false;
+    }
+    printf("Watching %s for level edits\n", directory);
+    return true;
+}
+
+// An entry the edit left alone keeps its live state (where it walked to, whether
+// it was killed or collected); edited and added ones start over from the file
+static bool keepEntry(const void* before, int numBefore, const void* after, int i, size_t size) {
+    return i < numBefore && memcmp((const char*)before + i * size, (const char*)after + i * size, size) == 0;
+}
+
+static bool platformEdited(const LevelTemplate* level, const LevelData* parsed, int index) {
+    if (index < 0) return false;
+    if (index >= level->numPlatforms || index >= parsed->numPlatforms) return true;
+    return memcmp(&level->platforms[index], &parsed->platforms[index], sizeof(Platform)) != 0;
+}
+
+// Enters at full rate as of now, or its first off-screen update would catch up
+// on everything simulated since the level started
+static void restartEnemy(Enemy* enemy, const SimState* sim) {
+    enemy->lodTier = SIM_LOD_FULL;
+    enemy->lodClock = sim->clock;
+}
+
+static void patchLevel(GameData* g, LevelData* parsed, const ReloadSprites* sprites) {
+    SimContext* world = &g->world;
+    LevelTemplate* level = g->level;
+    SimState* live = world->sim;
+
+    // The parse refers to sprites by the order it met them in
+    int map[MAX_SPRITES];
+    for (int i = 0; i < sprites->count; i++) map[i] = loadSprite(g, sprites->paths[i]);
+    SimContext after = {0};
+    bindSimState(&after, parsed->sim);
+    for (int list = 0; list < 2; list++) {
+        Enemy* enemies = list ? after.enemies2 : after.enemies1;
+        int count = list ? after.numEnemies2 : after.numEnemies1;
+        for (int i = 0; i < count; i++) {
+            if (enemies[i].sprite >= 0) enemies[i].sprite = map[enemies[i].sprite];
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        if (after.shooters[i].sprite >= 0) after.shooters[i].sprite = map[after.shooters[i].sprite];
+    }
+    // Restarts play the edited level from now on, with the seed and mode the template had
+    seedSimState(parsed->sim, world->seed);
+    parsed->sim->versus = level->sim->versus;
+    parsed->sim->splitScreen = level->sim->splitScreen;
+
+    SimState* next = snapshotSimState(parsed->sim, NULL);
+    if (next == NULL) return;
+    next->tick = live->tick;
+    next->random = live->random;
+    next->clock = live->clock;
+    next->cameraX = live->cameraX;
+    next->isPlayer1Turn = live->isPlayer1Turn;
+    next->versus = live->versus;
+    next->versusOver = live->versusOver;
+    next->splitScreen = live->splitScreen;
+    memcpy(next->splitCameraX, live->splitCameraX, sizeof(next->splitCameraX));
+    next->bulletFrame = live->bulletFrame;
+    next->bulletAnimationTimer = live->bulletAnimationTimer;
+    memcpy(next->shooters, live->shooters, sizeof(next->shooters));
+    memcpy(next->bullets, live->bullets, sizeof(next->bullets));
+
+    // Diff each table against the last parse, which is what the live one started from
+    SimContext before = {0};
+    bindSimState(&before, level->sim);
+    bindSimState(&after, next);
+    int enemies = 0, pickups = 0, platforms = 0;
+    for (int i = 0; i < after.numEnemies1; i++) {
+        if (keepEntry(before.enemies1, before.numEnemies1, after.enemies1, i, sizeof(Enemy))) {
+            after.enemies1[i] = world->enemies1[i];
+        } else {
+            restartEnemy(&after.enemies1[i], next);
+            enemies++;
+        }
+    }
+    for (int i = 0; i < after.numEnemies2; i++) {
+        // A platform enemy also starts over when its platform moved from under it
+        if (keepEntry(before.enemies2, before.numEnemies2, after.enemies2, i, sizeof(Enemy)) &&
+            !platformEdited(level, parsed, after.enemies2[i].platformIndex)) {
+            after.enemies2[i] = world->enemies2[i];
+        } else {
+            restartEnemy(&after.enemies2[i], next);
+            enemies++;
+        }
+    }
+    for (int i = 0; i < after.numCollectibles; i++) {
+        if (keepEntry(before.collectibles, before.numCollectibles, after.collectibles, i, sizeof(Collectible))) {
+            after.collectibles[i] = world->collectibles[i];
+        } else {
+            pickups++;
+        }
+    }
+    for (int i = 0; i < after.numAmmos; i++) {
+        if (keepEntry(before.ammos, before.numAmmos, after.ammos, i, sizeof(Collectible))) {
+            after.ammos[i] = world->ammos[i];
+        } else {
+            pickups++;
+        }
+    }
+    // Removed entries count as changed too
+    if (before.numEnemies1 > after.numEnemies1) enemies += before.numEnemies1 - after.numEnemies1;
+    if (before.numEnemies2 > after.numEnemies2) enemies += before.numEnemies2 - after.numEnemies2;
+    if (before.numCollectibles > after.numCollectibles) pickups += before.numCollectibles - after.numCollectibles;
+    if (before.numAmmos > after.numAmmos) pickups += before.numAmmos - after.numAmmos;
+    for (int i = 0; i < parsed->numPlatforms || i < level->numPlatforms; i++) {
+        if (platformEdited(level, parsed, i)) platforms++;
+    }
+
+    bindSimState(world, next);
+    free(live);
+    Platform* geometry = NULL;
+    if (platforms > 0) {
+        geometry = (Platform*)malloc((parsed->numPlatforms > 0 ? parsed->numPlatforms : 1) * sizeof(Platform));
+    }
+    if (geometry) {
+        memcpy(geometry, parsed->platforms, parsed->numPlatforms * sizeof(Platform));
+        // The kept enemies still hold nodes of the old graph
+        releaseNavNodes(world);
+        free(world->nav);
+        free(world->platforms);
+        world->nav = parsed->nav;
+        world->platforms = geometry;
+        world->numPlatforms = parsed->numPlatforms;
+        world->navBuilds++;
+        parsed->nav = NULL;
+        if (g->worldCache) invalidateWorldCache(g->worldCache);
+    }
+    if (g->hud) g->hud->dirty = true;
+
+    // The parse becomes the template: restarts and the next diff start from it
+    free(level->sim);
+    free(level->platforms);
+    level->sim = parsed->sim;
+    level->platforms = parsed->platforms;
+    level->numPlatforms = parsed->numPlatforms;
+    level->deltaTime = parsed->deltaTime;
+    parsed->sim = NULL;
+    parsed->platforms = NULL;
+    printf("Hot reload: %d platforms, %d enemies, %d pickups changed\n", platforms, enemies, pickups);
+}
+
+void levelWatcherUpdate(LevelWatcher* w, GameData* g) {
+    LevelTemplate* level = g->level;
+    if (level == NULL || !level->valid) return;
+
+    // Only the main thread writes the path, reading it here needs no lock
+    if (strcmp(w->path, level->path) != 0) {
+        SDL_LockMutex(w->lock);
+        snprintf(w->path, sizeof(w->path), "%s", level->path);
+        SDL_UnlockMutex(w->lock);
+    }
+
+    SDL_LockMutex(w->lock);
+    bool ready = w->ready;
+    LevelData parsed = w->parsed;
+    ReloadSprites* sprites = w->sprites;
+    bool current = strcmp(w->parsedPath, level->path) == 0;
+    double parseMs = w->parseMs;
+    Uint64 savedAt = w->savedAt;
+    w->ready = false;
+    w->sprites = NULL;
+    SDL_UnlockMutex(w->lock);
+    if (!ready) return;
+
+    // Another level may have been picked while the parse ran, and the tables
+    // are only diffed against the template the running state was made from
+    const SimState* sim = g->world.sim;
+    if (current && sim && sim->numChunks == 0 && sim->size == level->sim->size) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        patchLevel(g, &parsed, sprites);
+        Uint64 end = SDL_GetPerformanceCounter();
+        w->reloads++;
+        printf("Hot reload: %s parsed in %.3f ms, patched in %.3f ms, %.3f ms after the save\n", level->path, parseMs,
+               (end - start) * 1000.0 / SDL_GetPerformanceFrequency(),
+               (end - savedAt) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+    freeParsedLevel(&parsed);
+    free(sprites);
+}
+
+void levelWatcherStop(LevelWatcher* w) {
+    __atomic_store_n(&w->running, 0, __ATOMIC_RELEASE);
+    SDL_WaitThread(w->thread, NULL);
+    close(w->fd);
+    if (w->ready) {
+        freeParsedLevel(&w->parsed);
+        free(w->sprites);
+    }
+    SDL_DestroyMutex(w->lock);
+    printf("Hot reload: %d level edits patched in\n", w->reloads);
+}
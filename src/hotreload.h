@@ -0,0 +1,44 @@
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include "init.h"
+#include "level.h"
+
+// Sprite paths met while parsing off the main thread, indexed as the parsed level
+// refers to them; mapped to GameData.sprites when the level is patched in
+typedef struct {
+    char paths[MAX_SPRITES][256];
+    int count;
+} ReloadSprites;
+
+// Level editing while playing (--watch): a thread waits on inotify for saves in
+// the levels directory and re-parses the level being played, then hands it to
+// the main thread, which diffs it against the level's template and patches only
+// the entities that changed into the running state. The shooters, bullets,
+// camera and clock carry over, so play goes on from where it was.
+typedef struct {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    int fd;                 // inotify instance
+    int running;            // cleared to stop the thread
+    char directory[256];
+    char path[256];         // level file being played, written by the main thread under lock
+
+    // Latest parse, handed over under lock. A newer save replaces one not yet applied.
+    bool ready;
+    char parsedPath[256];
+    LevelData parsed;
+    ReloadSprites* sprites;
+    Uint64 savedAt;         // performance counter when the save was seen
+    double parseMs;
+
+    int reloads;
+} LevelWatcher;
+
+bool levelWatcherStart(LevelWatcher* w, const char* directory);
+// Main thread, once per frame while a level is up: follows the level being
+// played and patches in a new parse of it if there is one
+void levelWatcherUpdate(LevelWatcher* w, GameData* g);
+void levelWatcherStop(LevelWatcher* w);
+
+#endif
@@ -1,14 +1,33 @@
 #include "init.h"
+#include "worldcache.h"
+#include "level.h"
+#include "decodepool.h"
+
+// GL context shared by the sprite batch and ImGui, swapped once per frame
+static bool initGL(GameData* g) {
+    g->glContext = SDL_GL_CreateContext(g->window);
+    if (g->glContext == NULL) {
+        printf("OpenGL context creation failed: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_GL_MakeCurrent(g->window, g->glContext);
+    SDL_GL_SetSwapInterval(1); // Enable vsync
 
-#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
-#include "GL/gl3w.h"    // Initialize with gl3wInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
-#include <GL/glew.h>    // Initialize with glewInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
-#include <glad/glad.h>  // Initialize with gladLoadGL()
-#else
-#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
-#endif
+    if (gl3wInit() != 0) {
+        printf("Failed to initialize OpenGL loader!\n");
+        return false;
+    }
+
+    g->gl = (GLRenderer*)malloc(sizeof(GLRenderer));
+    if (g->gl == NULL || !glRendererInit(g->gl)) {
+        printf("Failed to initialize sprite renderer!\n");
+        return false;
+    }
+
+    ImGui_ImplSDL2_InitForOpenGL(g->window, g->glContext);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+    return true;
+}
 
 bool init(GameData* g) {
     bool success = true;
@@ -18,20 +37,24 @@ bool init(GameData* g) {
         return false;
     }
 
-    // Setup OpenGL attributes
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+    Uint32 windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_FULLSCREEN_DESKTOP;
+    if (g->useGL) {
+        // GL 3.3 core for instanced arrays, also available on Mesa's llvmpipe
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+        SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+        windowFlags |= SDL_WINDOW_OPENGL;
+    }
 
     g->window = SDL_CreateWindow(
         "America Mario",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         SCREEN_WIDTH, SCREEN_HEIGHT,
-        SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_FULLSCREEN_DESKTOP
+        windowFlags
     );
     
     if (g->window == NULL) {
@@ -39,49 +62,25 @@ bool init(GameData* g) {
         return false;
     }
 
-    int screen_width, screen_height;
-    
-    SDL_GetWindowSize(g->window, &screen_width, &screen_height);
-
-    // Create OpenGL context
-    SDL_GLContext gl_context = SDL_GL_CreateContext(g->window);
-    if (gl_context == NULL) {
-        printf("OpenGL context creation failed: %s\n", SDL_GetError());
-        return false;
-    }
-    
-    SDL_GL_MakeCurrent(g->window, gl_context);
-    SDL_GL_SetSwapInterval(1); // Enable vsync
-
-        // Initialize OpenGL loader
-    #if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
-    bool err = gl3wInit() != 0;
-    #elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
-    bool err = glewInit() != GLEW_OK;
-    #elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
-    bool err = gladLoadGL() == 0;
-    #endif
-    if (err)
-    {
-        SDL_Log("Failed to initialize OpenGL loader!");
-        return 1;
-    }
-
     // Initialize ImGui
     igCreateContext(NULL);
     int windowWidth, windowHeight;
     SDL_GetWindowSize(g->window, &windowWidth, &windowHeight);
     ImGuiIO* io = igGetIO();
     io->DisplaySize = (ImVec2){(float)windowWidth, (float)windowHeight};
-    ImGui_ImplSDL2_InitForOpenGL(g->window, gl_context);
-    ImGui_ImplOpenGL3_Init("#version 130");
     igStyleColorsDark(NULL);
 
-    // Create renderer with OpenGL support
-    g->renderer = SDL_CreateRenderer(g->window, -1, SDL_RENDERER_ACCELERATED);
-    if (g->renderer == NULL) {
-        printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
-        return false;
+    if (g->useGL) {
+        if (!initGL(g)) return false;
+    } else {
+        // Create renderer, ImGui draws through it too so each frame is presented once
+        g->renderer = SDL_CreateRenderer(g->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (g->renderer == NULL) {
+            printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
+            return false;
+        }
+        ImGui_ImplSDL2_InitForSDLRenderer(g->window);
+        ImGui_ImplSDLRenderer_Init(g->renderer);
     }
 
     if (TTF_Init() == -1) {
@@ -98,63 +97,126 @@ bool init(GameData* g) {
     return success;
 }
 
+// Loads an image as an SDL texture, or as a sprite batch page when the GL backend is active
+static bool loadImage(GameData* g, const char* path, SDL_Texture** texture, int* page) {
+    if (g->gl) {
+        *texture = NULL;
+        *page = glRendererLoadPage(g->gl, path);
+        return *page >= 0;
+    }
+    *page = -1;
+    *texture = IMG_LoadTexture(g->renderer, path);
+    return *texture != NULL;
+}
+
+// Hands the image to the decode pool, whose upload writes texture, page and
+// loaded; without a pool (or with its queue full) it is loaded right here
+static void requestImage(GameData* g, const char* path, SDL_Texture** texture, int* page, bool* loaded) {
+    if (g->gl) {
+        // Already a page, the GL backend keeps every image it has loaded
+        int cached = glRendererFindPage(g->gl, path);
+        if (cached >= 0) {
+            *texture = NULL;
+            *page = cached;
+            if (loaded) *loaded = true;
+            return;
+        }
+    }
+    if (g->decode && decodePoolSubmit(g->decode, path, texture, page, loaded)) return;
+    bool ok = loadImage(g, path, texture, page);
+    if (loaded) *loaded = ok;
+}
+
+static bool imageLoaded(const GameData* g, SDL_Texture* texture, int page) {
+    return g->gl ? page >= 0 : texture != NULL;
+}
+
+// Returns the sprite sheet index for path, registering it the first time it is
+// seen; loadMedia loads the texture
+static int findSprite(GameData* g, const char* path) {
+    for (int i = 0; i < g->numSprites; i++) {
+        if (strcmp(g->sprites[i].path, path) == 0) return i;
+    }
+    if (g->numSprites >= MAX_SPRITES) {
+        printf("Too many sprite sheets, cannot load %s\n", path);
+        return -1;
+    }
+    SpriteSheet* sheet = &g->sprites[g->numSprites];
+    snprintf(sheet->path, sizeof(sheet->path), "%s", path);
+    sheet->texture = NULL;
+    sheet->page = -1;
+    sheet->loaded = false;
+    return g->numSprites++;
+}
+
+// Sprite sheet index for path, starting the sheet loading right away if it is
+// new. For levels patched in while playing (see hotreload.c), which skip
+// loadMedia: with a decode pool the sheet shows up once the frame loop has
+// uploaded it, until then its entities are not drawn.
+int loadSprite(GameData* g, const char* path) {
+    int index = findSprite(g, path);
+    if (index < 0) return -1;
+    SpriteSheet* sheet = &g->sprites[index];
+    if (!sheet->loaded) {
+        requestImage(g, sheet->path, &sheet->texture, &sheet->page, &sheet->loaded);
+        if (!g->decode && !sheet->loaded) printf("Error loading sprite sheet %s\n", sheet->path);
+    }
+    return index;
+}
+
 bool loadMedia(GameData* g) {
     bool success = true;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Everything is requested before anything is waited for, so the decode
+    // threads work through the whole batch together
+    requestImage(g, "images/background.png", &g->backgroundTexture, &g->backgroundPage, NULL);
+    requestImage(g, "images/pause.png", &g->pauseTexture, &g->pausePage, NULL);
+
+    // Each sheet is loaded once, however many enemies or levels use it
+    for (int i = 0; i < g->numSprites; i++) {
+        SpriteSheet* sheet = &g->sprites[i];
+        if (sheet->loaded) continue;
+        requestImage(g, sheet->path, &sheet->texture, &sheet->page, &sheet->loaded);
+    }
 
-    g->backgroundTexture = IMG_LoadTexture(g->renderer, "images/background.png");
-    if (g->backgroundTexture == NULL) {
-        printf("Failed to load background texture! SDL_image Error: %s\n", IMG_GetError());
-        success = false;
+    requestImage(g, "Assets/Fx/Spritesheets/player-shoot.png", &g->bulletSpriteSheet, &g->bulletPage, NULL);
+
+    // A missing effect sheet only loses its effect. Loaded once, every level shares them
+    for (int i = 0; i < FX_SHEETS && !g->fxLoaded; i++) {
+        requestImage(g, fxSheetInfo[i].path, &g->fxSheets[i], &g->fxPages[i], NULL);
     }
 
-    SDL_Surface* imgPause;
-    imgPause = IMG_Load("images/pause.png");
-    if (imgPause == NULL)
-    {
-        printf("Failed to load pause image! SDL_image Error: %s\n", IMG_GetError());
+    if (g->decode) decodePoolFinish(g->decode, g);
+
+    if (!imageLoaded(g, g->backgroundTexture, g->backgroundPage)) {
+        printf("Failed to load background texture!\n");
         success = false;
     }
-    g->pauseTexture = SDL_CreateTextureFromSurface(g->renderer, imgPause);
-    if (g->pauseTexture == NULL) {
-        printf("Failed to load pause texture! SDL_image Error: %s\n", IMG_GetError());
+    if (!imageLoaded(g, g->pauseTexture, g->pausePage)) {
+        printf("Failed to load pause texture!\n");
         success = false;
     }
-    SDL_FreeSurface(imgPause);
-
-    for (int i = 0; i < g->numEnemies1; i++)
-    {
-        g->enemies1[i].texture = IMG_LoadTexture(g->renderer, g->enemies1[i].textureLocation);
-        if (!g->enemies1[i].texture) {
-            printf("Error loading sprite sheet1\n");
-            success = false;
-        }
-    }
-    for (int i = 0; i < g->numEnemies2; i++)
-    {
-        g->enemies2[i].texture = IMG_LoadTexture(g->renderer, g->enemies2[i].textureLocation);
-        if (!g->enemies2[i].texture) {
-            printf("Error loading sprite sheet2\n");
+    for (int i = 0; i < g->numSprites; i++) {
+        if (!g->sprites[i].loaded) {
+            printf("Error loading sprite sheet %s\n", g->sprites[i].path);
             success = false;
         }
     }
-    
-    
-    g->bulletSpriteSheet = IMG_LoadTexture(g->renderer, "Assets/Fx/Spritesheets/player-shoot.png");
-    if (!g->bulletSpriteSheet) {
+    if (!imageLoaded(g, g->bulletSpriteSheet, g->bulletPage)) {
         printf("Error loading bullet sprite sheet\n");
         success = false;
     }
-    g->shooters[0].texture = IMG_LoadTexture(g->renderer, g->shooters[0].textureLocation);
-    if (!g->shooters[0].texture) {
-        printf("Error loading shooter 1 sprite sheet\n");
-        success = false;
-    }
-    g->shooters[1].texture = IMG_LoadTexture(g->renderer, g->shooters[1].textureLocation);
-    if (!g->shooters[1].texture) {
-        printf("Error loading shooter 2 sprite sheet\n");
-        success = false;
+    for (int i = 0; i < FX_SHEETS && !g->fxLoaded; i++) {
+        if (!imageLoaded(g, g->fxSheets[i], g->fxPages[i])) {
+            printf("Error loading effect sheet %s\n", fxSheetInfo[i].path);
+        }
     }
+    g->fxLoaded = true;
 
+    int threads = g->decode ? g->decode->numThreads : 0;
+    printf("Media loaded in %.1f ms (%d decode threads)\n",
+           (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency(), threads);
     return success;
 }
 
@@ -163,8 +225,33 @@ void clear(GameData* g) {
         SDL_DestroyTexture(g->backgroundTexture);
         g->backgroundTexture = NULL;
     }
+    for (int i = 0; i < g->numSprites; i++) {
+        if (g->sprites[i].texture != NULL) SDL_DestroyTexture(g->sprites[i].texture);
+        g->sprites[i].texture = NULL;
+        g->sprites[i].loaded = false;
+    }
+    g->numSprites = 0;
+    for (int i = 0; i < FX_SHEETS; i++) {
+        if (g->fxSheets[i] != NULL) SDL_DestroyTexture(g->fxSheets[i]);
+        g->fxSheets[i] = NULL;
+    }
+    g->fxLoaded = false;
+
+    if (g->gl != NULL) {
+        glRendererDestroy(g->gl);
+        free(g->gl);
+        g->gl = NULL;
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplSDL2_Shutdown();
+        igDestroyContext(NULL);
+        SDL_GL_DeleteContext(g->glContext);
+        g->glContext = NULL;
+    }
 
     if (g->renderer != NULL) {
+        ImGui_ImplSDLRenderer_Shutdown();
+        ImGui_ImplSDL2_Shutdown();
+        igDestroyContext(NULL);
         SDL_DestroyRenderer(g->renderer);
         g->renderer = NULL;
     }
@@ -175,195 +262,154 @@ void clear(GameData* g) {
     }
 }
 
-void initializeGame(GameData* state, const char* levelFile, int screen_width, int screen_height) {
-    // Open JSON file
-    FILE* file = fopen(levelFile, "r");
-    if (!file) {
-        fprintf(stderr, "Error opening game_data.json\n");
-        return;
+// Copies count elements into dst, growing it when needed
+static void* copyArray(void* dst, const void* src, int count, size_t size) {
+    size_t bytes = (count > 0 ? count : 1) * size;
+    void* out = realloc(dst, bytes);
+    if (out && count > 0) memcpy(out, src, count * size);
+    return out;
+}
+
+static void captureLevelTemplate(LevelTemplate* level, GameData* state, const char* levelFile) {
+    SimState* sim = snapshotSimState(state->world.sim, level->sim);
+    if (sim == NULL) return;
+    level->sim = sim;
+    snprintf(level->path, sizeof(level->path), "%s", levelFile);
+    level->deltaTime = state->deltaTime;
+    level->numPlatforms = state->world.numPlatforms;
+    level->platforms = copyArray(level->platforms, state->world.platforms, state->world.numPlatforms, sizeof(Platform));
+    level->valid = true;
+}
+
+// Local split screen plays every level as versus, however it was started
+static void startSplitScreen(GameData* state) {
+    if (!state->splitScreen || state->world.sim == NULL) return;
+    state->world.sim->versus = true;
+    state->world.sim->splitScreen = true;
+}
+
+static void restoreLevelTemplate(GameData* state, const LevelTemplate* level) {
+    state->deltaTime = level->deltaTime;
+    state->lastTime = SDL_GetTicks();
+    state->isPaused = false;
+    state->showSummaryWindow = false;
+    state->quit = false;
+
+    // Same level layout restores in place, anything else takes a fresh copy of the block
+    if (state->world.sim == NULL || !restoreSimState(state->world.sim, level->sim)) {
+        free(state->world.sim);
+        bindSimState(&state->world, snapshotSimState(level->sim, NULL));
     }
+    state->world.numPlatforms = level->numPlatforms;
+    state->world.platforms = copyArray(state->world.platforms, level->platforms, level->numPlatforms, sizeof(Platform));
+    startSplitScreen(state);
+    if (state->hud) state->hud->dirty = true;
+}
 
-    // Read file content into a string
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char* data = (char*)malloc(length + 1);
-    fread(data, 1, length, file);
-    data[length] = '\0';
-    fclose(file);
-
-    // Parse JSON data
-    cJSON* root = cJSON_Parse(data);
-    if (!root) {
-        fprintf(stderr, "Error parsing JSON: %s\n", cJSON_GetErrorPtr());
-        free(data);
+// Restarts levelFile from the in-memory template when it is the cached level,
+// otherwise falls back to a full load from disk
+void resetLevel(GameData* state, const char* levelFile, int screen_width, int screen_height) {
+    if (state->level && state->level->valid && strcmp(state->level->path, levelFile) == 0) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        restoreLevelTemplate(state, state->level);
+        // Counted for the exit summary rather than printed on every restart
+        if (state->stats) {
+            state->stats->levelResets++;
+            state->stats->levelResetMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        }
         return;
     }
+    cleanupGameState(state);
+    initializeGame(state, levelFile, screen_width, screen_height);
+}
 
-    state->cameraX = 0.0f;
-    state->deltaTime = (float)cJSON_GetObjectItem(root, "deltaTime")->valuedouble;
+void freeLevelTemplate(LevelTemplate* level) {
+    free(level->sim);
+    free(level->platforms);
+    memset(level, 0, sizeof(*level));
+}
+
+static int resolveSprite(void* userData, const char* path) {
+    return findSprite((GameData*)userData, path);
+}
+
+void initializeGame(GameData* state, const char* levelFile, int screen_width, int screen_height) {
+    LevelData loaded;
+    if (!loadLevelData(levelFile, &loaded, resolveSprite, state)) return;
+
+    free(state->world.sim);
+    free(state->world.platforms);
+    free(state->world.nav);
+    closeLevelStream((LevelStream*)state->world.chunkSource);
+    bindSimState(&state->world, loaded.sim);
+    seedSimState(loaded.sim, state->world.seed);
+    state->world.platforms = loaded.platforms;
+    state->world.numPlatforms = loaded.numPlatforms;
+    state->world.nav = loaded.nav;
+    state->world.chunks = loaded.stream ? readLevelChunk : NULL;
+    state->world.chunkSource = loaded.stream;
+
+    state->deltaTime = loaded.deltaTime;
     state->lastTime = SDL_GetTicks();
     state->isPaused = false;
     state->showSummaryWindow = false;
     state->quit = false;
-    state->isPlayer1Turn = cJSON_IsTrue(cJSON_GetObjectItem(root, "isPlayer1Turn"));
-    printf("Game data loaded\n");
-
-    // Load only the shooter for the current turn
-    cJSON* shooters = cJSON_GetObjectItem(root, "shooters");
-    state->shooters = (Shooter*)(malloc(2 * sizeof(Shooter)));
-    for (int i = 0; i < 2; i++)
-    {
-        cJSON* shooterItem = cJSON_GetArrayItem(shooters, i);
-        state->shooters[i].x = (float)cJSON_GetObjectItem(shooterItem, "x")->valuedouble;
-        state->shooters[i].y = (float)cJSON_GetObjectItem(shooterItem, "y")->valuedouble;
-        state->shooters[i].width = cJSON_GetObjectItem(shooterItem, "width")->valueint;
-        state->shooters[i].height = cJSON_GetObjectItem(shooterItem, "height")->valueint;
-        state->shooters[i].velocityY = (float)cJSON_GetObjectItem(shooterItem, "velocityY")->valuedouble;
-        state->shooters[i].health = cJSON_GetObjectItem(shooterItem, "health")->valueint;
-        state->shooters[i].ammo = cJSON_GetObjectItem(shooterItem, "ammo")->valueint;
-        state->shooters[i].score = cJSON_GetObjectItem(shooterItem, "score")->valueint;
-        state->shooters[i].onGround = cJSON_IsTrue(cJSON_GetObjectItem(shooterItem, "onGround"));
-        strcpy(state->shooters[i].textureLocation, cJSON_GetObjectItem(shooterItem, "textureLocation")->valuestring);
-        state->shooters[i].currentFrame = cJSON_GetObjectItem(shooterItem, "currentFrame")->valueint;
-        state->shooters[i].frameWidth = cJSON_GetObjectItem(shooterItem, "spriteWidth")->valueint;
-        state->shooters[i].frameHeight = cJSON_GetObjectItem(shooterItem, "spriteHeight")->valueint;
-        state->shooters[i].totalFrames = cJSON_GetObjectItem(shooterItem, "totalFrames")->valueint;
-        state->shooters[i].animationTimer = cJSON_GetObjectItem(shooterItem, "animationTimer")->valueint;
-        state->shooters[i].frameDelay = cJSON_GetObjectItem(shooterItem, "frameDelay")->valueint;
-        state->shooters[i].time = cJSON_GetObjectItem(shooterItem, "time")->valuedouble;
-        state->shooters[i].dead = cJSON_IsTrue(cJSON_GetObjectItem(shooterItem, "dead"));
-    }
-    printf("Shooters data loaded\n");
-
-    // Load platforms
-    cJSON* platforms = cJSON_GetObjectItem(root, "platforms");
-    int numPlatforms = cJSON_GetArraySize(platforms);
-    state->platforms = (Platform*)malloc(numPlatforms * sizeof(Platform));
-    state->numPlatforms = numPlatforms;
-    for (int i = 0; i < numPlatforms; i++) {
-        cJSON* platformItem = cJSON_GetArrayItem(platforms, i);
-        state->platforms[i].x = (float)cJSON_GetObjectItem(platformItem, "x")->valuedouble;
-        state->platforms[i].y = (float)cJSON_GetObjectItem(platformItem, "y")->valuedouble;
-        state->platforms[i].width = (float)cJSON_GetObjectItem(platformItem, "width")->valuedouble;
-        state->platforms[i].height = (float)cJSON_GetObjectItem(platformItem, "height")->valuedouble;
-    }
-    printf("Platforms data loaded\n");
-
-    // Load enemies1
-    cJSON* enemies1 = cJSON_GetObjectItem(root, "enemies1");
-    int numEnemies1 = cJSON_GetArraySize(enemies1);
-    state->enemies1 = (Enemy*)malloc(numEnemies1 * sizeof(Enemy));
-    state->numEnemies1 = numEnemies1;
-    for (int i = 0; i < numEnemies1; i++) {
-        cJSON* enemyItem = cJSON_GetArrayItem(enemies1, i);
-        state->enemies1[i].x = (float)cJSON_GetObjectItem(enemyItem, "x")->valuedouble;
-        state->enemies1[i].y = (float)cJSON_GetObjectItem(enemyItem, "y")->valuedouble;
-        state->enemies1[i].width = cJSON_GetObjectItem(enemyItem, "width")->valueint;
-        state->enemies1[i].height = cJSON_GetObjectItem(enemyItem, "height")->valueint;
-        state->enemies1[i].active = cJSON_IsTrue(cJSON_GetObjectItem(enemyItem, "active"));
-        state->enemies1[i].currentFrame = cJSON_GetObjectItem(enemyItem, "currentFrame")->valueint;
-        state->enemies1[i].speed = (float)cJSON_GetObjectItem(enemyItem, "speed")->valuedouble;
-        strcpy(state->enemies1[i].textureLocation, cJSON_GetObjectItem(enemyItem, "textureLocation")->valuestring);
-        state->enemies1[i].frameWidth = cJSON_GetObjectItem(enemyItem, "spriteWidth")->valueint;
-        state->enemies1[i].frameHeight = cJSON_GetObjectItem(enemyItem, "spriteHeight")->valueint;
-        state->enemies1[i].totalFrames = cJSON_GetObjectItem(enemyItem, "totalFrames")->valueint;
-        state->enemies1[i].animationTimer = cJSON_GetObjectItem(enemyItem, "animationTimer")->valueint;
-        state->enemies1[i].frameDelay = cJSON_GetObjectItem(enemyItem, "frameDelay")->valueint;
-    }
-    printf("Enemy 1 data loaded\n");
-
-    // Load enemies2 with platformIndex
-    cJSON* enemies2 = cJSON_GetObjectItem(root, "enemies2");
-    int numEnemies2 = cJSON_GetArraySize(enemies2);
-    state->enemies2 = (Enemy*)malloc(numEnemies2 * sizeof(Enemy));
-    state->numEnemies2 = numEnemies2;
-    for (int i = 0; i < numEnemies2; i++) {
-        cJSON* enemyItem = cJSON_GetArrayItem(enemies2, i);
-        state->enemies2[i].x = (float)cJSON_GetObjectItem(enemyItem, "x")->valuedouble;
-        state->enemies2[i].y = (float)cJSON_GetObjectItem(enemyItem, "y")->valuedouble;
-        state->enemies2[i].width = (float)cJSON_GetObjectItem(enemyItem, "width")->valuedouble;
-        state->enemies2[i].height = (float)cJSON_GetObjectItem(enemyItem, "height")->valuedouble;
-        state->enemies2[i].active = cJSON_IsTrue(cJSON_GetObjectItem(enemyItem, "active"));
-        state->enemies2[i].currentFrame = cJSON_GetObjectItem(enemyItem, "currentFrame")->valueint;
-        state->enemies2[i].speed = (float)cJSON_GetObjectItem(enemyItem, "speed")->valuedouble;
-        state->enemies2[i].platformIndex = cJSON_GetObjectItem(enemyItem, "platformIndex")->valueint;
-        strcpy(state->enemies2[i].textureLocation, cJSON_GetObjectItem(enemyItem, "textureLocation")->valuestring);
-        state->enemies2[i].frameWidth = cJSON_GetObjectItem(enemyItem, "spriteWidth")->valueint;
-        state->enemies2[i].frameHeight = cJSON_GetObjectItem(enemyItem, "spriteHeight")->valueint;
-        state->enemies2[i].totalFrames = cJSON_GetObjectItem(enemyItem, "totalFrames")->valueint;
-        state->enemies2[i].animationTimer = cJSON_GetObjectItem(enemyItem, "animationTimer")->valueint;
-        state->enemies2[i].frameDelay = cJSON_GetObjectItem(enemyItem, "frameDelay")->valueint;
-    }
-    printf("Enemy 2 data loaded\n");
-
-    // Load collectibles
-    cJSON* collectibles = cJSON_GetObjectItem(root, "collectibles");
-    int numCollectibles = cJSON_GetArraySize(collectibles);
-    state->collectibles = (Collectible*)malloc(numCollectibles * sizeof(Collectible));
-    state->numCollectibles = numCollectibles;
-    for (int i = 0; i < numCollectibles; i++) {
-        cJSON* collectibleItem = cJSON_GetArrayItem(collectibles, i);
-        state->collectibles[i].x = (float)cJSON_GetObjectItem(collectibleItem, "x")->valuedouble;
-        state->collectibles[i].y = (float)cJSON_GetObjectItem(collectibleItem, "y")->valuedouble;
-        state->collectibles[i].width = (float)cJSON_GetObjectItem(collectibleItem, "width")->valuedouble;
-        state->collectibles[i].height = (float)cJSON_GetObjectItem(collectibleItem, "height")->valuedouble;
-        state->collectibles[i].collected = cJSON_IsTrue(cJSON_GetObjectItem(collectibleItem, "collected"));
-    }
-    printf("Collectibles data loaded\n");
-
-    // Load ammos
-    cJSON* ammos = cJSON_GetObjectItem(root, "ammos");
-    int numAmmos = cJSON_GetArraySize(ammos);
-    state->ammos = (Collectible*)malloc(numAmmos * sizeof(Collectible));
-    state->numAmmos = numAmmos;
-    for (int i = 0; i < numAmmos; i++) {
-        cJSON* ammoItem = cJSON_GetArrayItem(ammos, i);
-        state->ammos[i].x = (float)cJSON_GetObjectItem(ammoItem, "x")->valuedouble;
-        state->ammos[i].y = (float)cJSON_GetObjectItem(ammoItem, "y")->valuedouble;
-        state->ammos[i].width = (float)cJSON_GetObjectItem(ammoItem, "width")->valuedouble;
-        state->ammos[i].height = (float)cJSON_GetObjectItem(ammoItem, "height")->valuedouble;
-        state->ammos[i].collected = cJSON_IsTrue(cJSON_GetObjectItem(ammoItem, "collected"));
-    }
-    printf("Ammos data loaded\n");
+    startSplitScreen(state);
+
+    // New background and platforms, recomposite the static layers on the next frame
+    if (state->worldCache) invalidateWorldCache(state->worldCache);
+    if (state->hud) state->hud->dirty = true;
 
     if (!loadMedia(state)) {
         printf("Failed to load media!\n");
         return;
     }
 
-    // Free JSON resources
-    cJSON_Delete(root);
-    free(data);
+    // Keep the freshly loaded level, with texture handles, for instant restarts
+    if (state->level) captureLevelTemplate(state->level, state, levelFile);
 }
 
 void cleanupGameState(GameData* state) {
     // Free allocated memory
-    if (state->platforms) {
-        free(state->platforms);
-        state->platforms = NULL;
+    if (state->world.platforms) {
+        free(state->world.platforms);
+        state->world.platforms = NULL;
+    }
+    if (state->world.sim) {
+        free(state->world.sim);
+        state->world.sim = NULL;
+    }
+    if (state->world.flow) {
+        free(state->world.flow);
+        state->world.flow = NULL;
     }
-    if (state->enemies1) {
-        free(state->enemies1);
-        state->enemies1 = NULL;
+    if (state->world.nav) {
+        free(state->world.nav);
+        state->world.nav = NULL;
     }
-    if (state->enemies2) {
-        free(state->enemies2);
-        state->enemies2 = NULL;
+    if (state->world.chunkSource) {
+        closeLevelStream((LevelStream*)state->world.chunkSource);
+        state->world.chunkSource = NULL;
+        state->world.chunks = NULL;
     }
-    if (state->collectibles) {
-        free(state->collectibles);
-        state->collectibles = NULL;
+    if (state->worldCache) {
+        invalidateWorldCache(state->worldCache);
     }
     
+    // Entity tables lived inside the simulation block
+    state->world.shooters = NULL;
+    state->world.bullets = NULL;
+    state->world.enemies1 = NULL;
+    state->world.enemies2 = NULL;
+    state->world.collectibles = NULL;
+    state->world.ammos = NULL;
+
     // Reset state variables
-    state->numPlatforms = 0;
-    state->numEnemies1 = 0;
-    state->numEnemies2 = 0;
-    state->numCollectibles = 0;
-    state->numAmmos = 0;
+    state->world.numPlatforms = 0;
+    state->world.numEnemies1 = 0;
+    state->world.numEnemies2 = 0;
+    state->world.numCollectibles = 0;
+    state->world.numAmmos = 0;
     state->isPaused = false;
     state->showSummaryWindow = false;
-
-    state->cameraX = 0.0f;
 }
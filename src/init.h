@@ -17,19 +17,15 @@
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
 
-#define WORLD_WIDTH 3000
-#define SHOOTER_SPEED 200
-#define JUMP_SPEED 600
-#define GRAVITY 680
-#define GROUND_LEVEL (1080 - 100)
-#define LEFT_BOUNDARY 0
-#define MAX_BULLETS 10
-#define MAX_HEALTH 3
-
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #include "cimgui.h"
 #include "imgui_impl_sdl.h"
+#include "imgui_impl_sdlrenderer.h"
 #include "imgui_impl_opengl3.h"
+#include "glrender.h"
+#include "sim.h"
+#include "fx.h"
+#include "eventbus.h"
 
 // Structure to hold save file information
 typedef struct {
@@ -40,87 +36,177 @@ typedef struct {
 typedef struct {
     float x, y;
     float width, height;
-} Platform;
+} PauseButton;
 
 typedef struct {
-    float x, y;
-    float width, height;
-} PauseButton;
+    float* sizes;
+    float* offsets;
+    int num_sizes;
+    float sigma;
+} HillNoise;
 
+#define CACHE_TILE_WIDTH 1024
+// Tiles kept for a streamed level, enough for both split-screen views
+#define CACHE_STREAM_TILES 8
+
+// Static world layers (background, hills, platforms) pre-composited into
+// CACHE_TILE_WIDTH wide render targets, rebuilt on level load and resize.
+// Tile t lives in slot t % numTiles: a whole level has a slot for every tile and
+// builds them all up front, a streamed one only CACHE_STREAM_TILES, each built
+// when it comes into view (its platforms are only resident by then).
 typedef struct {
-    float x, y;
-    int width, height;
-    float velocityY;
-    bool onGround;
-    int health;
-    int ammo;
-    int score;
-    double time;
-    char textureLocation[256];
+    SDL_Texture** tiles;
+    int* tileIndex;     // tile each slot holds, -1 until built
+    int numTiles;
+    int worldTiles;     // tiles across the whole level
+    int width, height;  // window size the tiles were built for
+    bool valid;
+
+    // Last world frame, shown under the menus while the game is paused
+    SDL_Texture* frozenFrame;
+    int frozenWidth, frozenHeight;
+    bool frozenValid;
+} WorldCache;
+
+#define INTERNAL_HEIGHT 360      // default internal resolution, 640x360 on a 16:9 window
+#define FRAME_BUDGET_MS 16.6f
+
+// World rendered into an internal target of window / scale pixels, then upscaled
+// by the integer factor scale. The governor raises scale when frames run over budget.
+typedef struct {
+    SDL_Texture* target;
+    SDL_Texture* previousTarget;
+    int width, height;          // internal resolution
+    int windowWidth, windowHeight;
+    int baseHeight;             // requested internal height, 0 for native
+    int scale;
+    int minScale, maxScale;
+    bool dynamic;
+    float budgetMs;
+    float workAvgMs;
+    int overBudgetFrames;
+    int underBudgetFrames;
+} RenderScaler;
+
+// One world sprite or fill of a split-screen frame, in world coordinates
+typedef struct {
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_Texture* texture;   // NULL fills dst with color
+    int page;               // GL atlas page
+    SDL_Color color;
+    Uint8 layer;            // painter's order between kinds of entity
+    Uint8 views;            // bit per viewport it shows in
+    int order;              // submission index, keeps the sort stable
+} SplitItem;
+
+// Split-screen draw list. Entities are culled against both cameras and animated
+// once, the list is sorted by layer and sheet, and each viewport draws its share
+// of the same list (the GL path uploads it once and draws it through both views).
+typedef struct {
+    SplitItem* items;
+    int count;
+    int capacity;
+    float cameraX[2];
+    SDL_Rect viewports[2];  // window pixels
+    int shared;             // items both views show, culled and animated once for the two
+} SplitBatch;
+
+#define MAX_SPRITES 32
+
+// Worker threads decoding images for loadMedia and loadSprite, see decodepool.h
+typedef struct DecodePool DecodePool;
+
+// Sprite sheet loaded once per path; entities refer to it by index so the
+// simulation state carries no texture pointers or path strings
+typedef struct {
+    char path[256];
     SDL_Texture* texture;
-    int currentFrame;
-    int frameWidth;          
-    int frameHeight;         
-    int totalFrames; 
-    float animationTimer;
-    float frameDelay;
-    bool dead;
-} Shooter;
+    int page;               // GL atlas page, -1 on the SDL_Renderer path
+    bool loaded;
+} SpriteSheet;
 
+// Pristine copy of the last parsed level with its sprites already resolved.
+// Restart and the turn handoff copy it back instead of reloading the level file.
 typedef struct {
-    float x, y;              
-    int width, height;       
-    bool active;   
-    int platformIndex;       
-    int currentFrame;        
-    float speed;      
-    char textureLocation[256];       
-    SDL_Texture* texture;    
-    int frameWidth;          
-    int frameHeight;         
-    int totalFrames; 
-    float animationTimer;
-    float frameDelay;        
-} Enemy;
+    char path[256];
+    bool valid;
+    float deltaTime;
+    SimState* sim;
+    Platform* platforms;    // level geometry, never changes during play
+    int numPlatforms;
+} LevelTemplate;
 
+// HUD text on the SDL_Renderer path. The turn, score and ammo lines only change
+// on score, shot and pickup events, so their textures are kept until one of those
+// (or a level reset, rollback or spectator frame) marks them dirty.
 typedef struct {
+    SimEventCursor events;
+    bool dirty;
+    int player;             // whose stats the textures show
+    SDL_Texture* lines[3];
+    SDL_Rect rects[3];
+    int rebuilds;
+} HudCache;
+
+// Player 1's recorded run, drawn faded behind player 2 (see replay.c)
+typedef struct {
+    bool visible;
     float x, y;
-    int width, height;
-    bool collected;
-} Collectible;
+    int currentFrame;
+} Ghost;
 
-typedef struct {
-    float x, y;  
-    float speed; 
-    bool active; 
-    float dirX, dirY;
-    float lifespan;
-} Bullet;
+#define STATS_HISTORY 240
 
+// Frame pacing samples, shown by the stats overlay (F3)
 typedef struct {
-    float* sizes;
-    float* offsets;
-    int num_sizes;
-    float sigma;
-} HillNoise;
+    float frameMs[STATS_HISTORY];   // present-to-present interval
+    float presentMs[STATS_HISTORY]; // time spent inside SDL_RenderPresent (vsync wait)
+    int head;
+    int count;
+    Uint64 frameStart;
+    Uint64 lastPresent;
+    Uint64 totalFrames;
+    Uint64 totalPresents;
+    double totalFrameMs;
+    double totalFrameMsSq;  // for the interval jitter in the exit summary
+    double totalPresentMs;
+    float worstFrameMs;
+    const char* backend;
+    int drawCalls;          // GL backend only
+    int sprites;
+    float workMs;           // frame start until present, without the vsync wait
+    int internalWidth, internalHeight, upscale;
+    int lowestHeight, highestHeight;    // internal heights played at, for the exit summary
+    SimLodStats lod[SIM_LOD_TIERS];     // enemy simulation tiers on the last tick
+    int splitItems, splitShared;        // split screen: entities drawn, and how many both views show
+    int levelResets;                    // restarts served from the in-memory template
+    double levelResetMs;
+    bool showOverlay;
+
+    // Process CPU time against wall time, split by idle (menu/pause/summary) and active frames
+    bool idle;
+    clock_t lastClock;
+    Uint64 lastSample;
+    double windowCpuSec, windowWallSec;
+    float cpuPercent;
+    double idleCpuSec, idleWallSec;
+    double activeCpuSec, activeWallSec;
+} FrameStats;
 
 typedef struct {
-    Shooter* shooters;
-    Platform* platforms;
-    int numPlatforms;
-    Enemy* enemies1;
-    int numEnemies1;
-    Enemy* enemies2;
-    int numEnemies2;
-    Collectible* collectibles;
-    int numCollectibles;
-    Collectible* ammos;
-    int numAmmos;
-    Bullet bullets[100];
-    float cameraX;
-    int ammo;
+    SimContext world;       // everything the simulation reads and writes, see sim.h
 
     PauseButton* pauseButton;
+    FrameStats* stats;
+    WorldCache* worldCache;
+    RenderScaler* scaler;
+    LevelTemplate* level;
+    FxPool* fx;
+    HudCache* hud;
+    SplitBatch* split;
+    DecodePool* decode;     // NULL decodes on the main thread
+    Ghost ghost;
 
     float deltaTime;
     Uint32 lastTime;
@@ -128,7 +214,7 @@ typedef struct {
     bool showSummaryWindow;
     bool showLevelSelection;
     bool quit;
-    bool isPlayer1Turn;
+    bool splitScreen;       // levels start as local versus, one viewport per player (--split)
     int selectedLevelIndex;
     char** levelFiles;
     int levelCount;
@@ -139,12 +225,28 @@ typedef struct {
     SDL_Texture* backgroundTexture;
     SDL_Texture* pauseTexture;
     SDL_Texture* bulletSpriteSheet;
+    SDL_Texture* fxSheets[FX_SHEETS];
+    SpriteSheet sprites[MAX_SPRITES];
+    int numSprites;
+
+    // Optional instanced OpenGL backend for the game world (--gl)
+    bool useGL;
+    SDL_GLContext glContext;
+    GLRenderer* gl;
+    int backgroundPage;
+    int pausePage;
+    int bulletPage;
+    int fxPages[FX_SHEETS];
+    bool fxLoaded;
 } GameData;
 
 bool init(GameData* g);
 bool loadMedia(GameData* g);
+int loadSprite(GameData* g, const char* path);
 void clear(GameData* g);
 void initializeGame(GameData* state, const char* levelFile, int screen_width, int screen_height);
 void cleanupGameState(GameData* state);
+void resetLevel(GameData* state, const char* levelFile, int screen_width, int screen_height);
+void freeLevelTemplate(LevelTemplate* level);
 
 #endif
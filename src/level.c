@@ -0,0 +1,439 @@
+// pthreads are POSIX, hidden by -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include "level.h"
+#include "stream.h"
+#include "schema.h"
+#include <math.h>
+#include <pthread.h>
+#include <cjson/cJSON.h>
+
+// Whole file as a string, NULL when it cannot be opened
+static char* readTextFile(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = (char*)malloc(length + 1);
+    if (data) {
+        size_t read = fread(data, 1, length, file);
+        data[read] = '\0';
+    }
+    fclose(file);
+    return data;
+}
+
+static float numberOr(const cJSON* item, const char* key, float fallback) {
+    const cJSON* value = cJSON_GetObjectItem(item, key);
+    return cJSON_IsNumber(value) ? (float)value->valuedouble : fallback;
+}
+
+// Reads count entries of a level array through schema, reporting every entry
+// that does not read (or is missing) before failing
+static bool readEntities(const EntitySchema* schema, const cJSON* array, void* entities, size_t size, int count,
+                         LevelSpriteResolver resolveSprite, void* userData, const char* levelFile, const char* name) {
+    bool ok = true;
+    const cJSON* item = array ? array->child : NULL;
+    for (int i = 0; i < count; i++) {
+        char where[320];
+        snprintf(where, sizeof(where), "%s: %s[%d]", levelFile, name, i);
+        if (!readEntity(schema, item, (char*)entities + i * size, false, resolveSprite, userData, where)) ok = false;
+        if (item) item = item->next;
+    }
+    return ok;
+}
+
+// Streamed levels: chunk files, the chunks generated where there are none, and
+// a small cache of decoded chunks that a background thread fills ahead of the camera
+
+// Resident chunks, the next one being prefetched and a few behind to walk back into
+#define LEVEL_CHUNK_CACHE (STREAM_RESIDENT + 4)
+
+typedef struct {
+    int index;              // chunk held, -1 for none
+    uint32_t used;          // last read, the least recent entry is replaced
+    bool prefetched;        // decoded ahead and not read yet
+    LevelChunk chunk;
+} ChunkCacheEntry;
+
+struct LevelStream {
+    // Set at load, read only afterwards
+    char directory[256];
+    int numChunks;
+    uint32_t seed;
+    Enemy enemy1, enemy2;           // every chunk entry is stamped from these
+    Collectible collectible, ammo;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;            // a prefetch request, or stop
+    pthread_cond_t decoded;         // the prefetch thread finished a chunk
+    pthread_t thread;
+    bool threadStarted;
+    bool stop;
+    int request;                    // chunk for the thread to decode, -1 for none
+    int decoding;                   // chunk it is decoding now, -1 when idle
+    uint32_t clock;
+    ChunkCacheEntry cache[LEVEL_CHUNK_CACHE];
+    LevelChunk scratch;             // prefetch thread only
+
+    int reads;
+    int prefetchHits;               // reads served by a chunk decoded ahead
+    int onDemand;                   // reads that had to decode on the simulation thread
+};
+
+// Chunk file entries are placed relative to the chunk's left edge, as the chunk
+// is handed out, and stamped from the level's templates: an entry only gives
+// what differs, usually its position (and a speed). Entries that do not read are
+// left out of the chunk.
+static void readChunkFile(const LevelStream* stream, const cJSON* root, const char* path, LevelChunk* out) {
+    const cJSON* item;
+    char where[360];
+    int i = 0;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "platforms")) {
+        if (out->numPlatforms >= STREAM_CHUNK_PLATFORMS) break;
+        snprintf(where, sizeof(where), "%s: platforms[%d]", path, i++);
+        if (readEntity(&platformSchema, item, &out->platforms[out->numPlatforms], false, NULL, NULL, where)) {
+            out->numPlatforms++;
+        }
+    }
+    for (int list = 0; list < 2; list++) {
+        Enemy* enemies = list ? out->enemies2 : out->enemies1;
+        int* count = list ? &out->numEnemies2 : &out->numEnemies1;
+        const char* name = list ? "enemies2" : "enemies1";
+        i = 0;
+        cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, name)) {
+            if (*count >= STREAM_CHUNK_ENEMIES) break;
+            Enemy* enemy = &enemies[*count];
+            *enemy = list ? stream->enemy2 : stream->enemy1;
+            // Platform indices count within the chunk, the template's means nothing here
+            enemy->x = 0.0f;
+            enemy->platformIndex = -1;
+            snprintf(where, sizeof(where), "%s: %s[%d]", path, name, i++);
+            if (readEntity(&enemySchema, item, enemy, true, NULL, NULL, where)) (*count)++;
+        }
+    }
+    for (int list = 0; list < 2; list++) {
+        Collectible* pickups = list ? out->ammos : out->collectibles;
+        int* count = list ? &out->numAmmos : &out->numCollectibles;
+        const char* name = list ? "ammos" : "collectibles";
+        i = 0;
+        cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, name)) {
+            if (*count >= STREAM_CHUNK_PICKUPS) break;
+            Collectible* pickup = &pickups[*count];
+            *pickup = list ? stream->ammo : stream->collectible;
+            pickup->x = 0.0f;
+            snprintf(where, sizeof(where), "%s: %s[%d]", path, name, i++);
+            if (readEntity(&collectibleSchema, item, pickup, true, NULL, NULL, where)) (*count)++;
+        }
+    }
+}
+
+// Low platforms a jump up from the ground, now and then a higher one off the end
+// of a low one, crabs on some, a ghost or two, pickups over them. The first chunk
+// is left clear for the start and the last for the run to the flag.
+static void generateChunk(const LevelStream* stream, int index, LevelChunk* out) {
+    const float low = GROUND_LEVEL - 100.0f, high = GROUND_LEVEL - 280.0f;
+    uint32_t random = (stream->seed * 2654435761u) ^ ((uint32_t)(index + 1) * 40503u);
+    if (random == 0) random = 1;
+    for (int i = 0; i < 4; i++) simRandom(&random);
+
+    if (index > 0 && index < stream->numChunks - 1) {
+        float x = 100.0f + simRandomFloat(&random) * 150.0f;
+        while (out->numPlatforms < STREAM_CHUNK_PLATFORMS - 1) {
+            float width = 220.0f + simRandomFloat(&random) * 200.0f;
+            if (x + width > STREAM_CHUNK_WIDTH - 60.0f) break;
+            out->platforms[out->numPlatforms++] = (Platform){x, low, width, 50.0f};
+            if (simRandomFloat(&random) < 0.35f) {
+                float upper = fminf(220.0f, STREAM_CHUNK_WIDTH - 60.0f - (x + width * 0.6f));
+                if (upper >= 160.0f) out->platforms[out->numPlatforms++] = (Platform){x + width * 0.6f, high, upper, 50.0f};
+            }
+            x += width + 150.0f + simRandomFloat(&random) * 200.0f;
+        }
+    }
+
+    for (int p = 0; p < out->numPlatforms; p++) {
+        const Platform* platform = &out->platforms[p];
+        if (simRandomFloat(&random) < 0.5f && out->numEnemies2 < STREAM_CHUNK_ENEMIES) {
+            Enemy* enemy = &out->enemies2[out->numEnemies2++];
+            *enemy = stream->enemy2;
+            enemy->x = platform->x + (platform->width - enemy->width) * simRandomFloat(&random);
+            enemy->y = platform->y - enemy->height;
+            enemy->platformIndex = p;
+        }
+        if (out->numCollectibles < STREAM_CHUNK_PICKUPS) {
+            Collectible* pickup = &out->collectibles[out->numCollectibles++];
+            *pickup = stream->collectible;
+            pickup->x = platform->x + platform->width / 2.0f;
+            pickup->y = platform->y - 60.0f;
+        }
+    }
+    if (index > 0 && simRandomFloat(&random) < 0.6f) {
+        Enemy* enemy = &out->enemies1[out->numEnemies1++];
+        *enemy = stream->enemy1;
+        enemy->x = simRandomFloat(&random) * (STREAM_CHUNK_WIDTH - enemy->width);
+        enemy->y = 250.0f + simRandomFloat(&random) * 250.0f;
+    }
+    if (index % 2 == 1) {
+        Collectible* ammo = &out->ammos[out->numAmmos++];
+        *ammo = stream->ammo;
+        ammo->x = STREAM_CHUNK_WIDTH / 2.0f;
+        ammo->y = GROUND_LEVEL + 100.0f - ammo->height - 10.0f;
+    }
+}
+
+// <directory>/chunk-NNNN.json when there is one, generated from the level seed
+// otherwise, with the chunk's nav graph so the simulation only has to stitch it in.
+// Touches nothing in the stream that changes after load, so any thread can call it.
+static void decodeChunk(const LevelStream* stream, int index, LevelChunk* out) {
+    memset(out, 0, sizeof(*out));
+    char path[300];
+    snprintf(path, sizeof(path), "%s/chunk-%04d.json", stream->directory, index);
+    char* data = stream->directory[0] ? readTextFile(path) : NULL;
+    if (data == NULL) {
+        generateChunk(stream, index, out);
+    } else {
+        cJSON* root = cJSON_Parse(data);
+        if (root) {
+            readChunkFile(stream, root, path, out);
+            cJSON_Delete(root);
+        } else {
+            fprintf(stderr, "Error parsing %s, the chunk plays empty\n", path);
+        }
+        free(data);
+    }
+    buildNavChunk(&out->nav, out->platforms, out->numPlatforms);
+}
+
+static ChunkCacheEntry* findCachedChunk(LevelStream* stream, int index) {
+    for (int i = 0; i < LEVEL_CHUNK_CACHE; i++) {
+        if (stream->cache[i].index == index) return &stream->cache[i];
+    }
+    return NULL;
+}
+
+static ChunkCacheEntry* storeChunk(LevelStream* stream, int index, const LevelChunk* chunk) {
+    ChunkCacheEntry* entry = findCachedChunk(stream, index);
+    for (int i = 0; entry == NULL && i < LEVEL_CHUNK_CACHE; i++) {
+        if (stream->cache[i].index < 0) entry = &stream->cache[i];
+    }
+    for (int i = 0; entry == NULL && i < LEVEL_CHUNK_CACHE; i++) {
+        if (i == 0 || stream->cache[i].used < entry->used) entry = &stream->cache[i];
+    }
+    if (entry == NULL) entry = &stream->cache[0];
+    entry->index = index;
+    entry->chunk = *chunk;
+    entry->used = ++stream->clock;
+    entry->prefetched = false;
+    return entry;
+}
+
+static void* prefetchChunks(void* arg) {
+    LevelStream* stream = (LevelStream*)arg;
+    pthread_mutex_lock(&stream->lock);
+    while (!stream->stop) {
+        if (stream->request < 0) {
+            pthread_cond_wait(&stream->wake, &stream->lock);
+            continue;
+        }
+        int index = stream->request;
+        stream->request = -1;
+        if (findCachedChunk(stream, index)) continue;
+
+        stream->decoding = index;
+        pthread_mutex_unlock(&stream->lock);
+        decodeChunk(stream, index, &stream->scratch);
+        pthread_mutex_lock(&stream->lock);
+        storeChunk(stream, index, &stream->scratch)->prefetched = true;
+        stream->decoding = -1;
+        pthread_cond_broadcast(&stream->decoded);
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+bool readLevelChunk(void* source, int index, LevelChunk* out) {
+    LevelStream* stream = (LevelStream*)source;
+    if (stream == NULL || index < 0 || index >= stream->numChunks) return false;
+
+    pthread_mutex_lock(&stream->lock);
+    // Already on its way in: wait rather than read the file twice
+    while (stream->decoding == index) pthread_cond_wait(&stream->decoded, &stream->lock);
+    ChunkCacheEntry* entry = findCachedChunk(stream, index);
+    if (entry) {
+        if (entry->prefetched) stream->prefetchHits++;
+        entry->prefetched = false;
+        entry->used = ++stream->clock;
+        *out = entry->chunk;
+    } else {
+        pthread_mutex_unlock(&stream->lock);
+        decodeChunk(stream, index, out);
+        pthread_mutex_lock(&stream->lock);
+        storeChunk(stream, index, out);
+        stream->onDemand++;
+    }
+    stream->reads++;
+
+    // Levels run to the right, have the next chunk decoded before the camera gets there
+    int next = index + 1;
+    if (stream->threadStarted && next < stream->numChunks && stream->decoding != next && !findCachedChunk(stream, next)) {
+        stream->request = next;
+        pthread_cond_signal(&stream->wake);
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return true;
+}
+
+// Templates and chunk directory from the level's "stream" object. The templates'
+// sprites are resolved here, on the loading thread, so chunks never need to.
+static LevelStream* openLevelStream(const cJSON* streamItem, const char* levelFile,
+                                    LevelSpriteResolver resolveSprite, void* userData) {
+    LevelStream* stream = (LevelStream*)calloc(1, sizeof(LevelStream));
+    if (stream == NULL) return NULL;
+    const char* templates[] = {"enemy1", "enemy2", "collectible", "ammo"};
+    void* entities[] = {&stream->enemy1, &stream->enemy2, &stream->collectible, &stream->ammo};
+    bool ok = true;
+    for (int i = 0; i < 4; i++) {
+        char where[320];
+        snprintf(where, sizeof(where), "%s: stream.%s", levelFile, templates[i]);
+        if (!readEntity(i < 2 ? &enemySchema : &collectibleSchema, cJSON_GetObjectItem(streamItem, templates[i]),
+                        entities[i], false, resolveSprite, userData, where)) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        free(stream);
+        return NULL;
+    }
+    float worldWidth = numberOr(streamItem, "worldWidth", WORLD_WIDTH);
+    stream->numChunks = (int)ceilf(worldWidth / STREAM_CHUNK_WIDTH);
+    stream->seed = (uint32_t)numberOr(streamItem, "seed", 1.0f);
+    const cJSON* directory = cJSON_GetObjectItem(streamItem, "chunks");
+    if (cJSON_IsString(directory)) snprintf(stream->directory, sizeof(stream->directory), "%s", directory->valuestring);
+
+    for (int i = 0; i < LEVEL_CHUNK_CACHE; i++) stream->cache[i].index = -1;
+    stream->request = -1;
+    stream->decoding = -1;
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->wake, NULL);
+    pthread_cond_init(&stream->decoded, NULL);
+    // Without the thread every chunk is decoded on demand, slower but the same chunks
+    stream->threadStarted = pthread_create(&stream->thread, NULL, prefetchChunks, stream) == 0;
+    return stream;
+}
+
+void closeLevelStream(LevelStream* stream) {
+    if (stream == NULL) return;
+    if (stream->threadStarted) {
+        pthread_mutex_lock(&stream->lock);
+        stream->stop = true;
+        pthread_cond_signal(&stream->wake);
+        pthread_mutex_unlock(&stream->lock);
+        pthread_join(stream->thread, NULL);
+    }
+    printf("Level stream: %d chunk reads, %d prefetched ahead, %d decoded on demand\n",
+           stream->reads, stream->prefetchHits, stream->onDemand);
+    pthread_cond_destroy(&stream->decoded);
+    pthread_cond_destroy(&stream->wake);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream);
+}
+
+// Parses levelFile into a fresh simulation block and platform array. Sprite paths
+// go through resolveSprite (may be NULL) so the caller decides what an index means.
+bool loadLevelData(const char* levelFile, LevelData* level, LevelSpriteResolver resolveSprite, void* userData) {
+    // Read file content into a string
+    char* data = readTextFile(levelFile);
+    if (!data) {
+        fprintf(stderr, "Error opening %s\n", levelFile);
+        return false;
+    }
+
+    // Parse JSON data
+    cJSON* root = cJSON_Parse(data);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON: %s\n", cJSON_GetErrorPtr());
+        free(data);
+        return false;
+    }
+
+    // One block holds all mutable state, sized from the level's entity counts,
+    // or from the resident slots when the level is streamed in chunks
+    cJSON* streamItem = cJSON_GetObjectItem(root, "stream");
+    cJSON* enemies1 = cJSON_GetObjectItem(root, "enemies1");
+    cJSON* enemies2 = cJSON_GetObjectItem(root, "enemies2");
+    cJSON* collectibles = cJSON_GetObjectItem(root, "collectibles");
+    cJSON* ammos = cJSON_GetObjectItem(root, "ammos");
+    LevelStream* stream = streamItem ? openLevelStream(streamItem, levelFile, resolveSprite, userData) : NULL;
+    SimState* sim = NULL;
+    if (stream) {
+        sim = createStreamedSimState(stream->numChunks, numberOr(streamItem, "worldWidth", WORLD_WIDTH));
+    } else if (!streamItem) {
+        sim = createSimState(cJSON_GetArraySize(enemies1), cJSON_GetArraySize(enemies2),
+                             cJSON_GetArraySize(collectibles), cJSON_GetArraySize(ammos));
+    }
+    if (!sim) {
+        fprintf(stderr, "Error allocating simulation state\n");
+        closeLevelStream(stream);
+        cJSON_Delete(root);
+        free(data);
+        return false;
+    }
+    SimContext world = {0};
+    bindSimState(&world, sim);
+
+    level->deltaTime = numberOr(root, "deltaTime", SIM_DT);
+    sim->isPlayer1Turn = cJSON_IsTrue(cJSON_GetObjectItem(root, "isPlayer1Turn"));
+
+    // Both shooters, however the turns start
+    bool ok = readEntities(&shooterSchema, cJSON_GetObjectItem(root, "shooters"), world.shooters, sizeof(Shooter), 2,
+                           resolveSprite, userData, levelFile, "shooters");
+
+    if (stream) {
+        // Fixed slots for the resident chunks, filled by the first streaming pass,
+        // which also builds the nav graph over them
+        world.numPlatforms = STREAM_RESIDENT * STREAM_CHUNK_PLATFORMS;
+        world.platforms = (Platform*)calloc(world.numPlatforms, sizeof(Platform));
+        world.chunks = readLevelChunk;
+        world.chunkSource = stream;
+        if (ok && world.platforms) updateStreaming(&world);
+    } else {
+        cJSON* platforms = cJSON_GetObjectItem(root, "platforms");
+        world.numPlatforms = cJSON_GetArraySize(platforms);
+        world.platforms = (Platform*)malloc((world.numPlatforms > 0 ? world.numPlatforms : 1) * sizeof(Platform));
+        // Every table is read so one load reports every bad entry
+        if (world.platforms == NULL || !readEntities(&platformSchema, platforms, world.platforms, sizeof(Platform),
+                                                     world.numPlatforms, NULL, NULL, levelFile, "platforms")) ok = false;
+        if (!readEntities(&enemySchema, enemies1, world.enemies1, sizeof(Enemy), world.numEnemies1,
+                          resolveSprite, userData, levelFile, "enemies1")) ok = false;
+        if (!readEntities(&enemySchema, enemies2, world.enemies2, sizeof(Enemy), world.numEnemies2,
+                          resolveSprite, userData, levelFile, "enemies2")) ok = false;
+        if (!readEntities(&collectibleSchema, collectibles, world.collectibles, sizeof(Collectible), world.numCollectibles,
+                          NULL, NULL, levelFile, "collectibles")) ok = false;
+        if (!readEntities(&collectibleSchema, ammos, world.ammos, sizeof(Collectible), world.numAmmos,
+                          NULL, NULL, levelFile, "ammos")) ok = false;
+    }
+    cJSON_Delete(root);
+    free(data);
+    if (!ok) {
+        fprintf(stderr, "%s not loaded\n", levelFile);
+        free(world.platforms);
+        free(world.nav);
+        closeLevelStream(stream);
+        free(sim);
+        return false;
+    }
+
+    level->sim = sim;
+    level->platforms = world.platforms;
+    level->numPlatforms = world.numPlatforms;
+    level->stream = stream;
+    if (stream) {
+        level->nav = world.nav;
+        printf("Streaming %d chunks over %.0f px\n", sim->numChunks, sim->worldWidth);
+    } else {
+        level->nav = buildNavGraph(world.platforms, world.numPlatforms, LEFT_BOUNDARY, sim->worldWidth);
+    }
+    printf("Level data loaded from %s\n", levelFile);
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simstate.h"
+#include "navgraph.h"
+
+// Maps a sprite path from the level file to whatever index the caller uses
+typedef int (*LevelSpriteResolver)(void* userData, const char* path);
+
+// Chunks of a streamed level and the thread that decodes them ahead of the camera
+typedef struct LevelStream LevelStream;
+
+// A parsed level file, owned by the caller
+typedef struct {
+    SimState* sim;
+    Platform* platforms;
+    int numPlatforms;
+    NavGraph* nav;          // spans and jumps over the platforms, solved at load
+    float deltaTime;
+    LevelStream* stream;    // NULL when the level is resident whole
+} LevelData;
+
+// A level with a "stream" object is streamed in chunks of STREAM_CHUNK_WIDTH:
+//
+//   "stream": {"worldWidth": 102400, "seed": 7, "chunks": "levels/long",
+//              "enemy1": {...}, "enemy2": {...}, "collectible": {...}, "ammo": {...}}
+//
+// The four templates are entries as in the level's own arrays. Chunk n is read from
+// <chunks>/chunk-NNNN.json, with "platforms" as usual and "enemies1", "enemies2",
+// "collectibles" and "ammos" entries stamped from the templates and giving only
+// what differs, usually x (from the chunk's left edge), y and maybe speed and
+// platformIndex (within the chunk). Chunks without a file are generated from the
+// seed. Contexts stepping the level take readLevelChunk and the stream as their
+// ChunkProvider and source.
+bool loadLevelData(const char* levelFile, LevelData* level, LevelSpriteResolver resolveSprite, void* userData);
+// ChunkProvider over a LevelStream, safe to call from several simulation threads
+bool readLevelChunk(void* stream, int chunk, LevelChunk* out);
+void closeLevelStream(LevelStream* stream);
+
+#endif
@@ -2,9 +2,126 @@
 #include "gui.h"
 #include "render.h"
 #include "shooter.h"
+#include "stats.h"
+#include "worldcache.h"
+#include "scaler.h"
+#include "simstate.h"
+#include "stream.h"
+#include "netplay.h"
+#include "spectate.h"
+#include "replay.h"
+#include "bot.h"
+#include "telemetry.h"
+#include "audio.h"
+#include "hotreload.h"
+#include "decodepool.h"
+
+// Wake up at least this often on static screens even without input
+#define IDLE_WAKE_MS 1000
+// Frames to keep drawing after input so ImGui hover/click states can settle
+#define IDLE_SETTLE_FRAMES 3
+
+// Most fixed ticks a netplay frame may run to catch up
+#define NET_MAX_STEPS_PER_FRAME 4
+
+// Main menu, pause and summary screens: nothing animates, so the loop can block on input
+static bool isIdleScreen(GameData* g) {
+    return g->showLevelSelection || g->isPaused || g->showSummaryWindow;
+}
 
 int main(int argc, char* argv[]) {
-    GameData g;
+    GameData g = {0};
+    g.world.seed = 1;
+    int internalHeight = INTERNAL_HEIGHT;
+    bool dynamicResolution = false;
+    const char* netHost = NULL;
+    int netPlayer = 1, netLocalPort = 0, netRemotePort = 0, inputDelay = 2, netLevel = 0;
+    float shimLatency = 0.0f, shimJitter = 0.0f, shimLoss = 0.0f;
+    const char* spectateHost = NULL;
+    int spectateServerPort = 0, spectatePort = 0;
+    bool botPlayer = false;
+    const char* telemetryPath = NULL;
+    bool audioEnabled = true;
+    bool watchLevels = false;
+    int decodeThreads = SDL_GetCPUCount();
+    bool benchDecode = false;
+    float quitAfter = 0.0f;
+    // --gl draws the world through the instanced OpenGL backend,
+    // LIBGL_ALWAYS_SOFTWARE=1 runs it on Mesa's llvmpipe for machines without a GPU
+    // --res <height> sets the internal world resolution (0 for native), --dynres lets it follow frame time
+    // --bench-snapshot prints simulation snapshot/restore cost against entity count and exits,
+    // --bench-precision walks a streamed level from x = 10^7 and prints the worst per-tick position error
+    // --bench-lod steps thousands of flyers over the LOD budgets and fails if any goes too long unmoved
+    // --netplay <1|2> <localPort> <host> <remotePort> plays versus against another process with rollback,
+    // --input-delay <ticks>, --netsim <latencyMs> <jitterMs> <lossPercent> and --level <n> tune it
+    // --seed <n> picks the hill layout and the simulation PRNG seed
+    // --spectate-server <port> streams the running game to spectators,
+    // --spectate <host> <port> watches one (pass the same --level), --bench-spectate measures the cost per client
+    // --bot hands the local controls to the computer player and cycles through the levels unattended
+    // --telemetry <file.csv> logs every gameplay event from a writer thread, --bench-events measures the event bus
+    // --split plays local versus side by side: A/D/W and the mouse on the left half for player 1,
+    // the arrows and Enter for player 2 (with --bot the computer takes player 2)
+    // --no-audio starts silent, --audio-test plays every effect for a few seconds and prints the mixer cost
+    // --watch patches edits to the level being played in as its file is saved
+    // --decode-threads <n> decodes images on n threads (default one per core, 0 on the main thread),
+    // --bench-decode prints the image load time at 1, 4 and 16 threads and exits
+    // --quit-after <seconds> exits after that long, for timed runs of the exit summary (e.g. idle CPU at the menu)
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--gl") == 0) g.useGL = true;
+        else if (strcmp(argv[i], "--res") == 0 && i + 1 < argc) internalHeight = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--dynres") == 0) dynamicResolution = true;
+        else if (strcmp(argv[i], "--netplay") == 0 && i + 4 < argc) {
+            netPlayer = atoi(argv[++i]);
+            netLocalPort = atoi(argv[++i]);
+            netHost = argv[++i];
+            netRemotePort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--input-delay") == 0 && i + 1 < argc) inputDelay = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) netLevel = atoi(argv[++i]) - 1;
+        else if (strcmp(argv[i], "--netsim") == 0 && i + 3 < argc) {
+            shimLatency = (float)atof(argv[++i]);
+            shimJitter = (float)atof(argv[++i]);
+            shimLoss = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) g.world.seed = (Uint32)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--bot") == 0) botPlayer = true;
+        else if (strcmp(argv[i], "--spectate-server") == 0 && i + 1 < argc) spectateServerPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spectate") == 0 && i + 2 < argc) {
+            spectateHost = argv[++i];
+            spectatePort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-spectate") == 0) {
+            runSpectatorBenchmark();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--bench-snapshot") == 0) {
+            runSnapshotBenchmark();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--bench-precision") == 0) {
+            runPrecisionBenchmark();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--bench-lod") == 0) {
+            return runLodBenchmark() ? 0 : 1;
+        }
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetryPath = argv[++i];
+        else if (strcmp(argv[i], "--bench-events") == 0) {
+            runEventBenchmark();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--split") == 0) g.splitScreen = true;
+        else if (strcmp(argv[i], "--no-audio") == 0) audioEnabled = false;
+        else if (strcmp(argv[i], "--watch") == 0) watchLevels = true;
+        else if (strcmp(argv[i], "--decode-threads") == 0 && i + 1 < argc) decodeThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench-decode") == 0) benchDecode = true;
+        else if (strcmp(argv[i], "--quit-after") == 0 && i + 1 < argc) quitAfter = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--audio-test") == 0) {
+            runAudioTest();
+            return 0;
+        }
+    }
+
     HillNoise hn_instance = {
         .sizes = NULL, 
         .offsets = NULL,
@@ -22,7 +139,7 @@ int main(int argc, char* argv[]) {
     SDL_GetWindowSize(g.window, &screen_width, &screen_height);
 
     float terrainSizes[] = {50.0f, 100.0f, 200.0f};
-    initHillNoise(hn, terrainSizes, sizeof(terrainSizes) / sizeof(terrainSizes[0]));
+    initHillNoise(hn, terrainSizes, sizeof(terrainSizes) / sizeof(terrainSizes[0]), g.world.seed);
 
     SDL_Event e;
     g.levelFiles = NULL;
@@ -33,6 +150,14 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (benchDecode) {
+        runDecodeBenchmark(&g);
+        freeLevelFiles(g.levelFiles, g.levelCount);
+        clear(&g);
+        SDL_Quit();
+        return 0;
+    }
+
     g.showLevelSelection = true;
     g.selectedLevelIndex = 0;
 
@@ -44,33 +169,210 @@ int main(int argc, char* argv[]) {
     };
     g.pauseButton = &pauseButton_instance;
 
+    FrameStats stats_instance = {0};
+    stats_instance.backend = g.useGL ? "OpenGL instanced" : "SDL_Renderer";
+    g.stats = &stats_instance;
+
+    WorldCache worldCache_instance = {0};
+    g.worldCache = &worldCache_instance;
+
+    RenderScaler scaler_instance;
+    configureScaler(&scaler_instance, internalHeight, dynamicResolution);
+    g.scaler = &scaler_instance;
+
+    LevelTemplate level_instance = {0};
+    g.level = &level_instance;
+
+    FxPool fx_instance;
+    resetFx(&fx_instance);
+    g.fx = &fx_instance;
+
+    HudCache hud_instance = {0};
+    hud_instance.dirty = true;
+    g.hud = &hud_instance;
+
+    SplitBatch split_instance = {0};
+    g.split = &split_instance;
+
+    // The queue is large, so the log lives on the heap like the spectator roles
+    Telemetry* telemetry = NULL;
+    if (telemetryPath) {
+        telemetry = (Telemetry*)malloc(sizeof(Telemetry));
+        if (!telemetry || !telemetryStart(telemetry, telemetryPath)) return 1;
+    }
+
+    // Images decode on the pool's threads and are uploaded by the frame loop
+    DecodePool* decodePool = NULL;
+    if (decodeThreads > 0) {
+        decodePool = (DecodePool*)malloc(sizeof(DecodePool));
+        if (decodePool && decodePoolStart(decodePool, decodeThreads)) {
+            g.decode = decodePool;
+        } else {
+            free(decodePool);
+            decodePool = NULL;
+        }
+    }
+
+    // Level edits are parsed on the watcher's thread and patched in between frames
+    LevelWatcher* watcher = NULL;
+    if (watchLevels) {
+        watcher = (LevelWatcher*)malloc(sizeof(LevelWatcher));
+        if (!watcher || !levelWatcherStart(watcher, "levels")) return 1;
+    }
+
+    // Music ring and decoded effects are large as well; without a device the game runs silent
+    AudioEngine* audio = NULL;
+    if (audioEnabled) {
+        audio = (AudioEngine*)malloc(sizeof(AudioEngine));
+        if (audio) {
+            audioStart(audio);
+            attachEventCursor(&g.world, &audio->events);
+        }
+    }
+
+    // Versus over the network skips the menu and starts both peers on the same level
+    NetSession net_instance;
+    NetSession* net = NULL;
+    if (netHost) {
+        if (!netplayStart(&net_instance, netPlayer - 1, netLocalPort, netHost, netRemotePort, inputDelay)) {
+            return 1;
+        }
+        net = &net_instance;
+        netplaySetShim(net, shimLatency, shimJitter, shimLoss);
+        g.selectedLevelIndex = (netLevel >= 0 && netLevel < g.levelCount) ? netLevel : 0;
+        initializeGame(&g, g.levelFiles[g.selectedLevelIndex], screen_width, screen_height);
+        if (g.world.sim == NULL) return 1;
+        g.world.sim->versus = true;
+        g.showLevelSelection = false;
+    }
+
+    // Both spectator roles are large (frame history), so they live on the heap
+    SpectatorServer* spectateServer = NULL;
+    SpectatorView* spectator = NULL;
+    if (spectateServerPort > 0) {
+        spectateServer = (SpectatorServer*)malloc(sizeof(SpectatorServer));
+        if (!spectateServer || !spectatorServerStart(spectateServer, spectateServerPort)) return 1;
+        printf("Streaming to spectators on UDP port %d\n", spectateServerPort);
+    }
+    if (spectateHost) {
+        // The spectator loads the level locally and only overwrites what moves
+        spectator = (SpectatorView*)malloc(sizeof(SpectatorView));
+        if (!spectator || !spectatorViewStart(spectator, spectateHost, spectatePort)) return 1;
+        g.selectedLevelIndex = (netLevel >= 0 && netLevel < g.levelCount) ? netLevel : 0;
+        initializeGame(&g, g.levelFiles[g.selectedLevelIndex], screen_width, screen_height);
+        if (g.world.sim == NULL) return 1;
+        if (g.world.sim->numChunks > 0) {
+            printf("Streamed levels cannot be spectated, pick another with --level\n");
+            return 1;
+        }
+        g.showLevelSelection = false;
+    }
+    // The bot skips the menu as well and plays whichever side is local
+    Bot bot;
+    resetBot(&bot);
+    int botRounds = 0;
+    if (botPlayer && !net && !spectator) {
+        g.selectedLevelIndex = (netLevel >= 0 && netLevel < g.levelCount) ? netLevel : 0;
+        initializeGame(&g, g.levelFiles[g.selectedLevelIndex], screen_width, screen_height);
+        if (g.world.sim == NULL) return 1;
+        g.showLevelSelection = false;
+    }
+    // Player 1's turns are recorded to replays/ and raced as a ghost by player 2
+    GhostRace ghostRace = {0};
+    ghostRace.levelIndex = -1;
+    SimInput turnInput = {0};
+
+    float netAccumulator = 0.0f;
+    bool pendingShot = false;
+    Sint16 shotX = 0, shotY = 0;
+
+    // Split screen: player 2's keys, and a shot per player waiting for the next tick
+    float splitAccumulator = 0.0f;
+    bool p2Left = false, p2Right = false, p2Jump = false;
+    bool splitShot[2] = {false, false};
+    Sint16 splitAimX[2] = {0, 0}, splitAimY[2] = {0, 0};
+
     bool leftPressed = false;
     bool rightPressed = false;
     bool spacePressed = false;
     int mouseX, mouseY;
+    int settleFrames = IDLE_SETTLE_FRAMES;
+    bool wasIdle = false;
 
     while (true) {
+        if (isIdleScreen(&g) && settleFrames <= 0) {
+            // Sleep until input or the wake timer, then don't count the wait as game time
+            SDL_WaitEventTimeout(NULL, IDLE_WAKE_MS);
+            g.lastTime = SDL_GetTicks();
+        }
+
+        statsBeginFrame(g.stats);
         uint64_t currentTime = SDL_GetTicks();
         g.deltaTime = (currentTime - g.lastTime) / 1000.0f;
         g.lastTime = currentTime;
 
         while (SDL_PollEvent(&e)) {
             ImGui_ImplSDL2_ProcessEvent(&e);
+            settleFrames = IDLE_SETTLE_FRAMES;
 
             if (e.type == SDL_QUIT) {
                 g.quit = true;
             }
+            if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                // render() rebuilds the world cache when the size no longer matches
+                SDL_GetWindowSize(g.window, &screen_width, &screen_height);
+            }
+            if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                // Render target contents are lost
+                invalidateWorldCache(g.worldCache);
+                destroyScaler(g.scaler);
+            }
             if (e.type == SDL_MOUSEBUTTONDOWN) {
                 if (e.button.button == SDL_BUTTON_LEFT) {
                     SDL_GetMouseState(&mouseX, &mouseY);
-                    if (mouseX >= g.pauseButton->x && mouseX <= g.pauseButton->x + g.pauseButton->width && mouseY >= g.pauseButton->y && mouseY <= g.pauseButton->y + g.pauseButton->height) {
+                    if (spectator) {
+                        // Watching only, nothing to click
+                    } else if (net && g.world.sim && g.world.sim->versus) {
+                        // Netplay shots go out with the next tick's input, aimed in world coordinates
+                        if (!igGetIO()->WantCaptureMouse) {
+                            pendingShot = true;
+                            shotX = (Sint16)(mouseX + g.world.sim->cameraX);
+                            shotY = (Sint16)mouseY;
+                        }
+                    } else if (mouseX >= g.pauseButton->x && mouseX <= g.pauseButton->x + g.pauseButton->width && mouseY >= g.pauseButton->y && mouseY <= g.pauseButton->y + g.pauseButton->height) {
                         g.isPaused = !g.isPaused;
+                    } else if (g.world.sim && g.world.sim->splitScreen) {
+                        // The mouse aims in player 1's half, in that view's world coordinates
+                        if (!g.isPaused && !igGetIO()->WantCaptureMouse && mouseX < g.split->viewports[0].w) {
+                            splitShot[0] = true;
+                            splitAimX[0] = (Sint16)(mouseX + g.world.sim->splitCameraX[0]);
+                            splitAimY[0] = (Sint16)mouseY;
+                        }
                     } else if (!g.isPaused && !igGetIO()->WantCaptureMouse) {
                         shootBullet(&g, mouseX, mouseY);
+                        if (g.world.sim) {
+                            turnInput.buttons |= INPUT_SHOOT;
+                            turnInput.aimX = (Sint16)(mouseX + g.world.sim->cameraX);
+                            turnInput.aimY = (Sint16)mouseY;
+                        }
                     }
                 }
             }
-            if (e.type == SDL_KEYDOWN) {
+            SDL_Keycode key = e.key.keysym.sym;
+            bool playerTwoKey = key == SDLK_LEFT || key == SDLK_RIGHT || key == SDLK_UP || key == SDLK_RETURN;
+            if (g.splitScreen && playerTwoKey && (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)) {
+                // Split screen: the arrows are player 2's, Enter fires level ahead of them
+                bool down = e.type == SDL_KEYDOWN;
+                if (key == SDLK_LEFT) p2Left = down;
+                else if (key == SDLK_RIGHT) p2Right = down;
+                else if (key == SDLK_UP) p2Jump = down;
+                else if (down && !e.key.repeat && g.world.sim) {
+                    const Shooter* second = &g.world.shooters[1];
+                    splitShot[1] = true;
+                    splitAimX[1] = (Sint16)(second->x + second->width + 400);
+                    splitAimY[1] = (Sint16)(second->y + second->height / 2);
+                }
+            } else if (e.type == SDL_KEYDOWN) {
                 switch (e.key.keysym.sym) {
                     case SDLK_LEFT:
                     case SDLK_a:
@@ -84,6 +386,9 @@ int main(int argc, char* argv[]) {
                     case SDLK_w:
                         spacePressed = true;
                         break;
+                    case SDLK_F3:
+                        g.stats->showOverlay = !g.stats->showOverlay;
+                        break;
                 }
             } else if (e.type == SDL_KEYUP) {
                 switch (e.key.keysym.sym) {
@@ -104,15 +409,108 @@ int main(int argc, char* argv[]) {
         }
 
         // Start the ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
+        if (g.gl) {
+            ImGui_ImplOpenGL3_NewFrame();
+        } else {
+            ImGui_ImplSDLRenderer_NewFrame();
+        }
         ImGui_ImplSDL2_NewFrame(g.window);
         igNewFrame();
 
         if (g.showLevelSelection) {
             loadMainMenu(&g, screen_width, screen_height);
         }
-        if (!g.isPaused && !g.showLevelSelection) {
-            updateGame(&g, hn, screen_width, screen_height, leftPressed, rightPressed, spacePressed);
+        // Not under netplay or spectating, where the peers' levels would no longer match
+        if (watcher && !net && !spectator && !g.showLevelSelection) {
+            levelWatcherUpdate(watcher, &g);
+        }
+        // Sheets a patched level asked for, a little at a time
+        if (decodePool) decodePoolUpload(decodePool, &g, DECODE_UPLOAD_BUDGET_MS);
+        if (spectator) {
+            spectatorViewUpdate(spectator, &g);
+            // Frames arrive as state, without the events behind them
+            g.hud->dirty = true;
+        } else if (net && g.world.sim && g.world.sim->versus && !g.showSummaryWindow) {
+            // Fixed-step versus: run whole ticks for the elapsed time, the session may stall on the peer
+            netAccumulator += g.deltaTime;
+            for (int steps = 0; netAccumulator >= SIM_DT && steps < NET_MAX_STEPS_PER_FRAME; steps++) {
+                SimInput input = {0};
+                if (leftPressed) input.buttons |= INPUT_LEFT;
+                if (rightPressed) input.buttons |= INPUT_RIGHT;
+                if (spacePressed) input.buttons |= INPUT_JUMP;
+                if (pendingShot) {
+                    input.buttons |= INPUT_SHOOT;
+                    input.aimX = shotX;
+                    input.aimY = shotY;
+                }
+                if (botPlayer) input = botInput(&bot, &g.world, netPlayer - 1);
+                if (!netplayAdvance(net, &g, input, NET_VIEW_WIDTH, NET_VIEW_HEIGHT)) break;
+                pendingShot = false;
+                netAccumulator -= SIM_DT;
+            }
+            if (netAccumulator > SIM_DT * NET_MAX_STEPS_PER_FRAME) netAccumulator = SIM_DT * NET_MAX_STEPS_PER_FRAME;
+            if (g.world.sim->versusOver) {
+                g.showSummaryWindow = true;
+                g.isPaused = true;
+            }
+        } else if (g.world.sim && g.world.sim->splitScreen && !g.isPaused && !g.showLevelSelection && !g.showSummaryWindow) {
+            // Local versus steps at the fixed tick like netplay, over one viewport's width
+            splitAccumulator += g.deltaTime;
+            for (int steps = 0; splitAccumulator >= SIM_DT && steps < NET_MAX_STEPS_PER_FRAME; steps++) {
+                SimInput inputs[2] = {{0}, {0}};
+                inputs[0].buttons = (leftPressed ? INPUT_LEFT : 0) | (rightPressed ? INPUT_RIGHT : 0) |
+                                    (spacePressed ? INPUT_JUMP : 0);
+                inputs[1].buttons = (p2Left ? INPUT_LEFT : 0) | (p2Right ? INPUT_RIGHT : 0) | (p2Jump ? INPUT_JUMP : 0);
+                for (int p = 0; p < 2; p++) {
+                    if (!splitShot[p]) continue;
+                    inputs[p].buttons |= INPUT_SHOOT;
+                    inputs[p].aimX = splitAimX[p];
+                    inputs[p].aimY = splitAimY[p];
+                    splitShot[p] = false;
+                }
+                if (botPlayer) inputs[1] = botInput(&bot, &g.world, 1);
+                updateVersus(&g, inputs, g.split->viewports[0].w > 0 ? g.split->viewports[0].w : screen_width / 2, screen_height);
+                splitAccumulator -= SIM_DT;
+            }
+            if (splitAccumulator > SIM_DT * NET_MAX_STEPS_PER_FRAME) splitAccumulator = SIM_DT * NET_MAX_STEPS_PER_FRAME;
+            if (g.world.sim->versusOver) {
+                g.showSummaryWindow = true;
+                g.isPaused = true;
+            }
+        } else if (!g.isPaused && !g.showLevelSelection) {
+            if (botPlayer) {
+                // The bot presses the same keys and clicks the same shots a player would
+                SimInput input = botInput(&bot, &g.world, g.world.sim->isPlayer1Turn ? 0 : 1);
+                leftPressed = input.buttons & INPUT_LEFT;
+                rightPressed = input.buttons & INPUT_RIGHT;
+                spacePressed = input.buttons & INPUT_JUMP;
+                if (input.buttons & INPUT_SHOOT) {
+                    shootBullet(&g, input.aimX - g.world.sim->cameraX, input.aimY);
+                    turnInput.buttons |= INPUT_SHOOT;
+                    turnInput.aimX = input.aimX;
+                    turnInput.aimY = input.aimY;
+                }
+            }
+            updateGame(&g, screen_width, screen_height, leftPressed, rightPressed, spacePressed);
+            turnInput.buttons = (turnInput.buttons & INPUT_SHOOT) | (leftPressed ? INPUT_LEFT : 0) |
+                                (rightPressed ? INPUT_RIGHT : 0) | (spacePressed ? INPUT_JUMP : 0);
+            updateGhostRace(&ghostRace, &g, turnInput);
+            turnInput.buttons = 0;
+        }
+        if (spectateServer && g.world.sim && !g.isPaused && !g.showLevelSelection) {
+            spectatorServerBroadcast(spectateServer, &g);
+        }
+        if (botPlayer && !net && !spectator && !g.showLevelSelection) {
+            // Nobody is there to click through the handoff and summary screens
+            if (g.showSummaryWindow) {
+                botRounds++;
+                printf("Bot round %d finished %s\n", botRounds, g.levelFiles[g.selectedLevelIndex]);
+                g.selectedLevelIndex = (g.selectedLevelIndex + 1) % g.levelCount;
+                resetLevel(&g, g.levelFiles[g.selectedLevelIndex], screen_width, screen_height);
+                g.showSummaryWindow = false;
+            }
+            if (g.isPaused) resetBot(&bot);
+            g.isPaused = false;
         }
         if (g.isPaused && !g.showSummaryWindow) {
             loadPause(&g, screen_width, screen_height);
@@ -120,16 +518,103 @@ int main(int argc, char* argv[]) {
         if (g.showSummaryWindow) {
             loadSummary(&g, screen_width, screen_height);
         }
+        // The idle wait wakes every IDLE_WAKE_MS, so this also ends a run left at the menu
+        if (quitAfter > 0.0f && SDL_GetTicks() >= (Uint32)(quitAfter * 1000.0f)) g.quit = true;
         if (g.quit) break;
 
+        // Entering or leaving a static screen also needs a few frames for ImGui to lay out
+        bool idle = isIdleScreen(&g);
+        if (idle != wasIdle) settleFrames = IDLE_SETTLE_FRAMES;
+        wasIdle = idle;
+        settleFrames--;
+        g.stats->idle = idle;
+
+        // Readers on the event bus catch up on whatever the steps above did
+        readHudEvents(g.hud, &g.world);
+        if (telemetry) telemetryForward(telemetry, &g.world);
+        if (audio) audioUpdate(audio, &g.world);
+        if (!idle) {
+            // Effects freeze along with the world
+            playSimEvents(g.fx, &g.world);
+            updateFx(g.fx, g.deltaTime);
+        }
+
+        // Draw the world first (frozen behind the pause and summary windows), ImGui on top,
+        // then present once through the shared renderer
+        if (g.showLevelSelection) {
+            clearScreen(g.renderer, g.gl, screen_width, screen_height);
+        } else if (idle && !g.gl && freezeWorldFrame(g.worldCache, g, g.renderer, hn, screen_width, screen_height)) {
+            // Re-present the paused world instead of rendering it again
+            drawFrozenFrame(g.worldCache, g.renderer);
+            if (g.world.sim && g.world.sim->splitScreen) drawSplitHud(g);
+        } else {
+            if (g.isPaused) g.deltaTime = 0.0f;
+            render(g, g.renderer, g.font, hn, screen_width, screen_height);
+        }
+        if (!idle) thawWorldFrame(g.worldCache);
+        if (g.gl) {
+            g.stats->drawCalls = g.gl->drawCalls;
+            g.stats->sprites = g.gl->lastInstanceCount;
+        } else {
+            statsInternalResolution(g.stats, g.scaler->width, g.scaler->height, g.scaler->scale);
+        }
+        memcpy(g.stats->lod, g.world.lod, sizeof(g.stats->lod));
+        drawStatsOverlay(g.stats);
+        if (net && g.stats->showOverlay) drawNetplayStats(net);
+        if ((spectateServer || spectator) && g.stats->showOverlay) drawSpectatorStats(spectateServer, spectator);
+
         igRender();
-        ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
-        SDL_GL_SwapWindow(g.window);
+        if (g.gl) {
+            ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
+        } else {
+            ImGui_ImplSDLRenderer_RenderDrawData(igGetDrawData());
+        }
+        statsPresent(g.stats, g.window, g.renderer);
+        if (!idle && !g.showLevelSelection && !g.gl) {
+            updateResolutionGovernor(g.scaler, g.stats->workMs);
+        }
         SDL_Delay(1);
     }
 
+    stopGhostRace(&ghostRace, &g);
+    printStatsSummary(g.stats);
+    if (net) {
+        printNetplaySummary(net);
+        netplayStop(net);
+    }
+    if (spectateServer) {
+        spectatorServerStop(spectateServer);
+        free(spectateServer);
+    }
+    if (spectator) {
+        spectatorViewStop(spectator);
+        free(spectator);
+    }
+    if (telemetry) {
+        telemetryStop(telemetry);
+        free(telemetry);
+    }
+    if (watcher) {
+        levelWatcherStop(watcher);
+        free(watcher);
+    }
+    if (decodePool) {
+        decodePoolStop(decodePool);
+        free(decodePool);
+        g.decode = NULL;
+    }
+    if (audio) {
+        printAudioSummary(audio);
+        audioStop(audio);
+        free(audio);
+    }
+    freeHudCache(g.hud);
+    freeSplitBatch(g.split);
+    invalidateWorldCache(g.worldCache);
+    destroyScaler(g.scaler);
     clear(&g);
     freeHillNoise(hn);
+    freeLevelTemplate(g.level);
     freeLevelFiles(g.levelFiles, g.levelCount);
     TTF_CloseFont(g.font);
     TTF_Quit();
@@ -0,0 +1,359 @@
+#include "navgraph.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Feet of a shooter standing on the ground
+#define NAV_GROUND_Y (GROUND_LEVEL + 100.0f)
+#define NAV_BODY_HEIGHT 100.0f
+// Jumps must top the landing height by this much, as the bot's do
+#define NAV_CLEARANCE 16.0f
+// Points checked along each jump for platforms in the way
+#define NAV_ARC_SAMPLES 64
+
+static float clampf(float value, float low, float high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+static void addNode(NavGraph* nav, float left, float right, float y, int platform) {
+    // Too narrow to stand on with a margin either side
+    if (nav->numNodes >= NAV_MAX_NODES || right - left < 2 * NAV_EDGE_MARGIN) return;
+    NavNode* node = &nav->nodes[nav->numNodes++];
+    node->left = left;
+    node->right = right;
+    node->y = y;
+    node->platform = platform;
+}
+
+// The ground is cut wherever a platform is low enough to block a standing body.
+// The cuts are widened so a body at the margin of a ground span clears the platform's side.
+static void addGroundNodes(NavGraph* nav, const Platform* platforms, int numPlatforms, float left, float right) {
+    float cutLeft[NAV_MAX_NODES], cutRight[NAV_MAX_NODES];
+    float widen = NAV_BODY_HALF - NAV_EDGE_MARGIN + 1.0f;
+    int cuts = 0;
+    for (int i = 0; i < numPlatforms && cuts < NAV_MAX_NODES; i++) {
+        const Platform* p = &platforms[i];
+        if (p->y >= NAV_GROUND_Y || p->y + p->height <= NAV_GROUND_Y - NAV_BODY_HEIGHT) continue;
+        // Insertion sort by left edge, there are only ever a handful
+        int j = cuts++;
+        while (j > 0 && cutLeft[j - 1] > p->x - widen) {
+            cutLeft[j] = cutLeft[j - 1];
+            cutRight[j] = cutRight[j - 1];
+            j--;
+        }
+        cutLeft[j] = p->x - widen;
+        cutRight[j] = p->x + p->width + widen;
+    }
+
+    for (int i = 0; i < cuts; i++) {
+        if (cutLeft[i] > left) addNode(nav, left, cutLeft[i], NAV_GROUND_Y, -1);
+        if (cutRight[i] > left) left = cutRight[i];
+    }
+    addNode(nav, left, right, NAV_GROUND_Y, -1);
+}
+
+// Seconds in the air for a jump landing rise pixels above its takeoff (negative
+// for a drop), coming down onto it. Negative when the jump cannot reach that high.
+static float jumpAirtime(float rise) {
+    float v = (float)JUMP_SPEED;
+    if (v * v < 2.0f * GRAVITY * (rise + NAV_CLEARANCE)) return -1.0f;
+    return (v + sqrtf(v * v - 2.0f * GRAVITY * rise)) / GRAVITY;
+}
+
+// Samples the arc for a body passing through, or landing early on, any platform
+static bool arcBlocked(const NavGraph* nav, const NavLink* link, const Platform* platforms, int numPlatforms) {
+    for (int k = 1; k < NAV_ARC_SAMPLES; k++) {
+        float x, feetY;
+        navLinkPosition(nav, link, link->duration * k / NAV_ARC_SAMPLES, &x, &feetY);
+        for (int i = 0; i < numPlatforms; i++) {
+            const Platform* p = &platforms[i];
+            if (x + NAV_BODY_HALF > p->x && x - NAV_BODY_HALF < p->x + p->width &&
+                feetY > p->y + 1.0f && feetY - NAV_BODY_HEIGHT < p->y + p->height) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void addLink(NavGraph* nav, const Platform* platforms, int numPlatforms, int from, int to, float takeoffX, float landingX) {
+    float airtime = jumpAirtime(nav->nodes[from].y - nav->nodes[to].y);
+    float dx = landingX - takeoffX;
+    if (airtime < 0.0f || fabsf(dx) > SHOOTER_SPEED * airtime || nav->numLinks >= NAV_MAX_LINKS) return;
+    NavLink* link = &nav->links[nav->numLinks];
+    link->from = from;
+    link->to = to;
+    link->takeoffX = takeoffX;
+    link->landingX = landingX;
+    link->vx = dx / airtime;
+    link->duration = airtime;
+    if (!arcBlocked(nav, link, platforms, numPlatforms)) nav->numLinks++;
+}
+
+// Going up, the body must already be above the edge by the time it first
+// overlaps the higher span. The takeoff backs away from the edge until the arc
+// clears it, or until the jump would need more than SHOOTER_SPEED across.
+// side is -1 for the left edge, approached from the left, +1 for the right.
+static void addUpLink(NavGraph* nav, const Platform* platforms, int numPlatforms, int from, int to, float edgeX, float side) {
+    const NavNode* a = &nav->nodes[from];
+    float rise = a->y - nav->nodes[to].y;
+    float airtime = jumpAirtime(rise);
+    if (airtime < 0.0f) return;
+    float landing = edgeX - side * NAV_EDGE_MARGIN;
+    float previous = -1.0f;
+    for (float back = 0.0f; ; back += 10.0f) {
+        float takeoff = clampf(edgeX + side * (NAV_BODY_HALF + NAV_EDGE_MARGIN + back),
+                               a->left + NAV_EDGE_MARGIN, a->right - NAV_EDGE_MARGIN);
+        float clearance = side * (takeoff - edgeX) - NAV_BODY_HALF;
+        float vx = fabsf(landing - takeoff) / airtime;
+        if (takeoff == previous || clearance < 0.0f || vx > SHOOTER_SPEED) return;
+        float t = clearance / vx;
+        if (JUMP_SPEED * t - 0.5f * GRAVITY * t * t >= rise) {
+            addLink(nav, platforms, numPlatforms, from, to, takeoff, landing);
+            return;
+        }
+        previous = takeoff;
+    }
+}
+
+// Up to two links per pair, one over each side. Going level or down the body
+// has to leave over an edge of the span it stands on.
+static void connectNodes(NavGraph* nav, const Platform* platforms, int numPlatforms, int from, int to) {
+    const NavNode* a = &nav->nodes[from];
+    const NavNode* b = &nav->nodes[to];
+    float aLow = a->left + NAV_EDGE_MARGIN, aHigh = a->right - NAV_EDGE_MARGIN;
+    float bLow = b->left + NAV_EDGE_MARGIN, bHigh = b->right - NAV_EDGE_MARGIN;
+
+    if (a->y > b->y) {
+        addUpLink(nav, platforms, numPlatforms, from, to, b->left, -1.0f);
+        addUpLink(nav, platforms, numPlatforms, from, to, b->right, 1.0f);
+    } else {
+        float landing = clampf(a->right + NAV_BODY_HALF + NAV_EDGE_MARGIN, bLow, bHigh);
+        if (landing >= a->right + NAV_BODY_HALF) addLink(nav, platforms, numPlatforms, from, to, aHigh, landing);
+        landing = clampf(a->left - NAV_BODY_HALF - NAV_EDGE_MARGIN, bLow, bHigh);
+        if (landing <= a->left - NAV_BODY_HALF) addLink(nav, platforms, numPlatforms, from, to, aLow, landing);
+    }
+}
+
+// Lower bound on the seconds between two spans: the horizontal gap at full speed
+static float gapTime(const NavNode* a, const NavNode* b) {
+    float gap = fmaxf(b->left - a->right, a->left - b->right);
+    return gap > 0.0f ? gap / SHOOTER_SPEED : 0.0f;
+}
+
+// A* over the spans. Each jump costs its airtime plus the walk to its takeoff
+// from wherever the previous jump landed, and a jump onto the finish span the
+// walk on to finishX, so of two ways down the one landing nearer the end wins.
+// Returns the first link of the path.
+static int firstLink(const NavGraph* nav, int start, int goal) {
+    float cost[NAV_MAX_NODES], entryX[NAV_MAX_NODES];
+    int via[NAV_MAX_NODES];
+    bool open[NAV_MAX_NODES], closed[NAV_MAX_NODES];
+    for (int i = 0; i < nav->numNodes; i++) {
+        cost[i] = INFINITY;
+        via[i] = -1;
+        open[i] = closed[i] = false;
+    }
+    cost[start] = 0.0f;
+    entryX[start] = (nav->nodes[start].left + nav->nodes[start].right) / 2;
+    open[start] = true;
+
+    while (true) {
+        int current = -1;
+        float best = INFINITY;
+        for (int i = 0; i < nav->numNodes; i++) {
+            float estimate = cost[i] + gapTime(&nav->nodes[i], &nav->nodes[goal]);
+            if (open[i] && estimate < best) {
+                best = estimate;
+                current = i;
+            }
+        }
+        if (current < 0) return -1;
+        if (current == goal) break;
+        open[current] = false;
+        closed[current] = true;
+
+        for (int l = 0; l < nav->numLinks; l++) {
+            const NavLink* link = &nav->links[l];
+            if (link->from != current || closed[link->to]) continue;
+            float through = cost[current] + fabsf(link->takeoffX - entryX[current]) / SHOOTER_SPEED + link->duration;
+            if (link->to == goal && goal == nav->finishNode) through += fabsf(nav->finishX - link->landingX) / SHOOTER_SPEED;
+            if (through < cost[link->to]) {
+                cost[link->to] = through;
+                entryX[link->to] = link->landingX;
+                via[link->to] = l;
+                open[link->to] = true;
+            }
+        }
+    }
+
+    int node = goal;
+    while (nav->links[via[node]].from != start) node = nav->links[via[node]].from;
+    return via[node];
+}
+
+// Spans over the platforms and the ground from left to right, and every jump between them
+static void addSpans(NavGraph* nav, const Platform* platforms, int numPlatforms, float left, float right) {
+    addGroundNodes(nav, platforms, numPlatforms, left, right);
+    for (int i = 0; i < numPlatforms; i++) {
+        addNode(nav, platforms[i].x, platforms[i].x + platforms[i].width, platforms[i].y, i);
+    }
+    for (int i = 0; i < nav->numNodes; i++) {
+        for (int j = 0; j < nav->numNodes; j++) {
+            if (i != j) connectNodes(nav, platforms, numPlatforms, i, j);
+        }
+    }
+}
+
+static void setFinish(NavGraph* nav, float right) {
+    nav->finishNode = -1;
+    nav->finishX = right - NAV_EDGE_MARGIN;
+    for (int i = 0; i < nav->numNodes; i++) {
+        if (nav->nodes[i].right >= right - NAV_EDGE_MARGIN &&
+            (nav->finishNode < 0 || nav->nodes[i].y > nav->nodes[nav->finishNode].y)) {
+            nav->finishNode = i;
+        }
+    }
+}
+
+NavGraph* buildNavGraph(const Platform* platforms, int numPlatforms, float left, float right) {
+    NavGraph* nav = (NavGraph*)calloc(1, sizeof(NavGraph));
+    if (nav == NULL) return NULL;
+
+    addSpans(nav, platforms, numPlatforms, left, right);
+    setFinish(nav, right);
+    for (int from = 0; from < nav->numNodes; from++) {
+        for (int to = 0; to < nav->numNodes; to++) {
+            nav->next[from * NAV_MAX_NODES + to] = (int16_t)(from == to ? -1 : firstLink(nav, from, to));
+        }
+    }
+    return nav;
+}
+
+void buildNavChunk(NavChunk* out, const Platform* platforms, int numPlatforms) {
+    memset(out, 0, sizeof(*out));
+    NavGraph* nav = (NavGraph*)calloc(1, sizeof(NavGraph));
+    if (nav == NULL) return;
+    addSpans(nav, platforms, numPlatforms, 0.0f, STREAM_CHUNK_WIDTH);
+    out->numNodes = nav->numNodes < NAV_CHUNK_NODES ? nav->numNodes : NAV_CHUNK_NODES;
+    memcpy(out->nodes, nav->nodes, out->numNodes * sizeof(NavNode));
+    for (int l = 0; l < nav->numLinks && out->numLinks < NAV_CHUNK_LINKS; l++) {
+        if (nav->links[l].from < out->numNodes && nav->links[l].to < out->numNodes) out->links[out->numLinks++] = nav->links[l];
+    }
+    free(nav);
+}
+
+static bool hasLink(const NavGraph* nav, int from, int to) {
+    for (int l = 0; l < nav->numLinks; l++) {
+        if (nav->links[l].from == from && nav->links[l].to == to) return true;
+    }
+    return false;
+}
+
+NavGraph* stitchNavGraph(const NavChunk chunks[STREAM_RESIDENT], const int chunkIndex[STREAM_RESIDENT], int originChunk,
+                         const Platform* platforms, int numPlatforms, float right) {
+    NavGraph* nav = (NavGraph*)calloc(1, sizeof(NavGraph));
+    if (nav == NULL) return NULL;
+
+    // Resident slots left to right
+    int order[STREAM_RESIDENT], resident = 0;
+    for (int s = 0; s < STREAM_RESIDENT; s++) {
+        if (chunkIndex[s] < 0) continue;
+        int j = resident++;
+        while (j > 0 && chunkIndex[order[j - 1]] > chunkIndex[s]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = s;
+    }
+
+    // Each chunk's spans and jumps, moved into place. node[s][i] is where chunk
+    // node i of slot s went, -1 if the graph is full.
+    int node[STREAM_RESIDENT][NAV_CHUNK_NODES];
+    int edgeGround = -1;    // ground span running off the right of the previous chunk
+    for (int k = 0; k < resident; k++) {
+        int s = order[k];
+        const NavChunk* chunk = &chunks[s];
+        float offset = (float)((chunkIndex[s] - originChunk) * STREAM_CHUNK_WIDTH);
+        int carried = k > 0 && chunkIndex[order[k - 1]] == chunkIndex[s] - 1 ? edgeGround : -1;
+        edgeGround = -1;
+        for (int i = 0; i < chunk->numNodes; i++) {
+            const NavNode* from = &chunk->nodes[i];
+            node[s][i] = -1;
+            if (from->platform < 0 && from->left <= 0.0f && carried >= 0) {
+                // The ground goes on from the chunk to the left
+                nav->nodes[carried].right = from->right + offset;
+                node[s][i] = carried;
+            } else if (nav->numNodes < NAV_MAX_NODES) {
+                NavNode* to = &nav->nodes[nav->numNodes];
+                *to = *from;
+                to->left += offset;
+                to->right += offset;
+                if (to->platform >= 0) to->platform += s * STREAM_CHUNK_PLATFORMS;
+                node[s][i] = nav->numNodes++;
+            }
+            if (from->platform < 0 && from->right >= STREAM_CHUNK_WIDTH) edgeGround = node[s][i];
+        }
+        for (int l = 0; l < chunk->numLinks && nav->numLinks < NAV_MAX_LINKS; l++) {
+            const NavLink* from = &chunk->links[l];
+            if (node[s][from->from] < 0 || node[s][from->to] < 0) continue;
+            NavLink* to = &nav->links[nav->numLinks];
+            *to = *from;
+            to->from = node[s][from->from];
+            to->to = node[s][from->to];
+            to->takeoffX += offset;
+            to->landingX += offset;
+            // A jump out over the chunk's edge may meet a neighbour's platform
+            bool inside = fminf(from->takeoffX, from->landingX) - NAV_BODY_HALF >= 0.0f &&
+                          fmaxf(from->takeoffX, from->landingX) + NAV_BODY_HALF <= STREAM_CHUNK_WIDTH;
+            if (inside || !arcBlocked(nav, to, platforms, numPlatforms)) nav->numLinks++;
+        }
+    }
+
+    // Jumps across each edge between neighbouring chunks
+    for (int k = 1; k < resident; k++) {
+        int a = order[k - 1], b = order[k];
+        if (chunkIndex[a] != chunkIndex[b] - 1) continue;
+        for (int i = 0; i < chunks[a].numNodes; i++) {
+            for (int j = 0; j < chunks[b].numNodes; j++) {
+                int u = node[a][i], v = node[b][j];
+                if (u < 0 || v < 0 || u == v) continue;
+                if (!hasLink(nav, u, v)) connectNodes(nav, platforms, numPlatforms, u, v);
+                if (!hasLink(nav, v, u)) connectNodes(nav, platforms, numPlatforms, v, u);
+            }
+        }
+    }
+
+    setFinish(nav, right);
+    for (int i = 0; i < NAV_MAX_NODES * NAV_MAX_NODES; i++) nav->next[i] = NAV_UNSOLVED;
+    return nav;
+}
+
+int navNodeAt(const NavGraph* nav, float x, float feetY) {
+    int best = -1;
+    for (int i = 0; i < nav->numNodes; i++) {
+        const NavNode* node = &nav->nodes[i];
+        if (x < node->left || x > node->right || node->y < feetY - 1.0f) continue;
+        if (best < 0 || node->y < nav->nodes[best].y) best = i;
+    }
+    return best;
+}
+
+int navNodeForPlatform(const NavGraph* nav, int platform) {
+    for (int i = 0; i < nav->numNodes; i++) {
+        if (nav->nodes[i].platform == platform) return i;
+    }
+    return -1;
+}
+
+const NavLink* navNextLink(NavGraph* nav, int from, int to) {
+    if (from < 0 || to < 0) return NULL;
+    int16_t* next = &nav->next[from * NAV_MAX_NODES + to];
+    if (*next == NAV_UNSOLVED) *next = (int16_t)(from == to ? -1 : firstLink(nav, from, to));
+    return *next >= 0 ? &nav->links[*next] : NULL;
+}
+
+void navLinkPosition(const NavGraph* nav, const NavLink* link, float t, float* x, float* feetY) {
+    *x = link->takeoffX + link->vx * t;
+    *feetY = nav->nodes[link->from].y - JUMP_SPEED * t + 0.5f * GRAVITY * t * t;
+}
@@ -0,0 +1,52 @@
+#ifndef NAVGRAPH_H
+#define NAVGRAPH_H
+
+#include "sim.h"
+
+#define NAV_MAX_NODES 64
+#define NAV_MAX_LINKS 512
+// Takeoff and landing points stay this far inside a span so bodies fit on it
+#define NAV_EDGE_MARGIN 40.0f
+// Half the shooter box, the widest body that follows the links
+#define NAV_BODY_HALF 50.0f
+
+// NavNode, NavLink and the per-chunk NavChunk are in sim.h, with the level chunks that carry them
+
+// Entry of next not looked up yet
+#define NAV_UNSOLVED -2
+
+// Built once per level from the platforms, with paths solved for every pair of
+// spans up front, so finding the next jump at runtime is one table lookup.
+// A streamed level's is stitched from its resident chunks' instead, and solves
+// each pair the first time it is asked for.
+struct NavGraph {
+    int numNodes;
+    int numLinks;
+    int finishNode;         // lowest span that reaches the right end of the level, or of the resident chunks
+    float finishX;          // where on it the run ends, paths there are costed to this x
+    NavNode nodes[NAV_MAX_NODES];
+    NavLink links[NAV_MAX_LINKS];
+    int16_t next[NAV_MAX_NODES * NAV_MAX_NODES];    // first link from a span towards another, -1 for none
+};
+
+// Ground runs from left to right: the whole level, or the resident chunks of a streamed one
+NavGraph* buildNavGraph(const Platform* platforms, int numPlatforms, float left, float right);
+// One chunk's spans and the jumps within it, in chunk-local x, for the loader to
+// build as it decodes the chunk. Every span fits, jumps past NAV_CHUNK_LINKS are
+// left out; an empty chunk still has its ground.
+void buildNavChunk(NavChunk* out, const Platform* platforms, int numPlatforms);
+// The graph over a streamed level's resident chunks, chunkIndex[s] in slot s (-1
+// for none) with its platforms at s * STREAM_CHUNK_PLATFORMS in platforms. Ground
+// spans meeting at a chunk edge are joined and new jumps are only looked for
+// between spans of neighbouring chunks. right is where the resident run ends.
+NavGraph* stitchNavGraph(const NavChunk chunks[STREAM_RESIDENT], const int chunkIndex[STREAM_RESIDENT], int originChunk,
+                         const Platform* platforms, int numPlatforms, float right);
+// Span under a body centred at x with its feet at feetY, -1 if it is over a gap
+int navNodeAt(const NavGraph* nav, float x, float feetY);
+int navNodeForPlatform(const NavGraph* nav, int platform);
+// First jump on the way from one span to another, NULL when already there or unreachable
+const NavLink* navNextLink(NavGraph* nav, int from, int to);
+// Where a body following link stands after t seconds: centre x and feet y
+void navLinkPosition(const NavGraph* nav, const NavLink* link, float t, float* x, float* feetY);
+
+#endif
@@ -0,0 +1,338 @@
+// getaddrinfo and friends are POSIX, hidden by -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include "netplay.h"
+#include "shooter.h"
+#include "simstate.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define NET_MAGIC 0x414D5242        // "AMRB"
+#define NET_HEADER_SIZE 13
+#define NET_INPUT_SIZE 5
+#define NET_MAX_INPUT_DELAY 15
+
+static int slot(Uint32 tick) {
+    return tick & (NET_INPUT_HISTORY - 1);
+}
+
+static bool isConfirmed(NetSession* n, int player, Uint32 tick) {
+    return n->confirmedTick[player][slot(tick)] == tick + 1;
+}
+
+static void write32(Uint8* p, Uint32 v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static Uint32 read32(const Uint8* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+// xorshift32, keeps the shim independent of rand()
+static Uint32 shimRandom(NetSession* n) {
+    Uint32 x = n->shimRandom;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    n->shimRandom = x;
+    return x;
+}
+
+bool netplayStart(NetSession* n, int localPlayer, int localPort, const char* remoteHost, int remotePort, int inputDelay) {
+    memset(n, 0, sizeof(*n));
+    n->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (n->socket < 0) {
+        perror("Failed to create netplay socket");
+        return false;
+    }
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(localPort);
+    if (bind(n->socket, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        perror("Failed to bind netplay socket");
+        close(n->socket);
+        return false;
+    }
+    fcntl(n->socket, F_SETFL, fcntl(n->socket, F_GETFL, 0) | O_NONBLOCK);
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(remoteHost, NULL, &hints, &result) != 0) {
+        fprintf(stderr, "Failed to resolve netplay peer %s\n", remoteHost);
+        close(n->socket);
+        return false;
+    }
+    memcpy(&n->remote, result->ai_addr, sizeof(n->remote));
+    n->remote.sin_port = htons(remotePort);
+    freeaddrinfo(result);
+
+    if (inputDelay < 0) inputDelay = 0;
+    if (inputDelay > NET_MAX_INPUT_DELAY) inputDelay = NET_MAX_INPUT_DELAY;
+    n->localPlayer = localPlayer ? 1 : 0;
+    n->inputDelay = inputDelay;
+
+    // Ticks inside the input delay carry no input from either side
+    for (int t = 0; t < inputDelay; t++) {
+        n->confirmedTick[0][slot(t)] = t + 1;
+        n->confirmedTick[1][slot(t)] = t + 1;
+    }
+    n->nextLocalTick = inputDelay;
+    n->confirmedRemoteTick = inputDelay;
+    n->remoteAck = inputDelay;
+    n->rollbackFrom = UINT32_MAX;
+    n->shimRandom = 0x9E3779B9u ^ (Uint32)localPort;
+
+    printf("Netplay: player %d on port %d, peer %s:%d, input delay %d\n",
+           n->localPlayer + 1, localPort, remoteHost, remotePort, inputDelay);
+    return true;
+}
+
+void netplaySetShim(NetSession* n, float latencyMs, float jitterMs, float lossPercent) {
+    n->latencyMs = latencyMs;
+    n->jitterMs = jitterMs;
+    n->lossPercent = lossPercent;
+}
+
+static void sendNow(NetSession* n, const Uint8* data, int length) {
+    sendto(n->socket, data, length, 0, (struct sockaddr*)&n->remote, sizeof(n->remote));
+}
+
+// Drops or delays the packet according to the shim settings
+static void shimSend(NetSession* n, const Uint8* data, int length) {
+    n->packetsSent++;
+    if (n->lossPercent > 0.0f && (shimRandom(n) % 10000) < n->lossPercent * 100.0f) {
+        n->packetsDropped++;
+        return;
+    }
+    if (n->latencyMs <= 0.0f && n->jitterMs <= 0.0f) {
+        sendNow(n, data, length);
+        return;
+    }
+    if (n->queued >= NET_SHIM_QUEUE) {
+        n->packetsDropped++;
+        return;
+    }
+
+    float jitter = n->jitterMs * ((shimRandom(n) % 2001) / 1000.0f - 1.0f);
+    float delay = n->latencyMs + jitter;
+    DelayedPacket* packet = &n->queue[n->queued++];
+    memcpy(packet->data, data, length);
+    packet->length = length;
+    packet->sendAt = SDL_GetTicks() + (Uint32)(delay > 0.0f ? delay : 0.0f);
+}
+
+// Sends the delayed packets that are due; jitter may reorder them like a real network
+static void pumpShim(NetSession* n) {
+    Uint32 now = SDL_GetTicks();
+    for (int i = 0; i < n->queued; ) {
+        if ((Sint32)(now - n->queue[i].sendAt) >= 0) {
+            sendNow(n, n->queue[i].data, n->queue[i].length);
+            n->queue[i] = n->queue[--n->queued];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Packet: magic, ack (remote ticks we have confirmed), first tick, count, then count inputs.
+// Every packet repeats all local inputs the peer has not acked yet, so losses need no resend.
+static void sendInputs(NetSession* n) {
+    Uint8 packet[NET_PACKET_SIZE];
+    Uint32 first = n->remoteAck;
+    Uint32 count = n->nextLocalTick > first ? n->nextLocalTick - first : 0;
+    if (count > NET_MAX_INPUTS_PER_PACKET) count = NET_MAX_INPUTS_PER_PACKET;
+
+    write32(packet, NET_MAGIC);
+    write32(packet + 4, n->confirmedRemoteTick);
+    write32(packet + 8, first);
+    packet[12] = (Uint8)count;
+    for (Uint32 i = 0; i < count; i++) {
+        const SimInput* input = &n->inputs[n->localPlayer][slot(first + i)];
+        Uint8* p = packet + NET_HEADER_SIZE + i * NET_INPUT_SIZE;
+        p[0] = input->buttons;
+        p[1] = (Uint16)input->aimX & 0xFF;
+        p[2] = (Uint16)input->aimX >> 8;
+        p[3] = (Uint16)input->aimY & 0xFF;
+        p[4] = (Uint16)input->aimY >> 8;
+    }
+    shimSend(n, packet, NET_HEADER_SIZE + count * NET_INPUT_SIZE);
+}
+
+static void storeRemoteInput(NetSession* n, Uint32 tick, SimInput input) {
+    int remote = 1 - n->localPlayer;
+    if (tick < n->confirmedRemoteTick || isConfirmed(n, remote, tick)) return;
+    // Ignore anything too far ahead to fit the ring
+    if ((Sint32)(tick - n->currentTick) >= NET_INPUT_HISTORY / 2) return;
+
+    SimInput* stored = &n->inputs[remote][slot(tick)];
+    bool mispredicted = tick < n->currentTick &&
+        (stored->buttons != input.buttons || stored->aimX != input.aimX || stored->aimY != input.aimY);
+    if (mispredicted && tick < n->rollbackFrom) n->rollbackFrom = tick;
+
+    *stored = input;
+    n->confirmedTick[remote][slot(tick)] = tick + 1;
+    while (isConfirmed(n, remote, n->confirmedRemoteTick)) n->confirmedRemoteTick++;
+}
+
+static void receiveInputs(NetSession* n) {
+    Uint8 packet[NET_PACKET_SIZE];
+    struct sockaddr_in from;
+    socklen_t fromLength = sizeof(from);
+    ssize_t length;
+
+    while ((length = recvfrom(n->socket, packet, sizeof(packet), 0, (struct sockaddr*)&from, &fromLength)) >= 0) {
+        fromLength = sizeof(from);
+        if (length < NET_HEADER_SIZE || read32(packet) != NET_MAGIC) continue;
+        if (from.sin_addr.s_addr != n->remote.sin_addr.s_addr || from.sin_port != n->remote.sin_port) continue;
+        n->packetsReceived++;
+
+        Uint32 ack = read32(packet + 4);
+        if ((Sint32)(ack - n->remoteAck) > 0 && ack <= n->nextLocalTick) n->remoteAck = ack;
+
+        Uint32 first = read32(packet + 8);
+        int count = packet[12];
+        if (length < NET_HEADER_SIZE + count * NET_INPUT_SIZE) continue;
+        for (int i = 0; i < count; i++) {
+            const Uint8* p = packet + NET_HEADER_SIZE + i * NET_INPUT_SIZE;
+            SimInput input;
+            input.buttons = p[0];
+            input.aimX = (Sint16)(p[1] | (p[2] << 8));
+            input.aimY = (Sint16)(p[3] | (p[4] << 8));
+            storeRemoteInput(n, first + i, input);
+        }
+    }
+}
+
+// Remote input is predicted to continue as last confirmed, minus one-shot buttons
+static SimInput predictRemoteInput(NetSession* n) {
+    SimInput input = {0};
+    if (n->confirmedRemoteTick > 0) {
+        input = n->inputs[1 - n->localPlayer][slot(n->confirmedRemoteTick - 1)];
+        input.buttons &= ~INPUT_SHOOT;
+    }
+    return input;
+}
+
+static void simulateTick(NetSession* n, GameData* g, Uint32 tick, int screen_width, int screen_height) {
+    int k = tick % (NET_MAX_ROLLBACK + 1);
+    SimState* saved = snapshotSimState(g->world.sim, n->snapshots[k]);
+    if (saved) {
+        n->snapshots[k] = saved;
+        n->snapshotTick[k] = tick;
+    }
+
+    int remote = 1 - n->localPlayer;
+    if (!isConfirmed(n, remote, tick)) n->inputs[remote][slot(tick)] = predictRemoteInput(n);
+
+    SimInput inputs[2] = {n->inputs[0][slot(tick)], n->inputs[1][slot(tick)]};
+    updateVersus(g, inputs, screen_width, screen_height);
+}
+
+// Runs one fixed tick. Returns false when the session is stalled waiting for the peer.
+bool netplayAdvance(NetSession* n, GameData* g, SimInput localInput, int screen_width, int screen_height) {
+    pumpShim(n);
+    receiveInputs(n);
+
+    // A late remote input contradicted a prediction: rewind to that tick and replay
+    if (n->rollbackFrom < n->currentTick) {
+        Uint32 from = n->rollbackFrom;
+        int k = from % (NET_MAX_ROLLBACK + 1);
+        if (n->snapshots[k] && n->snapshotTick[k] == from && restoreSimState(g->world.sim, n->snapshots[k])) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            // Those ticks' kills and pickups were already published, withdraw the replayed ones
+            uint32_t events = g->world.eventsPublished;
+            for (Uint32 t = from; t < n->currentTick; t++) {
+                simulateTick(n, g, t, screen_width, screen_height);
+            }
+            g->world.eventsPublished = events;
+            if (g->hud) g->hud->dirty = true;
+            float ms = (float)((SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+            int depth = (int)(n->currentTick - from);
+
+            n->rollbacks++;
+            n->resimTicks += depth;
+            n->resimMsTotal += ms;
+            n->lastResimMs = ms;
+            if (ms > n->worstResimMs) n->worstResimMs = ms;
+            if (depth > n->worstRollbackDepth) n->worstRollbackDepth = depth;
+        } else {
+            printf("Netplay: tick %u is outside the rollback window, peers may desync\n", from);
+        }
+    }
+    n->rollbackFrom = UINT32_MAX;
+
+    // Too far ahead of the peer: wait for its inputs instead of predicting further
+    if ((Sint32)(n->currentTick - n->confirmedRemoteTick) >= NET_MAX_ROLLBACK) {
+        n->stalls++;
+        sendInputs(n);
+        return false;
+    }
+
+    // Local input takes effect inputDelay ticks from now
+    n->inputs[n->localPlayer][slot(n->nextLocalTick)] = localInput;
+    n->confirmedTick[n->localPlayer][slot(n->nextLocalTick)] = n->nextLocalTick + 1;
+    n->nextLocalTick++;
+
+    simulateTick(n, g, n->currentTick, screen_width, screen_height);
+    n->currentTick++;
+    n->ticks++;
+
+    sendInputs(n);
+    return true;
+}
+
+void drawNetplayStats(NetSession* n) {
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse |
+                             ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing;
+    igSetNextWindowPos((ImVec2){10.0f, 420.0f}, ImGuiCond_FirstUseEver, (ImVec2){0.0f, 0.0f});
+    igBegin("Netplay", NULL, flags);
+
+    float rollbackRate = n->ticks ? 100.0f * n->rollbacks / n->ticks : 0.0f;
+    float avgDepth = n->rollbacks ? (float)n->resimTicks / n->rollbacks : 0.0f;
+    float msPerFrame = n->ticks ? (float)(n->resimMsTotal / n->ticks) : 0.0f;
+
+    igText("Player %d, tick %u, input delay %d", n->localPlayer + 1, n->currentTick, n->inputDelay);
+    igText("Remote lag: %d ticks", (int)(n->currentTick - n->confirmedRemoteTick));
+    igText("Rollbacks: %llu (%.1f%% of ticks), avg depth %.1f, max %d",
+           (unsigned long long)n->rollbacks, rollbackRate, avgDepth, n->worstRollbackDepth);
+    igText("Re-sim: %.3f ms/frame, last %.3f ms, worst %.3f ms", msPerFrame, n->lastResimMs, n->worstResimMs);
+    igText("Stalls: %llu", (unsigned long long)n->stalls);
+    igText("Packets: %llu sent, %llu received, %llu dropped by shim",
+           (unsigned long long)n->packetsSent, (unsigned long long)n->packetsReceived,
+           (unsigned long long)n->packetsDropped);
+    if (n->latencyMs > 0.0f || n->jitterMs > 0.0f || n->lossPercent > 0.0f) {
+        igText("Shim: %.0f ms +/- %.0f ms, %.1f%% loss", n->latencyMs, n->jitterMs, n->lossPercent);
+    }
+    igEnd();
+}
+
+void printNetplaySummary(NetSession* n) {
+    if (n->ticks == 0) return;
+    printf("[netplay] %llu ticks, %llu rollbacks (%.1f%%), %llu re-simulated ticks, %llu stalls\n",
+           (unsigned long long)n->ticks, (unsigned long long)n->rollbacks, 100.0 * n->rollbacks / n->ticks,
+           (unsigned long long)n->resimTicks, (unsigned long long)n->stalls);
+    printf("[netplay] Re-sim cost: %.3f ms/frame average, %.3f ms per rollback, worst %.3f ms (depth %d)\n",
+           n->resimMsTotal / n->ticks, n->rollbacks ? n->resimMsTotal / n->rollbacks : 0.0,
+           n->worstResimMs, n->worstRollbackDepth);
+}
+
+void netplayStop(NetSession* n) {
+    if (n->socket >= 0) close(n->socket);
+    n->socket = -1;
+    for (int i = 0; i <= NET_MAX_ROLLBACK; i++) {
+        free(n->snapshots[i]);
+        n->snapshots[i] = NULL;
+    }
+}
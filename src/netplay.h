@@ -0,0 +1,68 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <netinet/in.h>
+#include "init.h"
+
+#define NET_MAX_ROLLBACK 8          // ticks the local sim may run ahead of confirmed remote input
+#define NET_INPUT_HISTORY 128       // input ring size, power of two
+#define NET_MAX_INPUTS_PER_PACKET 32
+#define NET_PACKET_SIZE 512
+#define NET_SHIM_QUEUE 256
+
+// Both peers must simulate with the same view size, it decides camera and culling
+#define NET_VIEW_WIDTH 1920
+#define NET_VIEW_HEIGHT 1080
+
+// Outgoing packet held back by the latency shim
+typedef struct {
+    Uint8 data[NET_PACKET_SIZE];
+    int length;
+    Uint32 sendAt;          // SDL_GetTicks deadline
+} DelayedPacket;
+
+// Two-player rollback session: inputs are exchanged over UDP, the remote input is
+// predicted and the sim rolled back and re-simulated when a prediction was wrong
+typedef struct {
+    int socket;
+    struct sockaddr_in remote;
+    int localPlayer;
+    int inputDelay;
+
+    Uint32 currentTick;                     // next tick to simulate
+    SimInput inputs[2][NET_INPUT_HISTORY];  // indexed by tick % NET_INPUT_HISTORY
+    Uint32 confirmedTick[2][NET_INPUT_HISTORY];   // tick + 1 when the slot holds a confirmed input
+    Uint32 nextLocalTick;                   // next tick a local input is recorded for
+    Uint32 confirmedRemoteTick;             // remote inputs confirmed for every tick below this
+    Uint32 remoteAck;                       // our inputs the peer has confirmed
+    Uint32 rollbackFrom;                    // earliest mispredicted tick, UINT32_MAX if none
+
+    SimState* snapshots[NET_MAX_ROLLBACK + 1];   // state before each tick, by tick % size
+    Uint32 snapshotTick[NET_MAX_ROLLBACK + 1];
+
+    // Latency/jitter/loss shim applied to outgoing packets
+    float latencyMs, jitterMs, lossPercent;
+    DelayedPacket queue[NET_SHIM_QUEUE];
+    int queued;
+    Uint32 shimRandom;
+
+    // Rollback statistics
+    Uint64 ticks;
+    Uint64 rollbacks;
+    Uint64 resimTicks;
+    Uint64 stalls;
+    Uint64 packetsSent, packetsReceived, packetsDropped;
+    double resimMsTotal;
+    float lastResimMs;
+    float worstResimMs;
+    int worstRollbackDepth;
+} NetSession;
+
+bool netplayStart(NetSession* n, int localPlayer, int localPort, const char* remoteHost, int remotePort, int inputDelay);
+void netplaySetShim(NetSession* n, float latencyMs, float jitterMs, float lossPercent);
+bool netplayAdvance(NetSession* n, GameData* g, SimInput localInput, int screen_width, int screen_height);
+void drawNetplayStats(NetSession* n);
+void printNetplaySummary(NetSession* n);
+void netplayStop(NetSession* n);
+
+#endif
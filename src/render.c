@@ -1,17 +1,21 @@
 #include "render.h"
+#include "worldcache.h"
+#include "scaler.h"
+#include "stream.h"
 
 #define PI 3.14159265358979323846
 #define SQUARE_WIDTH 2
 
-// Initialize Hill Noise
-void initHillNoise(HillNoise* hn, float* sizes, int num_sizes) {
+// Initialize Hill Noise, the same seed always gives the same hills
+void initHillNoise(HillNoise* hn, float* sizes, int num_sizes, uint32_t seed) {
+    uint32_t random = seed ? seed : 1;
     hn->sizes = sizes;
     hn->offsets = (float*)malloc(num_sizes * sizeof(float));
     hn->num_sizes = num_sizes;
     hn->sigma = 0.0f;
 
     for (int i = 0; i < num_sizes; i++) {
-        hn->offsets[i] = ((float)rand() / RAND_MAX) * 2 * PI;
+        hn->offsets[i] = simRandomFloat(&random) * 2 * PI;
         hn->sigma += powf(sizes[i] / 2.0f, 2);
     }
     hn->sigma = sqrtf(hn->sigma);
@@ -43,30 +47,124 @@ void freeHillNoise(HillNoise* hn) {
     free(hn->offsets);
 }
 
-void renderBackground(GameData g, SDL_Renderer* renderer, int screen_width, int screen_height) {
-    SDL_Rect bgRect = {(int)(g.cameraX), 0, screen_width, screen_height};
-    SDL_RenderCopy(renderer, g.backgroundTexture, &bgRect, NULL);
+// Backend primitives: the instanced GL sprite batch when it is enabled, SDL_Renderer otherwise
+static void fillRect(SDL_Renderer* renderer, GLRenderer* gl, const SDL_Rect* rect, SDL_Color color) {
+    if (gl) {
+        glRendererFill(gl, rect, color);
+    } else {
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRect(renderer, rect);
+    }
+}
+
+static void copyTexture(SDL_Renderer* renderer, GLRenderer* gl, SDL_Texture* texture, int page, const SDL_Rect* src, const SDL_Rect* dst) {
+    if (gl) {
+        glRendererSprite(gl, page, src, dst, (SDL_Color){255, 255, 255, 255});
+    } else {
+        SDL_RenderCopy(renderer, texture, src, dst);
+    }
 }
 
-void renderTerrains(GameData g, SDL_Renderer* renderer, HillNoise* hn, float startX, SDL_Color color, float heightScale, int screen_height) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a); // Set terrain color
+// Draws a frame of one of the level's sprite sheets, skipping sheets that failed to load
+static void drawSprite(GameData g, SDL_Renderer* renderer, int sprite, const SDL_Rect* src, const SDL_Rect* dst) {
+    if (sprite < 0 || sprite >= g.numSprites) return;
+    copyTexture(renderer, g.gl, g.sprites[sprite].texture, g.sprites[sprite].page, src, dst);
+}
+
+void clearScreen(SDL_Renderer* renderer, GLRenderer* gl, int screen_width, int screen_height) {
+    if (gl) {
+        glViewport(0, 0, screen_width, screen_height);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    } else {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+    }
+}
 
-    for (float x = startX; x < WORLD_WIDTH; x += 1) {
-        float yNoise = evaluateHillNoise(hn, 3*x); // Noise-based terrain generation
+void renderBackground(GameData g, SDL_Renderer* renderer, int screen_width, int screen_height) {
+    SDL_Rect bgRect = {(int)(streamOriginX(g.world.sim) + g.world.sim->cameraX), 0, screen_width, screen_height};
+    SDL_Rect screenRect = {0, 0, screen_width, screen_height};
+    copyTexture(renderer, g.gl, g.backgroundTexture, g.backgroundPage, &bgRect, &screenRect);
+}
+
+// startX is a world column. Columns are placed from the state's origin, so they
+// stay put on screen far along a streamed level, and shaped by their world column.
+void renderTerrains(GameData g, SDL_Renderer* renderer, HillNoise* hn, float startX, SDL_Color color, float heightScale, int screen_width, int screen_height) {
+    double originColumn = streamOriginX(g.world.sim) / SQUARE_WIDTH;
+    // Only the columns in the window, a streamed level has far more than fit on screen
+    float first = fmaxf((float)(startX - originColumn), floorf(g.world.sim->cameraX / SQUARE_WIDTH));
+    float end = fminf((float)(g.world.sim->worldWidth - originColumn), ceilf((g.world.sim->cameraX + screen_width) / SQUARE_WIDTH));
+    for (float x = first; x < end; x += 1) {
+        float yNoise = evaluateHillNoise(hn, 3 * (float)(originColumn + x)); // Noise-based terrain generation
         float y = screen_height - (yNoise * heightScale); // Scale and adjust height
         
         SDL_Rect filledArea;
-        filledArea.x = (int)(x * SQUARE_WIDTH - g.cameraX);
+        filledArea.x = (int)(x * SQUARE_WIDTH - g.world.sim->cameraX);
         filledArea.y = (int)(y);
         filledArea.w = SQUARE_WIDTH;
         filledArea.h = (int)(screen_height - y);
 
-        SDL_RenderFillRect(renderer, &filledArea);
+        fillRect(renderer, g.gl, &filledArea, color);
     }
 }
 
+// HUD text for the GL backend, which has no SDL_Renderer to upload TTF surfaces to
+static void renderTextImGui(const char* turnText, const char* scoreText, const char* ammoText, const char* timeText, int screen_width) {
+    const float fontSize = 24.0f;
+    const ImU32 black = 0xFF000000;
+    const ImU32 yellow = 0xFF00FFFF;
+    ImDrawList* drawList = igGetBackgroundDrawList(NULL);
+
+    ImVec2 turnSize;
+    igCalcTextSize(&turnSize, turnText, NULL, false, -1.0f);
+    float turnWidth = turnSize.x * fontSize / igGetFontSize();
+    ImDrawList_AddText_FontPtr(drawList, NULL, fontSize, (ImVec2){screen_width / 2 - turnWidth / 2, 10}, black, turnText, NULL, 0.0f, NULL);
+
+    const char* lines[] = {scoreText, ammoText, timeText};
+    int yPositions[] = {40, 70, 100};
+    for (int j = 0; j < 3; j++) {
+        ImDrawList_AddText_FontPtr(drawList, NULL, fontSize, (ImVec2){10, yPositions[j]}, yellow, lines[j], NULL, 0.0f, NULL);
+    }
+}
+
+// Marks the HUD text stale when an event changed what it shows
+void readHudEvents(HudCache* hud, const SimContext* ctx) {
+    const SimEvent* event;
+    while ((event = nextSimEvent(ctx, &hud->events)) != NULL) {
+        if (event->type == SIM_EVENT_SCORE || event->type == SIM_EVENT_SHOT || event->type == SIM_EVENT_PICKUP) {
+            hud->dirty = true;
+        }
+    }
+}
+
+void freeHudCache(HudCache* hud) {
+    for (int j = 0; j < 3; j++) {
+        if (hud->lines[j]) SDL_DestroyTexture(hud->lines[j]);
+        hud->lines[j] = NULL;
+    }
+}
+
+static void rebuildHudLines(HudCache* hud, SDL_Renderer* renderer, TTF_Font* font, const char* turnText,
+                            const char* scoreText, const char* ammoText) {
+    const char* texts[3] = {turnText, scoreText, ammoText};
+    SDL_Color colors[3] = {{0, 0, 0, 255}, {255, 255, 0, 255}, {255, 255, 0, 255}};
+
+    freeHudCache(hud);
+    for (int j = 0; j < 3; j++) {
+        SDL_Surface* surface = TTF_RenderText_Solid(font, texts[j], colors[j]);
+        if (surface == NULL) continue;
+        hud->lines[j] = SDL_CreateTextureFromSurface(renderer, surface);
+        // Turn indicator at the top (centred when drawn), player stats down the left
+        hud->rects[j] = (SDL_Rect){10, j == 0 ? 10 : 40 + 30 * (j - 1), surface->w, surface->h};
+        SDL_FreeSurface(surface);
+    }
+    hud->dirty = false;
+    hud->rebuilds++;
+}
+
 void renderText(GameData g, SDL_Renderer* renderer, TTF_Font* font, int screen_width) {
-    int currentPlayer = g.isPlayer1Turn ? 0 : 1;
+    int currentPlayer = g.world.sim->isPlayer1Turn ? 0 : 1;
 
     // Create text for current turn indicator
     char turnText[50];
@@ -74,77 +172,92 @@ void renderText(GameData g, SDL_Renderer* renderer, TTF_Font* font, int screen_w
 
     // Render text only for the current player's stats
     char scoreText[30];
-    snprintf(scoreText, sizeof(scoreText), "P%d Score: %d", currentPlayer + 1, g.shooters[currentPlayer].score);
+    snprintf(scoreText, sizeof(scoreText), "P%d Score: %d", currentPlayer + 1, g.world.shooters[currentPlayer].score);
     char ammoText[30];
-    snprintf(ammoText, sizeof(ammoText), "P%d Ammo: %d", currentPlayer + 1, g.shooters[currentPlayer].ammo);
+    snprintf(ammoText, sizeof(ammoText), "P%d Ammo: %d", currentPlayer + 1, g.world.shooters[currentPlayer].ammo);
     char timeText[30];
-    snprintf(timeText, sizeof(timeText), "P%d Time: %.2lf", currentPlayer + 1, g.shooters[currentPlayer].time);
+    snprintf(timeText, sizeof(timeText), "P%d Time: %.2lf", currentPlayer + 1, g.world.shooters[currentPlayer].time);
 
     SDL_Color textColor = {255, 255, 0, 255}; // Yellow for active player
 
-    // Render turn indicator
-    SDL_Surface* turnSurface = TTF_RenderText_Solid(font, turnText, (SDL_Color){0, 0, 0, 255});
-    if (turnSurface) {
-        SDL_Texture* turnTexture = SDL_CreateTextureFromSurface(renderer, turnSurface);
-        
-        SDL_Rect turnRect;
-        turnRect.x = screen_width / 2 - turnSurface->w / 2;
-        turnRect.y = 10;
-        turnRect.w = turnSurface->w;
-        turnRect.h = turnSurface->h;
-
-        SDL_RenderCopy(renderer, turnTexture, NULL, &turnRect);
-        SDL_FreeSurface(turnSurface);
-        SDL_DestroyTexture(turnTexture);
-    }
-
-    // Render player stats
-    SDL_Surface* surfaces[] = {
-        TTF_RenderText_Solid(font, scoreText, textColor),
-        TTF_RenderText_Solid(font, ammoText, textColor),
-        TTF_RenderText_Solid(font, timeText, textColor)
-    };
-
-    int yPositions[] = {40, 70, 100};
+    if (g.gl) {
+        renderTextImGui(turnText, scoreText, ammoText, timeText, screen_width);
+        return;
+    }
 
-    for (int j = 0; j < 3; j++) {
-        if (surfaces[j]) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surfaces[j]);
-            SDL_Rect renderQuad = {10, yPositions[j], surfaces[j]->w, surfaces[j]->h};
-            SDL_RenderCopy(renderer, texture, NULL, &renderQuad);
-            SDL_FreeSurface(surfaces[j]);
-            SDL_DestroyTexture(texture);
+    HudCache* hud = g.hud;
+    if (hud && (hud->dirty || hud->player != currentPlayer || hud->lines[0] == NULL)) {
+        rebuildHudLines(hud, renderer, font, turnText, scoreText, ammoText);
+        hud->player = currentPlayer;
+    }
+    if (hud) {
+        hud->rects[0].x = screen_width / 2 - hud->rects[0].w / 2;
+        for (int j = 0; j < 3; j++) {
+            if (hud->lines[j]) SDL_RenderCopy(renderer, hud->lines[j], NULL, &hud->rects[j]);
         }
     }
+
+    // The clock changes every frame
+    SDL_Surface* timeSurface = TTF_RenderText_Solid(font, timeText, textColor);
+    if (timeSurface) {
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, timeSurface);
+        SDL_Rect renderQuad = {10, 100, timeSurface->w, timeSurface->h};
+        SDL_RenderCopy(renderer, texture, NULL, &renderQuad);
+        SDL_FreeSurface(timeSurface);
+        SDL_DestroyTexture(texture);
+    }
 }
 
 void renderHearts(GameData g, SDL_Renderer* renderer) {
-    int currentPlayer = g.isPlayer1Turn ? 0 : 1;
+    int currentPlayer = g.world.sim->isPlayer1Turn ? 0 : 1;
 
     SDL_Color heartColor = {255, 0, 0, 255}; 
-    SDL_SetRenderDrawColor(renderer, heartColor.r, heartColor.g, heartColor.b, heartColor.a);
     int offSet = 60;
 
-    for (int i = 0; i < g.shooters[currentPlayer].health; i++) {
+    for (int i = 0; i < g.world.shooters[currentPlayer].health; i++) {
         SDL_Rect heartRect;
         heartRect.x = 10 + offSet*i;
         heartRect.y = 130;
         heartRect.w = 50;
         heartRect.h = 50;
 
-        SDL_RenderFillRect(renderer, &heartRect);
+        fillRect(renderer, g.gl, &heartRect, heartColor);
     }
 }
 
-void drawShooter(GameData g, SDL_Renderer* renderer) {
-    Shooter* currentShooter = &g.shooters[g.isPlayer1Turn ? 0 : 1];
-    SDL_Texture* currentTexture = currentShooter->texture;
+// Animation advances where the entity is drawn, once per frame however many views show it
+static void animateShooter(Shooter* shooter, float deltaTime) {
+    shooter->animationTimer += deltaTime;
+    if (shooter->animationTimer >= shooter->frameDelay) {
+        shooter->currentFrame = (shooter->currentFrame + 1) % shooter->totalFrames;
+        shooter->animationTimer = 0;
+    }
+}
+
+static void animateEnemy(Enemy* enemy, float deltaTime) {
+    enemy->animationTimer += deltaTime;
+    if (enemy->animationTimer >= enemy->frameDelay) {
+        enemy->currentFrame = (enemy->currentFrame + 1) % enemy->totalFrames;
+        enemy->animationTimer = 0;
+    }
+}
 
-    currentShooter->animationTimer += g.deltaTime;
-    if (currentShooter->animationTimer >= currentShooter->frameDelay) {
-        currentShooter->currentFrame = (currentShooter->currentFrame + 1) % currentShooter->totalFrames;
-        currentShooter->animationTimer = 0;
+#define BULLET_FRAME_DELAY 0.1f
+#define BULLET_FRAMES 4
+#define BULLET_FRAME_WIDTH 16
+#define BULLET_SIZE 40
+
+// Kept in the simulation state so snapshots include it
+static void animateBullets(GameData g) {
+    g.world.sim->bulletAnimationTimer += g.deltaTime;
+    if (g.world.sim->bulletAnimationTimer >= BULLET_FRAME_DELAY) {
+        g.world.sim->bulletFrame = (g.world.sim->bulletFrame + 1) % BULLET_FRAMES;
+        g.world.sim->bulletAnimationTimer = 0;
     }
+}
+
+static void drawOneShooter(GameData g, SDL_Renderer* renderer, Shooter* currentShooter) {
+    animateShooter(currentShooter, g.deltaTime);
 
     SDL_Rect srcRect;
     srcRect.x = currentShooter->currentFrame * currentShooter->frameWidth;
@@ -153,54 +266,81 @@ void drawShooter(GameData g, SDL_Renderer* renderer) {
     srcRect.h = currentShooter->frameHeight;
 
     SDL_Rect dstRect;
-    dstRect.x = (int)(currentShooter->x - g.cameraX);
+    dstRect.x = (int)(currentShooter->x - g.world.sim->cameraX);
     dstRect.y = (int)(currentShooter->y);
     dstRect.w = currentShooter->width;
     dstRect.h = currentShooter->height;
 
-    SDL_RenderCopy(renderer, currentTexture, &srcRect, &dstRect);
+    drawSprite(g, renderer, currentShooter->sprite, &srcRect, &dstRect);
+}
+
+#define GHOST_ALPHA 96
+
+// Same sprite as player 1 at the recorded position, faded: a tinted instance in
+// the GL batch's blended pass, an alpha-modulated copy on the SDL_Renderer path
+static void drawGhost(GameData g, SDL_Renderer* renderer) {
+    Shooter* recorded = &g.world.shooters[0];
+    if (recorded->sprite < 0 || recorded->sprite >= g.numSprites) return;
+    const SpriteSheet* sheet = &g.sprites[recorded->sprite];
+    SDL_Rect srcRect = {g.ghost.currentFrame * recorded->frameWidth, 0, recorded->frameWidth, recorded->frameHeight};
+    SDL_Rect dstRect = {(int)(g.ghost.x - g.world.sim->cameraX), (int)(g.ghost.y), recorded->width, recorded->height};
+
+    if (g.gl) {
+        glRendererSprite(g.gl, sheet->page, &srcRect, &dstRect, (SDL_Color){255, 255, 255, GHOST_ALPHA});
+        return;
+    }
+    if (sheet->texture == NULL) return;
+    SDL_SetTextureAlphaMod(sheet->texture, GHOST_ALPHA);
+    SDL_RenderCopy(renderer, sheet->texture, &srcRect, &dstRect);
+    SDL_SetTextureAlphaMod(sheet->texture, 255);
+}
+
+void drawShooter(GameData g, SDL_Renderer* renderer) {
+    // Both players are on screen in versus mode
+    if (g.world.sim->versus) {
+        for (int i = 0; i < 2; i++) {
+            if (!g.world.shooters[i].dead) drawOneShooter(g, renderer, &g.world.shooters[i]);
+        }
+        return;
+    }
+    if (g.ghost.visible && !g.world.sim->isPlayer1Turn) drawGhost(g, renderer);
+    drawOneShooter(g, renderer, &g.world.shooters[g.world.sim->isPlayer1Turn ? 0 : 1]);
 }
 
 void drawPlatforms(GameData g, SDL_Renderer* renderer) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);  // Blue platforms
-    for (int i = 0; i < g.numPlatforms; i++) {
+    SDL_Color platformColor = {0, 0, 255, 255};  // Blue platforms
+    for (int i = 0; i < g.world.numPlatforms; i++) {
+        // Empty slot of a streamed level
+        if (g.world.platforms[i].width <= 0) continue;
         SDL_Rect platformRect = {
-            (int)(g.platforms[i].x - g.cameraX), 
-            (int)(g.platforms[i].y), 
-            (int)(g.platforms[i].width), 
-            (int)(g.platforms[i].height)
+            (int)(g.world.platforms[i].x - g.world.sim->cameraX), 
+            (int)(g.world.platforms[i].y), 
+            (int)(g.world.platforms[i].width), 
+            (int)(g.world.platforms[i].height)
         };
-        SDL_RenderFillRect(renderer, &platformRect);
+        fillRect(renderer, g.gl, &platformRect, platformColor);
     }
 }
 
 void drawCollectibles(GameData g, SDL_Renderer* renderer) {
-    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);  // Yellow collectibles
-    for (int i = 0; i < g.numCollectibles; i++) {
-        if (!g.collectibles[i].collected) {
+    SDL_Color collectibleColor = {255, 255, 0, 255};  // Yellow collectibles
+    for (int i = 0; i < g.world.numCollectibles; i++) {
+        if (!g.world.collectibles[i].collected) {
             SDL_Rect collectibleRect = {
-                (int)(g.collectibles[i].x - g.cameraX), 
-                (int)g.collectibles[i].y, 
-                g.collectibles[i].width, 
-                g.collectibles[i].height
+                (int)(g.world.collectibles[i].x - g.world.sim->cameraX), 
+                (int)g.world.collectibles[i].y, 
+                g.world.collectibles[i].width, 
+                g.world.collectibles[i].height
             };
-            SDL_RenderFillRect(renderer, &collectibleRect);
+            fillRect(renderer, g.gl, &collectibleRect, collectibleColor);
         }
     }
 }
 
 void drawEnemies1(GameData g, SDL_Renderer* renderer) {
-    for (int i = 0; i < g.numEnemies1; i++) {
-        Enemy* currentEnemy = &g.enemies1[i];
-        SDL_Texture* currentTexture = currentEnemy->texture;
-        
-        // animation update
-        currentEnemy->animationTimer += g.deltaTime;
-        if (currentEnemy->animationTimer >= currentEnemy->frameDelay) {
-            currentEnemy->currentFrame = (currentEnemy->currentFrame + 1) % currentEnemy->totalFrames;
-            currentEnemy->animationTimer = 0;
-        }
-
+    for (int i = 0; i < g.world.numEnemies1; i++) {
+        Enemy* currentEnemy = &g.world.enemies1[i];
+        animateEnemy(currentEnemy, g.deltaTime);
         if (currentEnemy->active) {
             SDL_Rect srcRect;
             srcRect.x = currentEnemy->currentFrame * currentEnemy->frameWidth;
@@ -209,27 +349,20 @@ void drawEnemies1(GameData g, SDL_Renderer* renderer) {
             srcRect.h = currentEnemy->frameHeight;
 
             SDL_Rect dstRect;
-            dstRect.x = (int)(currentEnemy->x - g.cameraX); 
+            dstRect.x = (int)(currentEnemy->x - g.world.sim->cameraX); 
             dstRect.y = (int)(currentEnemy->y);
             dstRect.w = currentEnemy->width;  
             dstRect.h = currentEnemy->height;
 
-            SDL_RenderCopy(renderer, currentTexture, &srcRect, &dstRect);
+            drawSprite(g, renderer, currentEnemy->sprite, &srcRect, &dstRect);
         }
     }
 }
 
 void drawEnemies2(GameData g, SDL_Renderer* renderer) {
-    for (int i = 0; i < g.numEnemies2; i++) {
-        Enemy* currentEnemy = &g.enemies2[i];
-        SDL_Texture* currentTexture = currentEnemy->texture;
-
-        // Animation update
-        currentEnemy->animationTimer += g.deltaTime;
-        if (currentEnemy->animationTimer >= currentEnemy->frameDelay) {
-            currentEnemy->currentFrame = (currentEnemy->currentFrame + 1) % currentEnemy->totalFrames;
-            currentEnemy->animationTimer = 0;
-        }
+    for (int i = 0; i < g.world.numEnemies2; i++) {
+        Enemy* currentEnemy = &g.world.enemies2[i];
+        animateEnemy(currentEnemy, g.deltaTime);
         if (currentEnemy->active) {
             SDL_Rect srcRect;
             srcRect.x = currentEnemy->currentFrame * currentEnemy->frameWidth;
@@ -238,78 +371,370 @@ void drawEnemies2(GameData g, SDL_Renderer* renderer) {
             srcRect.h = currentEnemy->frameHeight;
 
             SDL_Rect dstRect;
-            dstRect.x = (int)(currentEnemy->x - g.cameraX); 
+            dstRect.x = (int)(currentEnemy->x - g.world.sim->cameraX); 
             dstRect.y = (int)(currentEnemy->y);
             dstRect.w = currentEnemy->width;  
             dstRect.h = currentEnemy->height;
 
-            SDL_RenderCopy(renderer, currentTexture, &srcRect, &dstRect);
+            drawSprite(g, renderer, currentEnemy->sprite, &srcRect, &dstRect);
         }
     }
 }
 
 void drawBullets(GameData g, SDL_Renderer* renderer) {
-    static int currentFrame = 0;
-    static float animationTimer = 0;  
-    const float frameDelay = 0.1f;    
-    const int totalFrames = 4;        
-    
-    // Update animation timer
-    animationTimer += g.deltaTime;
-    if (animationTimer >= frameDelay) {
-        currentFrame = (currentFrame + 1) % totalFrames;
-        animationTimer = 0;
-    }
-    int frameWidth = 16;  
-
-    for (int i = 0; i < g.ammo + 1; i++) {
-        if (g.bullets[i].active) {
+    animateBullets(g);
+
+    for (int i = 0; i < g.world.ammo + 1; i++) {
+        if (g.world.bullets[i].active) {
             SDL_Rect srcRect;
-            srcRect.x = currentFrame * frameWidth;
+            srcRect.x = g.world.sim->bulletFrame * BULLET_FRAME_WIDTH;
             srcRect.y = 0;
-            srcRect.w = frameWidth;
+            srcRect.w = BULLET_FRAME_WIDTH;
             srcRect.h = 16;
 
             SDL_Rect dstRect;
-            dstRect.x = (int)(g.bullets[i].x - g.cameraX);
-            dstRect.y = (int)g.bullets[i].y;
-            dstRect.w = 40;
-            dstRect.h = 40;
+            dstRect.x = (int)(g.world.bullets[i].x - g.world.sim->cameraX);
+            dstRect.y = (int)g.world.bullets[i].y;
+            dstRect.w = BULLET_SIZE;
+            dstRect.h = BULLET_SIZE;
+
+            copyTexture(renderer, g.gl, g.bulletSpriteSheet, g.bulletPage, &srcRect, &dstRect);
+        }
+    }
+}
 
-            SDL_RenderCopy(renderer, g.bulletSpriteSheet, &srcRect, &dstRect);
+// Particles go out one sheet at a time so each sheet is a single run of copies
+// from one texture: one instanced draw on the GL path, one SDL render batch otherwise
+void drawFx(GameData g, SDL_Renderer* renderer) {
+    const FxPool* fx = g.fx;
+    if (fx == NULL || fx->count == 0) return;
+    float left = g.world.sim->cameraX;
+    for (int s = 0; s < FX_SHEETS; s++) {
+        if (g.gl ? g.fxPages[s] < 0 : g.fxSheets[s] == NULL) continue;
+        const FxSheetInfo* info = &fxSheetInfo[s];
+        for (int i = 0; i < fx->count; i++) {
+            if (fx->sheet[i] != s) continue;
+            int w = (int)(info->frameWidth * fx->scale[i]);
+            int h = (int)(info->frameHeight * fx->scale[i]);
+            SDL_Rect srcRect = {fxFrame(fx, i) * info->frameWidth, 0, info->frameWidth, info->frameHeight};
+            SDL_Rect dstRect = {(int)(fx->x[i] - left) - w / 2, (int)fx->y[i] - h / 2, w, h};
+            copyTexture(renderer, g.gl, g.fxSheets[s], g.fxPages[s], &srcRect, &dstRect);
         }
     }
 }
 
 void drawAmmo(GameData g, SDL_Renderer* renderer) {
-    SDL_SetRenderDrawColor(renderer, 255, 200, 0, 255);  // Yellow collectibles
-    for (int i = 0; i < g.numAmmos; i++) {
-        if (!g.ammos[i].collected) {
+    SDL_Color ammoColor = {255, 200, 0, 255};  // Yellow collectibles
+    for (int i = 0; i < g.world.numAmmos; i++) {
+        if (!g.world.ammos[i].collected) {
             SDL_Rect ammoRect;
-            ammoRect.x = (int)(g.ammos[i].x - g.cameraX);
-            ammoRect.y = (int)g.ammos[i].y;
-            ammoRect.w = g.ammos[i].width;
-            ammoRect.h = g.ammos[i].height;
+            ammoRect.x = (int)(g.world.ammos[i].x - g.world.sim->cameraX);
+            ammoRect.y = (int)g.world.ammos[i].y;
+            ammoRect.w = g.world.ammos[i].width;
+            ammoRect.h = g.world.ammos[i].height;
 
-            SDL_RenderFillRect(renderer, &ammoRect);
+            fillRect(renderer, g.gl, &ammoRect, ammoColor);
         }
     }
 }
 
 void drawFinishFlag(GameData g, SDL_Renderer* renderer, int screen_height) {
-    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 200);
     SDL_Rect flagRect = {
-        (int)(WORLD_WIDTH - g.cameraX),
+        (int)(g.world.sim->worldWidth - streamOriginX(g.world.sim) - g.world.sim->cameraX),
         screen_height - 600,
         50,
         600
     };
-    SDL_RenderFillRect(renderer, &flagRect);
+    fillRect(renderer, g.gl, &flagRect, (SDL_Color){200, 200, 200, 200});
 }
 
 void drawPauseButton(GameData g, SDL_Renderer* renderer) {
     SDL_Rect pauseButtonRect = {1820, 50, 100, 100};
-    SDL_RenderCopy(renderer, g.pauseTexture, NULL, &pauseButtonRect);
+    copyTexture(renderer, g.gl, g.pauseTexture, g.pausePage, NULL, &pauseButtonRect);
+}
+
+// Everything that never changes during a level, only scrolls with the camera
+void renderStaticLayers(GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height) {
+    // Render background
+    renderBackground(g, renderer, screen_width, screen_height);
+
+    // Render generated terrain
+    renderTerrains(g, renderer, hn, 0, (SDL_Color){34, 139, 34, 255}, 500, screen_width, screen_height);
+    renderTerrains(g, renderer, hn, 0, (SDL_Color){144, 238, 54, 255}, 300, screen_width, screen_height);
+
+    drawPlatforms(g, renderer);
+}
+
+// Split screen: both players side by side, each viewport following its own shooter
+
+#define SPLIT_INITIAL_ITEMS 1024
+#define SPLIT_DIVIDER 4
+
+// Painter's order of the entity kinds, as render() draws them
+enum {
+    SPLIT_LAYER_PICKUPS,
+    SPLIT_LAYER_ENEMIES,
+    SPLIT_LAYER_SHOOTERS,
+    SPLIT_LAYER_BULLETS,
+    SPLIT_LAYER_FX,
+    SPLIT_LAYER_FLAG
+};
+
+void freeSplitBatch(SplitBatch* split) {
+    free(split->items);
+    split->items = NULL;
+    split->count = 0;
+    split->capacity = 0;
+}
+
+// Culls one world rect against both camera windows and keeps it if either shows it
+static void pushSplitItem(SplitBatch* split, int layer, SDL_Texture* texture, int page, const SDL_Rect* src,
+                          const SDL_Rect* dst, SDL_Color color) {
+    Uint8 views = 0;
+    for (int v = 0; v < 2; v++) {
+        float left = split->cameraX[v];
+        if (dst->x + dst->w > left && dst->x < left + split->viewports[v].w) views |= (Uint8)(1 << v);
+    }
+    if (views == 0) return;
+
+    if (split->count == split->capacity) {
+        int capacity = split->capacity > 0 ? split->capacity * 2 : SPLIT_INITIAL_ITEMS;
+        SplitItem* items = (SplitItem*)realloc(split->items, capacity * sizeof(SplitItem));
+        if (items == NULL) return;
+        split->items = items;
+        split->capacity = capacity;
+    }
+    SplitItem* item = &split->items[split->count];
+    item->src = src ? *src : (SDL_Rect){0, 0, 0, 0};
+    item->dst = *dst;
+    item->texture = texture;
+    item->page = page;
+    item->color = color;
+    item->layer = (Uint8)layer;
+    item->views = views;
+    item->order = split->count++;
+    if (views == 3) split->shared++;
+}
+
+static void pushSplitSprite(GameData g, SplitBatch* split, int layer, int sprite, const SDL_Rect* src, const SDL_Rect* dst) {
+    if (sprite < 0 || sprite >= g.numSprites || (!g.gl && g.sprites[sprite].texture == NULL)) return;
+    pushSplitItem(split, layer, g.sprites[sprite].texture, g.sprites[sprite].page, src, dst, (SDL_Color){255, 255, 255, 255});
+}
+
+static void pushSplitFill(GameData g, SplitBatch* split, int layer, const SDL_Rect* dst, SDL_Color color) {
+    pushSplitItem(split, layer, NULL, g.gl ? g.gl->whitePage : -1, NULL, dst, color);
+}
+
+// Layer first, then sheet, so each view's copies run from one texture at a time
+static int compareSplitItems(const void* a, const void* b) {
+    const SplitItem* x = (const SplitItem*)a;
+    const SplitItem* y = (const SplitItem*)b;
+    if (x->layer != y->layer) return x->layer < y->layer ? -1 : 1;
+    if (x->texture != y->texture) return (uintptr_t)x->texture < (uintptr_t)y->texture ? -1 : 1;
+    if (x->page != y->page) return x->page < y->page ? -1 : 1;
+    return x->order - y->order;
+}
+
+// The one visibility and animation pass for both views, in world coordinates
+static void buildSplitBatch(GameData g, SplitBatch* split) {
+    SimContext* world = &g.world;
+    split->count = 0;
+    split->shared = 0;
+
+    for (int i = 0; i < world->numCollectibles; i++) {
+        const Collectible* c = &world->collectibles[i];
+        if (c->collected) continue;
+        SDL_Rect dst = {(int)c->x, (int)c->y, c->width, c->height};
+        pushSplitFill(g, split, SPLIT_LAYER_PICKUPS, &dst, (SDL_Color){255, 255, 0, 255});
+    }
+    for (int i = 0; i < world->numAmmos; i++) {
+        const Collectible* a = &world->ammos[i];
+        if (a->collected) continue;
+        SDL_Rect dst = {(int)a->x, (int)a->y, a->width, a->height};
+        pushSplitFill(g, split, SPLIT_LAYER_PICKUPS, &dst, (SDL_Color){255, 200, 0, 255});
+    }
+
+    Enemy* tables[2] = {world->enemies1, world->enemies2};
+    int counts[2] = {world->numEnemies1, world->numEnemies2};
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < counts[t]; i++) {
+            Enemy* enemy = &tables[t][i];
+            animateEnemy(enemy, g.deltaTime);
+            if (!enemy->active) continue;
+            SDL_Rect src = {enemy->currentFrame * enemy->frameWidth, 0, enemy->frameWidth, enemy->frameHeight};
+            SDL_Rect dst = {(int)enemy->x, (int)enemy->y, enemy->width, enemy->height};
+            pushSplitSprite(g, split, SPLIT_LAYER_ENEMIES, enemy->sprite, &src, &dst);
+        }
+    }
+
+    for (int p = 0; p < 2; p++) {
+        Shooter* shooter = &world->shooters[p];
+        if (shooter->dead) continue;
+        animateShooter(shooter, g.deltaTime);
+        SDL_Rect src = {shooter->currentFrame * shooter->frameWidth, 0, shooter->frameWidth, shooter->frameHeight};
+        SDL_Rect dst = {(int)shooter->x, (int)shooter->y, shooter->width, shooter->height};
+        pushSplitSprite(g, split, SPLIT_LAYER_SHOOTERS, shooter->sprite, &src, &dst);
+    }
+
+    animateBullets(g);
+    int bulletSlots = world->ammo + world->numAmmos * 3;
+    if (bulletSlots > SIM_MAX_BULLETS) bulletSlots = SIM_MAX_BULLETS;
+    SDL_Rect bulletSrc = {world->sim->bulletFrame * BULLET_FRAME_WIDTH, 0, BULLET_FRAME_WIDTH, 16};
+    for (int i = 0; (g.gl || g.bulletSpriteSheet) && i < bulletSlots; i++) {
+        const Bullet* bullet = &world->bullets[i];
+        if (!bullet->active) continue;
+        SDL_Rect dst = {(int)bullet->x, (int)bullet->y, BULLET_SIZE, BULLET_SIZE};
+        pushSplitItem(split, SPLIT_LAYER_BULLETS, g.bulletSpriteSheet, g.bulletPage, &bulletSrc, &dst,
+                      (SDL_Color){255, 255, 255, 255});
+    }
+
+    const FxPool* fx = g.fx;
+    for (int i = 0; fx && i < fx->count; i++) {
+        int s = fx->sheet[i];
+        if (g.gl ? g.fxPages[s] < 0 : g.fxSheets[s] == NULL) continue;
+        const FxSheetInfo* info = &fxSheetInfo[s];
+        int w = (int)(info->frameWidth * fx->scale[i]);
+        int h = (int)(info->frameHeight * fx->scale[i]);
+        SDL_Rect src = {fxFrame(fx, i) * info->frameWidth, 0, info->frameWidth, info->frameHeight};
+        SDL_Rect dst = {(int)fx->x[i] - w / 2, (int)fx->y[i] - h / 2, w, h};
+        pushSplitItem(split, SPLIT_LAYER_FX, g.fxSheets[s], g.fxPages[s], &src, &dst, (SDL_Color){255, 255, 255, 255});
+    }
+
+    SDL_Rect flag = {(int)(g.world.sim->worldWidth - streamOriginX(g.world.sim)), split->viewports[0].h - 600, 50, 600};
+    pushSplitFill(g, split, SPLIT_LAYER_FLAG, &flag, (SDL_Color){200, 200, 200, 200});
+
+    qsort(split->items, split->count, sizeof(SplitItem), compareSplitItems);
+}
+
+// Each player's stats at the top of their own half, through ImGui on both backends.
+// Not part of a frozen frame, so the paused screen draws it again over the copy.
+void drawSplitHud(GameData g) {
+    const SplitBatch* split = g.split;
+    const float fontSize = 24.0f;
+    const ImU32 yellow = 0xFF00FFFF;
+    const ImU32 red = 0xFF0000FF;
+    ImDrawList* drawList = igGetBackgroundDrawList(NULL);
+
+    for (int p = 0; p < 2; p++) {
+        const Shooter* shooter = &g.world.shooters[p];
+        float x = split->viewports[p].x + 10.0f;
+        char lines[3][30];
+        snprintf(lines[0], sizeof(lines[0]), "P%d Score: %d", p + 1, shooter->score);
+        snprintf(lines[1], sizeof(lines[1]), "P%d Ammo: %d", p + 1, shooter->ammo);
+        if (shooter->dead) {
+            snprintf(lines[2], sizeof(lines[2]), "P%d is out", p + 1);
+        } else {
+            snprintf(lines[2], sizeof(lines[2]), "P%d Time: %.2lf", p + 1, shooter->time);
+        }
+        for (int j = 0; j < 3; j++) {
+            ImDrawList_AddText_FontPtr(drawList, NULL, fontSize, (ImVec2){x, 40.0f + 30.0f * j}, yellow, lines[j], NULL, 0.0f, NULL);
+        }
+        for (int i = 0; i < shooter->health; i++) {
+            ImDrawList_AddRectFilled(drawList, (ImVec2){x + 60.0f * i, 130.0f}, (ImVec2){x + 60.0f * i + 50.0f, 180.0f}, red, 0.0f, 0);
+        }
+    }
+}
+
+static void renderSplit(GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height) {
+    SplitBatch* split = g.split;
+    int half = (screen_width - SPLIT_DIVIDER) / 2;
+    split->viewports[0] = (SDL_Rect){0, 0, half, screen_height};
+    split->viewports[1] = (SDL_Rect){screen_width - half, 0, half, screen_height};
+    for (int p = 0; p < 2; p++) split->cameraX[p] = g.world.sim->splitCameraX[p];
+    buildSplitBatch(g, split);
+
+    clearScreen(renderer, g.gl, screen_width, screen_height);
+    SDL_Rect divider = {half, 0, screen_width - 2 * half, screen_height};
+
+    if (g.gl) {
+        // Everything goes in once in world coordinates, static layers included,
+        // and is drawn through both views from the one sorted upload
+        glRendererBegin(g.gl, screen_width, screen_height);
+        float cameraX = g.world.sim->cameraX;
+        g.world.sim->cameraX = 0.0f;
+        const AtlasPage* background = g.backgroundPage >= 0 ? &g.gl->pages[g.backgroundPage] : NULL;
+        if (background) {
+            SDL_Rect whole = {0, 0, background->width, background->height};
+            glRendererSprite(g.gl, g.backgroundPage, NULL, &whole, (SDL_Color){255, 255, 255, 255});
+        }
+        // Hills over the stretch the two views span between them
+        float start = (float)(floorf(fminf(split->cameraX[0], split->cameraX[1]) / SQUARE_WIDTH) + streamOriginX(g.world.sim) / SQUARE_WIDTH);
+        int extent = (int)fmaxf(split->cameraX[0], split->cameraX[1]) + split->viewports[0].w;
+        renderTerrains(g, renderer, hn, start, (SDL_Color){34, 139, 34, 255}, 500, extent, screen_height);
+        renderTerrains(g, renderer, hn, start, (SDL_Color){144, 238, 54, 255}, 300, extent, screen_height);
+        drawPlatforms(g, renderer);
+        g.world.sim->cameraX = cameraX;
+
+        for (int i = 0; i < split->count; i++) {
+            const SplitItem* item = &split->items[i];
+            if (item->page == g.gl->whitePage) {
+                glRendererFill(g.gl, &item->dst, item->color);
+            } else {
+                glRendererSprite(g.gl, item->page, &item->src, &item->dst, item->color);
+            }
+        }
+        GLView views[2] = {{split->viewports[0], split->cameraX[0]}, {split->viewports[1], split->cameraX[1]}};
+        glRendererFlushViews(g.gl, views, 2);
+        int drawCalls = g.gl->drawCalls;
+        int sprites = g.gl->lastInstanceCount;
+
+        // Screen-space overlay in its own batch, over the world whatever its depth
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glRendererBegin(g.gl, screen_width, screen_height);
+        fillRect(renderer, g.gl, &divider, (SDL_Color){0, 0, 0, 255});
+        drawPauseButton(g, renderer);
+        glRendererFlush(g.gl);
+        g.gl->drawCalls += drawCalls;
+        g.gl->lastInstanceCount += sprites;
+    } else {
+        // The world cache is built at window size, wide enough for either half
+        WorldCache* cache = g.worldCache;
+        if (cache && cache->valid && (cache->width != screen_width || cache->height != screen_height)) {
+            invalidateWorldCache(cache);
+        }
+        bool cached = cache && (cache->valid || buildWorldCache(cache, g, renderer, hn, screen_width, screen_height));
+        for (int v = 0; cached && v < 2; v++) {
+            refreshWorldCache(cache, g, renderer, hn, split->cameraX[v], split->viewports[v].w);
+        }
+
+        for (int v = 0; v < 2; v++) {
+            const SDL_Rect* viewport = &split->viewports[v];
+            int offset = (int)split->cameraX[v];
+            SDL_RenderSetViewport(renderer, viewport);
+            SDL_RenderSetClipRect(renderer, &(SDL_Rect){0, 0, viewport->w, viewport->h});
+            if (cached) {
+                drawWorldCache(cache, renderer, streamOriginX(g.world.sim) + split->cameraX[v], viewport->w);
+            } else {
+                // g is a copy but sim is shared, put the live camera back afterwards
+                float cameraX = g.world.sim->cameraX;
+                g.world.sim->cameraX = split->cameraX[v];
+                renderStaticLayers(g, renderer, hn, viewport->w, viewport->h);
+                g.world.sim->cameraX = cameraX;
+            }
+            for (int i = 0; i < split->count; i++) {
+                const SplitItem* item = &split->items[i];
+                if (!(item->views & (1 << v))) continue;
+                SDL_Rect dst = item->dst;
+                dst.x -= offset;
+                if (item->texture) {
+                    SDL_RenderCopy(renderer, item->texture, &item->src, &dst);
+                } else {
+                    SDL_SetRenderDrawColor(renderer, item->color.r, item->color.g, item->color.b, item->color.a);
+                    SDL_RenderFillRect(renderer, &dst);
+                }
+            }
+        }
+        SDL_RenderSetClipRect(renderer, NULL);
+        SDL_RenderSetViewport(renderer, NULL);
+        fillRect(renderer, NULL, &divider, (SDL_Color){0, 0, 0, 255});
+        drawPauseButton(g, renderer);
+    }
+
+    drawSplitHud(g);
+    if (g.stats) {
+        g.stats->splitItems = split->count;
+        g.stats->splitShared = split->shared;
+    }
 }
 
 void render(GameData g,
@@ -318,33 +743,53 @@ void render(GameData g,
             HillNoise* hn,
             int screen_width,
             int screen_height) {
-    // Clear the screen
-    SDL_RenderClear(renderer);
+    if (g.world.sim->splitScreen && g.split) {
+        renderSplit(g, renderer, hn, screen_width, screen_height);
+        return;
+    }
 
-    // Render background
-    renderBackground(g, renderer, screen_width, screen_height);
+    // Background, hills and platforms, from the tile cache when the SDL_Renderer path can use one.
+    // Built before switching to the internal target, changing targets resets the render scale
+    WorldCache* cache = g.gl ? NULL : g.worldCache;
+    if (cache && cache->valid && (cache->width != screen_width || cache->height != screen_height)) {
+        invalidateWorldCache(cache);
+    }
+    bool cached = cache && (cache->valid || buildWorldCache(cache, g, renderer, hn, screen_width, screen_height));
+    if (cached) refreshWorldCache(cache, g, renderer, hn, g.world.sim->cameraX, screen_width);
 
-    // Render generated terrain
-    renderTerrains(g, renderer, hn, 0, (SDL_Color){34, 139, 34, 255}, 500, screen_height);
-    renderTerrains(g, renderer, hn, 0, (SDL_Color){144, 238, 54, 255}, 300, screen_height);
+    // World goes into the low resolution target on the SDL_Renderer path
+    bool scaled = !g.gl && g.scaler && beginScaledFrame(g.scaler, renderer, screen_width, screen_height);
+
+    // Clear the screen
+    clearScreen(renderer, g.gl, screen_width, screen_height);
+    if (g.gl) glRendererBegin(g.gl, screen_width, screen_height);
+
+    if (cached) {
+        drawWorldCache(cache, renderer, streamOriginX(g.world.sim) + g.world.sim->cameraX, screen_width);
+    } else {
+        renderStaticLayers(g, renderer, hn, screen_width, screen_height);
+    }
 
     // Draw pause button
     drawPauseButton(g, renderer);
 
     // Draw game entities
-    drawPlatforms(g, renderer);
     drawCollectibles(g, renderer);
     drawAmmo(g, renderer);
     drawEnemies1(g, renderer);
     drawEnemies2(g, renderer);
     drawShooter(g, renderer);
     drawBullets(g, renderer);
+    drawFx(g, renderer);
     drawFinishFlag(g, renderer, screen_height);
 
+    // Upscale the world before the HUD so text stays at window resolution
+    if (scaled) endScaledFrame(g.scaler, renderer);
+
     // Render UI elements
     renderText(g, renderer, font, screen_width);
     renderHearts(g, renderer);
 
-    // Present the rendered frame
-    SDL_RenderPresent(renderer);
+    // Submit the sprite batch, one instanced draw per atlas page
+    if (g.gl) glRendererFlush(g.gl);
 }
\ No newline at end of file
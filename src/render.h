@@ -10,8 +10,14 @@ void render(GameData g,
             HillNoise* hn,
             int screen_width,
             int screen_height);
+void renderStaticLayers(GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height);
+void clearScreen(SDL_Renderer* renderer, GLRenderer* gl, int screen_width, int screen_height);
 void freeHillNoise(HillNoise* hn);
-void initHillNoise(HillNoise* hn, float* sizes, int num_sizes);
+void readHudEvents(HudCache* hud, const SimContext* ctx);
+void freeHudCache(HudCache* hud);
+void freeSplitBatch(SplitBatch* split);
+void drawSplitHud(GameData g);
+void initHillNoise(HillNoise* hn, float* sizes, int num_sizes, uint32_t seed);
 
 
 #endif
@@ -0,0 +1,425 @@
+#include "replay.h"
+#include "stream.h"
+
+#define REPLAY_MAGIC 0x50524D41     // "AMRP"
+#define REPLAY_TAG_KEYFRAME 0xFF
+#define REPLAY_TAG_RUN 0x80         // | run length, 1..REPLAY_MAX_RUN
+#define REPLAY_TAG_EVENT 0x40       // annotation for the tick decoded just before it
+
+// Tick record flags, each adds a field after the tag byte
+#define REPLAY_HAS_DX 0x01
+#define REPLAY_HAS_DY 0x02
+#define REPLAY_HAS_FRAME 0x04
+#define REPLAY_HAS_BUTTONS 0x08
+#define REPLAY_HAS_SHOT 0x10
+
+static void putU32(FILE* f, Uint32 v) {
+    for (int i = 0; i < 4; i++) fputc((v >> (8 * i)) & 0xFF, f);
+}
+
+static Uint32 getU32(FILE* f) {
+    Uint32 v = 0;
+    for (int i = 0; i < 4; i++) v |= (Uint32)(fgetc(f) & 0xFF) << (8 * i);
+    return v;
+}
+
+// LEB128: seven bits per byte, high bit set while more follow
+static void putVarint(FILE* f, Uint32 v) {
+    while (v >= 0x80) {
+        fputc((v & 0x7F) | 0x80, f);
+        v >>= 7;
+    }
+    fputc(v, f);
+}
+
+static Uint32 getVarint(FILE* f) {
+    Uint32 v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) break;
+        v |= (Uint32)(c & 0x7F) << shift;
+        if (!(c & 0x80)) break;
+    }
+    return v;
+}
+
+// Zigzag keeps small negative numbers small: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+static void putSigned(FILE* f, Sint32 v) {
+    putVarint(f, ((Uint32)v << 1) ^ (Uint32)(v >> 31));
+}
+
+static Sint32 getSigned(FILE* f) {
+    Uint32 v = getVarint(f);
+    return (Sint32)(v >> 1) ^ -(Sint32)(v & 1);
+}
+
+// FNV-1a over the level file, so a ghost is only raced on the level it was recorded on
+Uint32 hashLevelFile(const char* levelFile) {
+    FILE* file = fopen(levelFile, "rb");
+    if (file == NULL) return 0;
+    Uint32 hash = 2166136261u;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        hash = (hash ^ (Uint8)c) * 16777619u;
+    }
+    fclose(file);
+    return hash;
+}
+
+static void writeHeader(FILE* f, const ReplayHeader* h) {
+    putU32(f, REPLAY_MAGIC);
+    putU32(f, h->version | ((Uint32)h->tickRate << 16));
+    putU32(f, h->levelHash);
+    putU32(f, h->seed);
+    putU32(f, h->ticks);
+    putU32(f, (Uint32)h->score);
+    putU32(f, h->timeMs);
+    putU32(f, h->player);
+}
+
+static bool readHeader(FILE* f, ReplayHeader* h) {
+    if (getU32(f) != REPLAY_MAGIC) return false;
+    Uint32 versionAndRate = getU32(f);
+    h->version = versionAndRate & 0xFFFF;
+    h->tickRate = versionAndRate >> 16;
+    h->levelHash = getU32(f);
+    h->seed = getU32(f);
+    h->ticks = getU32(f);
+    h->score = (Sint32)getU32(f);
+    h->timeMs = getU32(f);
+    h->player = getU32(f) & 0xFF;
+    return !feof(f) && h->version >= 1 && h->version <= REPLAY_VERSION;
+}
+
+bool replayBegin(ReplayWriter* w, const char* path, Uint32 levelHash, Uint32 seed, int player) {
+    memset(w, 0, sizeof(*w));
+    w->file = fopen(path, "wb");
+    if (w->file == NULL) {
+        printf("Failed to create replay %s\n", path);
+        return false;
+    }
+    w->header.version = REPLAY_VERSION;
+    w->header.tickRate = SIM_TICK_RATE;
+    w->header.levelHash = levelHash;
+    w->header.seed = seed;
+    w->header.player = (Uint8)player;
+    writeHeader(w->file, &w->header);
+    w->lastKeyframe = -1;
+    return true;
+}
+
+static void flushRun(ReplayWriter* w) {
+    if (w->pendingRun == 0) return;
+    fputc(REPLAY_TAG_RUN | w->pendingRun, w->file);
+    w->pendingRun = 0;
+}
+
+// Absolute state, linked from the previous keyframe so seeking can hop between them
+static void writeKeyframe(ReplayWriter* w, Sint32 x, Sint32 y, int frame, SimInput input) {
+    long offset = ftell(w->file);
+    if (w->lastKeyframe >= 0) {
+        fseek(w->file, w->lastKeyframe, SEEK_SET);
+        putU32(w->file, (Uint32)offset);
+        fseek(w->file, offset, SEEK_SET);
+    }
+    fputc(REPLAY_TAG_KEYFRAME, w->file);
+    w->lastKeyframe = ftell(w->file);
+    putU32(w->file, 0);
+    putVarint(w->file, w->tick);
+    putSigned(w->file, x);
+    putSigned(w->file, y);
+    putVarint(w->file, frame);
+    fputc(input.buttons, w->file);
+    if (input.buttons & INPUT_SHOOT) {
+        putSigned(w->file, input.aimX);
+        putSigned(w->file, input.aimY);
+    }
+}
+
+// Appends one tick. Only what the velocity prediction got wrong is written,
+// and ticks it got right are folded into a single run byte.
+void replayRecord(ReplayWriter* w, double x, float y, int currentFrame, SimInput input) {
+    if (w->file == NULL) return;
+    Sint32 qx = lrint(x * REPLAY_POS_SCALE);
+    Sint32 qy = lrintf(y * REPLAY_POS_SCALE);
+    Uint8 held = input.buttons & ~INPUT_SHOOT;
+    ReplayPredictor* s = &w->state;
+
+    if (w->tick % REPLAY_KEYFRAME_TICKS == 0) {
+        flushRun(w);
+        writeKeyframe(w, qx, qy, currentFrame, input);
+        *s = (ReplayPredictor){qx, qy, 0, 0, currentFrame, held};
+        w->tick++;
+        return;
+    }
+
+    Sint32 dx = qx - (s->x + s->velX);
+    Sint32 dy = qy - (s->y + s->velY);
+    Uint8 tag = (dx ? REPLAY_HAS_DX : 0) | (dy ? REPLAY_HAS_DY : 0) |
+                (currentFrame != s->frame ? REPLAY_HAS_FRAME : 0) |
+                (held != s->buttons ? REPLAY_HAS_BUTTONS : 0) |
+                ((input.buttons & INPUT_SHOOT) ? REPLAY_HAS_SHOT : 0);
+    if (tag == 0) {
+        if (++w->pendingRun == REPLAY_MAX_RUN) flushRun(w);
+    } else {
+        flushRun(w);
+        fputc(tag, w->file);
+        if (tag & REPLAY_HAS_DX) putSigned(w->file, dx);
+        if (tag & REPLAY_HAS_DY) putSigned(w->file, dy);
+        if (tag & REPLAY_HAS_FRAME) putVarint(w->file, currentFrame);
+        if (tag & REPLAY_HAS_BUTTONS) fputc(held, w->file);
+        if (tag & REPLAY_HAS_SHOT) {
+            putSigned(w->file, input.aimX);
+            putSigned(w->file, input.aimY);
+        }
+    }
+    s->velX = qx - s->x;
+    s->velY = qy - s->y;
+    s->x = qx;
+    s->y = qy;
+    s->frame = currentFrame;
+    s->buttons = held;
+    w->tick++;
+}
+
+void replayAttachEvents(ReplayWriter* w, const SimContext* ctx) {
+    attachEventCursor(ctx, &w->events);
+}
+
+// The run is flushed first so the reader meets the events right after the tick they follow.
+// Events from before the first tick wait for it.
+void replayAnnotate(ReplayWriter* w, const SimContext* ctx) {
+    if (w->file == NULL || w->tick == 0) return;
+    const SimEvent* event;
+    while ((event = nextSimEvent(ctx, &w->events)) != NULL) {
+        if (event->player != w->header.player) continue;
+        flushRun(w);
+        fputc(REPLAY_TAG_EVENT, w->file);
+        fputc(event->type, w->file);
+        fputc(event->kind, w->file);
+        putSigned(w->file, event->value);
+        putSigned(w->file, lrintf(event->x * REPLAY_POS_SCALE));
+        putSigned(w->file, lrintf(event->y * REPLAY_POS_SCALE));
+    }
+}
+
+void replayEnd(ReplayWriter* w, int score, double time) {
+    if (w->file == NULL) return;
+    flushRun(w);
+    w->header.ticks = w->tick;
+    w->header.score = score;
+    w->header.timeMs = (Uint32)(time * 1000.0);
+    fseek(w->file, 0, SEEK_SET);
+    writeHeader(w->file, &w->header);
+    fclose(w->file);
+    w->file = NULL;
+}
+
+bool replayOpen(ReplayReader* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) return false;
+    if (!readHeader(r->file, &r->header)) {
+        printf("Not a replay file: %s\n", path);
+        replayClose(r);
+        return false;
+    }
+    return true;
+}
+
+static void predict(ReplayPredictor* s) {
+    s->x += s->velX;
+    s->y += s->velY;
+}
+
+// Annotations written after the tick just decoded, read ahead until the next tick record
+static void readEvents(ReplayReader* r) {
+    ReplayFrame* f = &r->frame;
+    int tag;
+    while ((tag = fgetc(r->file)) == REPLAY_TAG_EVENT) {
+        SimEvent event = {0};
+        event.tick = f->tick;
+        event.type = (Uint8)fgetc(r->file);
+        event.kind = (Uint8)fgetc(r->file);
+        event.value = getSigned(r->file);
+        event.x = getSigned(r->file) / (float)REPLAY_POS_SCALE;
+        event.y = getSigned(r->file) / (float)REPLAY_POS_SCALE;
+        event.player = r->header.player;
+        if (f->numEvents < REPLAY_MAX_EVENTS) f->events[f->numEvents++] = event;
+    }
+    if (tag != EOF) ungetc(tag, r->file);
+}
+
+// Decodes the next tick into r->frame. Returns false at the end of the recording.
+bool replayNext(ReplayReader* r) {
+    if (r->file == NULL || r->finished) return false;
+    ReplayPredictor* s = &r->state;
+    ReplayFrame* f = &r->frame;
+    f->shot = false;
+    f->numEvents = 0;
+
+    if (r->runRemaining > 0) {
+        r->runRemaining--;
+        predict(s);
+    } else {
+        int tag = fgetc(r->file);
+        if (tag == EOF) {
+            r->finished = true;
+            return false;
+        }
+        if (tag == REPLAY_TAG_KEYFRAME) {
+            getU32(r->file);
+            r->tick = getVarint(r->file);
+            s->x = getSigned(r->file);
+            s->y = getSigned(r->file);
+            s->frame = getVarint(r->file);
+            Uint8 buttons = fgetc(r->file);
+            s->buttons = buttons & ~INPUT_SHOOT;
+            s->velX = s->velY = 0;
+            if (buttons & INPUT_SHOOT) {
+                f->shot = true;
+                f->aimX = (Sint16)getSigned(r->file);
+                f->aimY = (Sint16)getSigned(r->file);
+            }
+        } else if (tag & REPLAY_TAG_RUN) {
+            r->runRemaining = (tag & ~REPLAY_TAG_RUN) - 1;
+            predict(s);
+        } else {
+            Sint32 lastX = s->x, lastY = s->y;
+            predict(s);
+            if (tag & REPLAY_HAS_DX) s->x += getSigned(r->file);
+            if (tag & REPLAY_HAS_DY) s->y += getSigned(r->file);
+            s->velX = s->x - lastX;
+            s->velY = s->y - lastY;
+            if (tag & REPLAY_HAS_FRAME) s->frame = getVarint(r->file);
+            if (tag & REPLAY_HAS_BUTTONS) s->buttons = fgetc(r->file);
+            if (tag & REPLAY_HAS_SHOT) {
+                f->shot = true;
+                f->aimX = (Sint16)getSigned(r->file);
+                f->aimY = (Sint16)getSigned(r->file);
+            }
+        }
+    }
+
+    f->tick = r->tick++;
+    f->x = s->x / (double)REPLAY_POS_SCALE;
+    f->y = s->y / (float)REPLAY_POS_SCALE;
+    f->currentFrame = s->frame;
+    f->buttons = s->buttons | (f->shot ? INPUT_SHOOT : 0);
+    // Only the last tick of a run can be followed by events
+    if (r->runRemaining == 0) readEvents(r);
+    return true;
+}
+
+// Hops the keyframe chain to the last keyframe at or before tick, then decodes forward.
+// On success r->frame holds that tick.
+bool replaySeek(ReplayReader* r, Uint32 tick) {
+    if (r->file == NULL) return false;
+    long offset = REPLAY_HEADER_SIZE;
+    Uint32 keyframeTick = 0;
+    while (keyframeTick + REPLAY_KEYFRAME_TICKS <= tick) {
+        fseek(r->file, offset + 1, SEEK_SET);
+        Uint32 next = getU32(r->file);
+        if (next == 0) break;
+        offset = next;
+        keyframeTick += REPLAY_KEYFRAME_TICKS;
+    }
+    fseek(r->file, offset, SEEK_SET);
+    r->tick = keyframeTick;
+    r->runRemaining = 0;
+    r->finished = false;
+    while (replayNext(r)) {
+        if (r->frame.tick >= tick) return true;
+    }
+    return false;
+}
+
+void replayClose(ReplayReader* r) {
+    if (r->file) fclose(r->file);
+    r->file = NULL;
+}
+
+static void ensureReplaysDirectoryExists() {
+    #ifdef _WIN32
+        _mkdir("replays");
+    #else
+        mkdir("replays", 0777);
+    #endif
+}
+
+static void startRecording(GhostRace* race, GameData* g) {
+    const char* levelFile = g->levelFiles[g->selectedLevelIndex];
+    const char* name = strrchr(levelFile, '/');
+    name = name ? name + 1 : levelFile;
+    int nameLength = (int)strcspn(name, ".");
+
+    ensureReplaysDirectoryExists();
+    snprintf(race->path, sizeof(race->path), "replays/%.*s_%ld.amr", nameLength, name, (long)time(NULL));
+    race->recording = replayBegin(&race->writer, race->path, hashLevelFile(levelFile), g->world.seed, 0);
+    if (race->recording) replayAttachEvents(&race->writer, &g->world);
+    race->levelIndex = g->selectedLevelIndex;
+}
+
+// Called once per single-player frame after updateGame. Player 1's turn is sampled
+// at the fixed tick rate whatever the frame rate, player 2 sees it as a ghost lined
+// up by elapsed level time.
+void updateGhostRace(GhostRace* race, GameData* g, SimInput input) {
+    if (g->world.sim == NULL || g->world.sim->versus || g->levelFiles == NULL) return;
+    Shooter* shooter = &g->world.shooters[g->world.sim->isPlayer1Turn ? 0 : 1];
+    bool restarted = shooter->time < race->lastTime || g->selectedLevelIndex != race->levelIndex;
+    race->lastTime = shooter->time;
+
+    if (g->world.sim->isPlayer1Turn) {
+        if (race->racing) {
+            replayClose(&race->reader);
+            race->racing = false;
+            g->ghost.visible = false;
+        }
+        if (race->recording && restarted) {
+            replayEnd(&race->writer, shooter->score, shooter->time);
+            race->recording = false;
+        }
+        if (!race->recording) startRecording(race, g);
+        // Aim goes in from the shooter, the position in world x so a ghost lines up
+        // wherever a streamed level has its origin when it is played back
+        input.aimX = (Sint16)(input.aimX - (int)shooter->x);
+        input.aimY = (Sint16)(input.aimY - (int)shooter->y);
+        while (race->recording && race->writer.tick <= shooter->time * SIM_TICK_RATE) {
+            replayRecord(&race->writer, streamOriginX(g->world.sim) + shooter->x, shooter->y, shooter->currentFrame, input);
+            input.buttons &= ~INPUT_SHOOT;
+        }
+        replayAnnotate(&race->writer, &g->world);
+        return;
+    }
+
+    if (race->recording) {
+        replayEnd(&race->writer, g->world.shooters[0].score, g->world.shooters[0].time);
+        race->recording = false;
+        race->racing = replayOpen(&race->reader, race->path);
+        restarted = true;
+    }
+    if (!race->racing) return;
+
+    Uint32 target = (Uint32)(shooter->time * SIM_TICK_RATE);
+    if (restarted) {
+        replaySeek(&race->reader, target);
+    } else {
+        while (race->reader.tick <= target && replayNext(&race->reader)) {}
+    }
+    g->ghost.visible = !race->reader.finished;
+    g->ghost.x = (float)(race->reader.frame.x - streamOriginX(g->world.sim));
+    g->ghost.y = race->reader.frame.y;
+    g->ghost.currentFrame = race->reader.frame.currentFrame;
+}
+
+void stopGhostRace(GhostRace* race, GameData* g) {
+    if (race->recording) {
+        replayEnd(&race->writer, g->world.shooters[0].score, g->world.shooters[0].time);
+        race->recording = false;
+    }
+    if (race->racing) {
+        replayClose(&race->reader);
+        race->racing = false;
+    }
+    g->ghost.visible = false;
+}
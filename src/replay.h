@@ -0,0 +1,100 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include "init.h"
+
+#define REPLAY_VERSION 2            // 2 adds the event annotation track, 1 still reads
+#define REPLAY_POS_SCALE 4          // positions are stored in quarter pixels
+#define REPLAY_KEYFRAME_TICKS 300   // absolute state every 5 s for seeking
+#define REPLAY_MAX_RUN 126          // predicted ticks folded into one byte, 127 would be the keyframe tag
+#define REPLAY_HEADER_SIZE 32
+#define REPLAY_MAX_EVENTS 8         // annotations kept per decoded tick, the rest are skipped
+
+// Fixed-size header, score and time are patched in when the run ends so
+// leaderboards can rank a file without decoding it
+typedef struct {
+    Uint16 version;
+    Uint16 tickRate;
+    Uint32 levelHash;
+    Uint32 seed;
+    Uint32 ticks;
+    Sint32 score;
+    Uint32 timeMs;
+    Uint8 player;
+} ReplayHeader;
+
+// One decoded tick of a recorded shooter
+typedef struct {
+    Uint32 tick;
+    double x;               // world x, a streamed level's origin added (see streamOriginX)
+    float y;
+    int currentFrame;
+    Uint8 buttons;          // INPUT_* bits
+    bool shot;
+    Sint16 aimX, aimY;      // from x, y, valid when shot
+    SimEvent events[REPLAY_MAX_EVENTS];     // recorded player's gameplay events up to this tick
+    int numEvents;
+} ReplayFrame;
+
+// Position prediction shared by writer and reader: each tick is coded as the
+// difference from continuing the last tick's velocity
+typedef struct {
+    Sint32 x, y;
+    Sint32 velX, velY;
+    int frame;
+    Uint8 buttons;
+} ReplayPredictor;
+
+// Streams records straight to disk; memory use does not grow with run length
+typedef struct {
+    FILE* file;
+    ReplayHeader header;
+    ReplayPredictor state;
+    Uint32 tick;
+    int pendingRun;         // predicted ticks not yet written
+    long lastKeyframe;      // offset of the previous keyframe's next pointer
+    SimEventCursor events;  // annotation track, see replayAnnotate
+} ReplayWriter;
+
+// Decodes one tick at a time, keyframes form a linked list for seeking
+typedef struct {
+    FILE* file;
+    ReplayHeader header;
+    ReplayPredictor state;
+    Uint32 tick;            // ticks decoded so far
+    int runRemaining;
+    bool finished;
+    ReplayFrame frame;
+} ReplayReader;
+
+// Records player 1's turn and plays it back as a ghost during player 2's
+typedef struct {
+    ReplayWriter writer;
+    ReplayReader reader;
+    bool recording;
+    bool racing;
+    int levelIndex;
+    double lastTime;
+    char path[256];
+} GhostRace;
+
+Uint32 hashLevelFile(const char* levelFile);
+bool replayBegin(ReplayWriter* w, const char* path, Uint32 levelHash, Uint32 seed, int player);
+// x is the world x, as in ReplayFrame, and input's aim is taken from the shooter at x, y
+void replayRecord(ReplayWriter* w, double x, float y, int currentFrame, SimInput input);
+// Starts the annotation track at the next event ctx publishes
+void replayAttachEvents(ReplayWriter* w, const SimContext* ctx);
+// Appends the recorded player's events published since the last call, after the
+// last recorded tick
+void replayAnnotate(ReplayWriter* w, const SimContext* ctx);
+void replayEnd(ReplayWriter* w, int score, double time);
+bool replayOpen(ReplayReader* r, const char* path);
+bool replayNext(ReplayReader* r);
+bool replaySeek(ReplayReader* r, Uint32 tick);
+void replayClose(ReplayReader* r);
+
+void updateGhostRace(GhostRace* race, GameData* g, SimInput input);
+void stopGhostRace(GhostRace* race, GameData* g);
+
+#endif
@@ -0,0 +1,114 @@
+#include "scaler.h"
+
+// Frames over/under budget before the governor changes resolution
+#define GOVERNOR_DOWN_FRAMES 30
+#define GOVERNOR_UP_FRAMES 180
+// Lowest internal height the governor will go to
+#define GOVERNOR_MIN_HEIGHT 180
+
+// internalHeight <= 0 renders at native resolution
+void configureScaler(RenderScaler* s, int internalHeight, bool dynamic) {
+    memset(s, 0, sizeof(*s));
+    s->baseHeight = internalHeight;
+    s->scale = 1;
+    s->minScale = 1;
+    s->maxScale = 1;
+    s->dynamic = dynamic;
+    s->budgetMs = FRAME_BUDGET_MS;
+}
+
+// Largest integer factor that keeps the internal height at or above the given height
+static int scaleForHeight(int windowHeight, int height) {
+    if (height <= 0) return 1;
+    int scale = windowHeight / height;
+    return scale < 1 ? 1 : scale;
+}
+
+static void applyScale(RenderScaler* s) {
+    s->width = s->windowWidth / s->scale;
+    s->height = s->windowHeight / s->scale;
+    if (s->target) {
+        SDL_DestroyTexture(s->target);
+        s->target = NULL;
+    }
+}
+
+// Redirects rendering into the internal target; the caller keeps drawing in window
+// coordinates and SDL's render scale maps them down. Returns false to draw directly.
+bool beginScaledFrame(RenderScaler* s, SDL_Renderer* renderer, int screen_width, int screen_height) {
+    if (s->windowWidth != screen_width || s->windowHeight != screen_height) {
+        s->windowWidth = screen_width;
+        s->windowHeight = screen_height;
+        s->scale = scaleForHeight(screen_height, s->baseHeight);
+        if (s->dynamic) {
+            s->minScale = 1;
+            s->maxScale = scaleForHeight(screen_height, GOVERNOR_MIN_HEIGHT);
+            if (s->maxScale < s->scale) s->maxScale = s->scale;
+        } else {
+            s->minScale = s->maxScale = s->scale;
+        }
+        applyScale(s);
+    }
+    if (s->scale == 1) return false;
+
+    if (s->target == NULL) {
+        if (!SDL_RenderTargetSupported(renderer)) return false;
+        s->target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, s->width, s->height);
+        if (s->target == NULL) {
+            printf("Failed to create internal render target: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(s->target, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(s->target, SDL_ScaleModeNearest);
+    }
+
+    s->previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, s->target);
+    SDL_RenderSetScale(renderer, 1.0f / s->scale, 1.0f / s->scale);
+    return true;
+}
+
+// Integer-upscales the internal target into the centre of the previous target
+void endScaledFrame(RenderScaler* s, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, s->previousTarget);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int w = s->width * s->scale;
+    int h = s->height * s->scale;
+    SDL_Rect dstRect = {(s->windowWidth - w) / 2, (s->windowHeight - h) / 2, w, h};
+    SDL_RenderCopy(renderer, s->target, NULL, &dstRect);
+}
+
+// Drops resolution quickly when over budget, raises it slowly when there is headroom
+void updateResolutionGovernor(RenderScaler* s, float workMs) {
+    if (!s->dynamic) return;
+
+    s->workAvgMs = s->workAvgMs == 0.0f ? workMs : s->workAvgMs * 0.9f + workMs * 0.1f;
+
+    if (s->workAvgMs > s->budgetMs * 0.9f) {
+        s->overBudgetFrames++;
+        s->underBudgetFrames = 0;
+    } else if (s->workAvgMs < s->budgetMs * 0.5f) {
+        s->underBudgetFrames++;
+        s->overBudgetFrames = 0;
+    } else {
+        s->overBudgetFrames = 0;
+        s->underBudgetFrames = 0;
+    }
+
+    if (s->overBudgetFrames >= GOVERNOR_DOWN_FRAMES && s->scale < s->maxScale) {
+        s->scale++;
+        applyScale(s);
+        s->overBudgetFrames = 0;
+    } else if (s->underBudgetFrames >= GOVERNOR_UP_FRAMES && s->scale > s->minScale) {
+        s->scale--;
+        applyScale(s);
+        s->underBudgetFrames = 0;
+    }
+}
+
+void destroyScaler(RenderScaler* s) {
+    if (s->target) SDL_DestroyTexture(s->target);
+    s->target = NULL;
+}
@@ -0,0 +1,12 @@
+#ifndef SCALER_H
+#define SCALER_H
+
+#include "init.h"
+
+void configureScaler(RenderScaler* s, int internalHeight, bool dynamic);
+bool beginScaledFrame(RenderScaler* s, SDL_Renderer* renderer, int screen_width, int screen_height);
+void endScaledFrame(RenderScaler* s, SDL_Renderer* renderer);
+void updateResolutionGovernor(RenderScaler* s, float workMs);
+void destroyScaler(RenderScaler* s);
+
+#endif
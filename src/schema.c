@@ -0,0 +1,176 @@
+#include "schema.h"
+#include <string.h>
+
+// The animation timings have always been read as whole numbers, and the level
+// files are tuned for that: frameDelay 0.9 runs as 0, a new frame every frame.
+// FIELD_WHOLE keeps them that way rather than slowing every sheet to a crawl.
+
+static const FieldSpec shooterFields[] = {
+    {"x",               FIELD_FLOAT,  offsetof(Shooter, x),                    0.0, true},
+    {"y",               FIELD_FLOAT,  offsetof(Shooter, y),                    0.0, true},
+    {"width",           FIELD_INT,    offsetof(Shooter, width),                0.0, true},
+    {"height",          FIELD_INT,    offsetof(Shooter, height),               0.0, true},
+    {"health",          FIELD_INT,    offsetof(Shooter, health),               3.0, false},
+    {"ammo",            FIELD_INT,    offsetof(Shooter, ammo),                 3.0, false},
+    {"score",           FIELD_INT,    offsetof(Shooter, score),                0.0, false},
+    {"onGround",        FIELD_BOOL,   offsetof(Shooter, onGround),             0.0, false},
+    {"velocityY",       FIELD_FLOAT,  offsetof(Shooter, velocityY),            0.0, false},
+    {"textureLocation", FIELD_SPRITE, offsetof(Shooter, sprite),              -1.0, true},
+    {"currentFrame",    FIELD_INT,    offsetof(Shooter, currentFrame),         0.0, false},
+    {"spriteWidth",     FIELD_INT,    offsetof(Shooter, frameWidth),           0.0, true},
+    {"spriteHeight",    FIELD_INT,    offsetof(Shooter, frameHeight),          0.0, true},
+    {"totalFrames",     FIELD_INT,    offsetof(Shooter, totalFrames),          1.0, false},
+    {"animationTimer",  FIELD_WHOLE,  offsetof(Shooter, animationTimer),       0.0, false},
+    {"frameDelay",      FIELD_WHOLE,  offsetof(Shooter, frameDelay),           0.0, false},
+    {"time",            FIELD_DOUBLE, offsetof(Shooter, time),                 0.0, false},
+    {"dead",            FIELD_BOOL,   offsetof(Shooter, dead),                 0.0, false},
+};
+
+static const FieldSpec enemyFields[] = {
+    {"x",               FIELD_FLOAT,  offsetof(Enemy, x),                      0.0, true},
+    {"y",               FIELD_FLOAT,  offsetof(Enemy, y),                      0.0, true},
+    {"width",           FIELD_INT,    offsetof(Enemy, width),                  0.0, true},
+    {"height",          FIELD_INT,    offsetof(Enemy, height),                 0.0, true},
+    {"active",          FIELD_BOOL,   offsetof(Enemy, active),                 0.0, false},
+    {"currentFrame",    FIELD_INT,    offsetof(Enemy, currentFrame),           0.0, false},
+    {"speed",           FIELD_FLOAT,  offsetof(Enemy, speed),                  0.0, false},
+    {"platformIndex",   FIELD_INT,    offsetof(Enemy, platformIndex),         -1.0, false},
+    {"textureLocation", FIELD_SPRITE, offsetof(Enemy, sprite),                -1.0, true},
+    {"spriteWidth",     FIELD_INT,    offsetof(Enemy, frameWidth),             0.0, true},
+    {"spriteHeight",    FIELD_INT,    offsetof(Enemy, frameHeight),            0.0, true},
+    {"totalFrames",     FIELD_INT,    offsetof(Enemy, totalFrames),            1.0, false},
+    {"animationTimer",  FIELD_WHOLE,  offsetof(Enemy, animationTimer),         0.0, false},
+    {"frameDelay",      FIELD_WHOLE,  offsetof(Enemy, frameDelay),             0.0, false},
+};
+
+static const FieldSpec platformFields[] = {
+    {"x",               FIELD_FLOAT,  offsetof(Platform, x),                   0.0, true},
+    {"y",               FIELD_FLOAT,  offsetof(Platform, y),                   0.0, true},
+    {"width",           FIELD_FLOAT,  offsetof(Platform, width),               0.0, true},
+    {"height",          FIELD_FLOAT,  offsetof(Platform, height),              0.0, true},
+};
+
+static const FieldSpec collectibleFields[] = {
+    {"x",               FIELD_FLOAT,  offsetof(Collectible, x),                0.0, true},
+    {"y",               FIELD_FLOAT,  offsetof(Collectible, y),                0.0, true},
+    {"width",           FIELD_INT,    offsetof(Collectible, width),            0.0, true},
+    {"height",          FIELD_INT,    offsetof(Collectible, height),           0.0, true},
+    {"collected",       FIELD_BOOL,   offsetof(Collectible, collected),        0.0, false},
+};
+
+#define FIELD_COUNT(fields) ((int)(sizeof(fields) / sizeof(fields[0])))
+
+const EntitySchema shooterSchema = {"shooter", shooterFields, FIELD_COUNT(shooterFields)};
+const EntitySchema enemySchema = {"enemy", enemyFields, FIELD_COUNT(enemyFields)};
+const EntitySchema platformSchema = {"platform", platformFields, FIELD_COUNT(platformFields)};
+const EntitySchema collectibleSchema = {"collectible", collectibleFields, FIELD_COUNT(collectibleFields)};
+
+static const char* typeNames[] = {"a number", "a number", "a number", "true or false", "a path", "a number"};
+
+// Files list the members in table order when they were saved by writeEntity and
+// mostly when written by hand, so the search starts after the last match and
+// usually hits on the first compare
+static int findField(const EntitySchema* schema, const char* name, int start) {
+    for (int n = 0; n < schema->numFields; n++) {
+        int f = (start + n) % schema->numFields;
+        if (strcmp(schema->fields[f].name, name) == 0) return f;
+    }
+    return -1;
+}
+
+static void storeNumber(const FieldSpec* field, char* entity, double value) {
+    void* dst = entity + field->offset;
+    switch (field->type) {
+        case FIELD_FLOAT:  *(float*)dst = (float)value; break;
+        case FIELD_DOUBLE: *(double*)dst = value; break;
+        case FIELD_INT:
+        case FIELD_SPRITE: *(int*)dst = (int)value; break;
+        case FIELD_BOOL:   *(bool*)dst = value != 0.0; break;
+        case FIELD_WHOLE:  *(float*)dst = (float)(int)value; break;
+    }
+}
+
+static bool readField(const FieldSpec* field, const cJSON* value, char* entity,
+                      SchemaSpriteIndex resolveSprite, void* userData) {
+    switch (field->type) {
+        case FIELD_BOOL:
+            if (!cJSON_IsBool(value)) return false;
+            *(bool*)(entity + field->offset) = cJSON_IsTrue(value);
+            return true;
+        case FIELD_SPRITE:
+            if (!cJSON_IsString(value)) return false;
+            *(int*)(entity + field->offset) = resolveSprite ? resolveSprite(userData, value->valuestring) : -1;
+            return true;
+        default:
+            if (!cJSON_IsNumber(value)) return false;
+            storeNumber(field, entity, value->valuedouble);
+            return true;
+    }
+}
+
+bool readEntity(const EntitySchema* schema, const cJSON* object, void* entity, bool patch,
+                SchemaSpriteIndex resolveSprite, void* userData, const char* where) {
+    if (!cJSON_IsObject(object)) {
+        fprintf(stderr, "%s: expected a %s object\n", where, schema->entity);
+        return false;
+    }
+    bool ok = true;
+    uint32_t seen = 0;
+    int next = 0;
+    for (const cJSON* member = object->child; member != NULL; member = member->next) {
+        int f = findField(schema, member->string, next);
+        if (f < 0) {
+            fprintf(stderr, "%s: unknown %s field \"%s\", ignored\n", where, schema->entity, member->string);
+            continue;
+        }
+        const FieldSpec* field = &schema->fields[f];
+        if (!readField(field, member, (char*)entity, resolveSprite, userData)) {
+            fprintf(stderr, "%s: %s field \"%s\" should be %s\n", where, schema->entity, field->name, typeNames[field->type]);
+            ok = false;
+        }
+        seen |= 1u << f;
+        next = f + 1;
+    }
+    if (patch) return ok;
+
+    for (int f = 0; f < schema->numFields; f++) {
+        const FieldSpec* field = &schema->fields[f];
+        if (seen & (1u << f)) continue;
+        if (field->required) {
+            fprintf(stderr, "%s: %s is missing \"%s\"\n", where, schema->entity, field->name);
+            ok = false;
+        } else {
+            storeNumber(field, (char*)entity, field->fallback);
+        }
+    }
+    return ok;
+}
+
+void writeEntity(const EntitySchema* schema, const void* entity, cJSON* object,
+                 SchemaSpritePath spritePath, void* userData) {
+    const char* base = (const char*)entity;
+    for (int f = 0; f < schema->numFields; f++) {
+        const FieldSpec* field = &schema->fields[f];
+        const void* src = base + field->offset;
+        switch (field->type) {
+            case FIELD_FLOAT:
+            case FIELD_WHOLE:
+                cJSON_AddNumberToObject(object, field->name, *(const float*)src);
+                break;
+            case FIELD_DOUBLE:
+                cJSON_AddNumberToObject(object, field->name, *(const double*)src);
+                break;
+            case FIELD_INT:
+                cJSON_AddNumberToObject(object, field->name, *(const int*)src);
+                break;
+            case FIELD_BOOL:
+                cJSON_AddBoolToObject(object, field->name, *(const bool*)src);
+                break;
+            case FIELD_SPRITE: {
+                const char* path = spritePath ? spritePath(userData, *(const int*)src) : NULL;
+                cJSON_AddStringToObject(object, field->name, path ? path : "");
+                break;
+            }
+        }
+    }
+}
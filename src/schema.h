@@ -0,0 +1,57 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+#include "sim.h"
+
+// How a member of a level or save file is stored in the struct
+typedef enum {
+    FIELD_FLOAT,
+    FIELD_DOUBLE,
+    FIELD_INT,
+    FIELD_BOOL,
+    FIELD_SPRITE,           // a path in the file, a sprite index in the struct
+    FIELD_WHOLE             // a number cut to a whole value, into a float (the animation timings, see schema.c)
+} FieldType;
+
+typedef struct {
+    const char* name;       // member name in the file
+    FieldType type;
+    size_t offset;          // in the struct
+    double fallback;        // taken when an optional field is missing, -1 for a sprite means none
+    bool required;
+} FieldSpec;
+
+// One table per entity type drives both loading and saving, so a new field is
+// one more entry. At most 32 fields, the reader keeps a bit per field.
+typedef struct {
+    const char* entity;     // for messages
+    const FieldSpec* fields;
+    int numFields;
+} EntitySchema;
+
+extern const EntitySchema shooterSchema;
+extern const EntitySchema enemySchema;
+extern const EntitySchema platformSchema;
+extern const EntitySchema collectibleSchema;
+
+// Sprite paths in files to whatever index the caller uses, and back
+typedef int (*SchemaSpriteIndex)(void* userData, const char* path);
+typedef const char* (*SchemaSpritePath)(void* userData, int sprite);
+
+// Fills entity from object in a single pass over its members. Missing optional
+// fields take their fallback, or with patch keep what entity already holds (for
+// entries stamped from a template, where nothing is required). Missing required
+// and mistyped fields are reported against where, the file and entry, and fail
+// the read; unknown members are reported and skipped.
+bool readEntity(const EntitySchema* schema, const cJSON* object, void* entity, bool patch,
+                SchemaSpriteIndex resolveSprite, void* userData, const char* where);
+// Adds every field of entity to object, in table order
+void writeEntity(const EntitySchema* schema, const void* entity, cJSON* object,
+                 SchemaSpritePath spritePath, void* userData);
+
+#endif
@@ -5,6 +5,7 @@
 #include "render.h"
 
 void shootBullet(GameData* g, float targetX, float targetY);
-void updateGame(GameData* g, HillNoise* hn, int screen_width, int screen_height, bool leftPressed, bool rightPressed, bool spacePressed);
+void updateGame(GameData* g, int screen_width, int screen_height, bool leftPressed, bool rightPressed, bool spacePressed);
+void updateVersus(GameData* g, const SimInput inputs[2], int screen_width, int screen_height);
 
 #endif
@@ -0,0 +1,819 @@
+#include "sim.h"
+#include "simstate.h"
+#include "flowfield.h"
+#include "navgraph.h"
+#include "eventbus.h"
+#include "stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// xorshift32: small, fast and identical on every platform, unlike rand()
+uint32_t simRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Uniform in [0, 1)
+float simRandomFloat(uint32_t* state) {
+    return (simRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Where the level starts and the finish line is, in the state's coordinates
+static float worldStartX(const SimContext* ctx) {
+    return (float)(0.0 - streamOriginX(ctx->sim));
+}
+
+static float worldEndX(const SimContext* ctx) {
+    return (float)(ctx->sim->worldWidth - streamOriginX(ctx->sim));
+}
+
+// Fires a bullet from shooter towards a point in the state's coordinates
+void shootBulletFrom(SimContext* ctx, Shooter* shooter, float targetX, float targetY) {
+    // No shoot if no ammo
+    if (shooter->ammo <= 0) return;
+
+    // Calculate direction from actual shooter position
+    float shooterCenterX = shooter->x + 50; 
+    float shooterCenterY = shooter->y + 50;
+    
+    // Account for camera position in both target and shooter positions
+    float deltaX = (targetX) - (shooterCenterX);
+    float deltaY = targetY - shooterCenterY;
+    float length = sqrtf(deltaX * deltaX + deltaY * deltaY);
+    
+    // Normalize direction
+    float dirX = (length != 0) ? deltaX / length : 1;
+    float dirY = (length != 0) ? deltaY / length : 0;
+
+    for (int i = 0; i < shooter->ammo; i++) { 
+        if (!ctx->bullets[i].active) {
+            // Initialize bullet at shooter's actual position
+            ctx->bullets[i].x = shooterCenterX;  
+            ctx->bullets[i].y = shooterCenterY;
+            ctx->bullets[i].dirX = dirX;
+            ctx->bullets[i].dirY = dirY;
+            ctx->bullets[i].speed = 500.0f;
+            ctx->bullets[i].active = true;
+            ctx->bullets[i].lifespan = 1000.0f;
+            ctx->bullets[i].owner = (int)(shooter - ctx->shooters);
+            shooter->ammo--;
+            publishSimEvent(ctx, SIM_EVENT_SHOT, ctx->bullets[i].owner, 0, shooter->ammo, shooterCenterX, shooterCenterY);
+            break;
+        }
+    }
+}
+
+
+static bool collideFromLeft(float previousX, Platform platform, Shooter* shooter) {
+    return previousX + 100 <= platform.x && shooter->x + 100 >= platform.x;
+}
+
+static bool collideFromRight(float previousX, Platform platform, Shooter* shooter) {
+    return previousX >= platform.x + platform.width && shooter->x <= platform.x + platform.width;
+}
+
+static bool collideFromAbove(float previousY, Platform platform, Shooter* shooter) {
+    return previousY + 100 >= platform.y && shooter->y + 100 <= platform.y + platform.height;
+}
+
+static bool collideFromBelow(float previousY, Platform platform, Shooter* shooter) {
+    return previousY <= platform.y + platform.height && shooter->y >= platform.y - platform.height;
+}
+
+static bool checkCollectibleCollision(Shooter* shooter, Collectible* collectible) {
+    bool horizontalOverlap = shooter->x + 100 >= collectible->x && 
+                            shooter->x <= collectible->x + collectible->width;
+    bool verticalOverlap = shooter->y + 100 >= collectible->y && 
+                          shooter->y <= collectible->y + collectible->height;
+    return horizontalOverlap && verticalOverlap;
+}
+
+static bool checkEnemyCollision(Shooter* shooter, Enemy* enemy) {
+    if (!enemy->active) return false;
+    bool horizontalOverlap = shooter->x + 50 >= enemy->x && 
+                            shooter->x <= enemy->x + enemy->width;
+    bool verticalOverlap = shooter->y + 100 >= enemy->y && 
+                          shooter->y <= enemy->y + enemy->height;
+    return horizontalOverlap && verticalOverlap;
+}
+
+static bool checkBulletEnemyCollision(float bulletX, float bulletY, Enemy* enemy) {
+    bool horizontalOverlap = bulletX + 10 >= enemy->x && 
+                            bulletX <= enemy->x + enemy->width;
+    bool verticalOverlap = bulletY + 10 >= enemy->y && 
+                          bulletY <= enemy->y + enemy->height;
+    return horizontalOverlap && verticalOverlap;
+}
+
+static void updateShooterPosition(SimContext* ctx, Shooter* shooter, bool leftPressed, bool rightPressed, bool spacePressed) {
+    float previousX = shooter->x;
+    float previousY = shooter->y;
+    
+    // Store intended movement
+    float intendedX = shooter->x;
+    if (leftPressed) intendedX -= SHOOTER_SPEED * ctx->deltaTime;
+    if (rightPressed) intendedX += SHOOTER_SPEED * ctx->deltaTime;
+
+    // Apply horizontal movement first
+    shooter->x = intendedX;
+
+    // Check horizontal collisions
+    for (int i = 0; i < ctx->numPlatforms; i++) {
+        Platform platform = ctx->platforms[i];
+        
+        if (shooter->y + 100 >= platform.y && shooter->y <= platform.y + platform.height) {
+            if (collideFromLeft(previousX, platform, shooter)) {
+                shooter->x = platform.x - 100;
+            } else if (collideFromRight(previousX, platform, shooter)) {
+                shooter->x = platform.x + platform.width;
+            }
+        }
+    }
+
+    // Handle jumping and vertical movement
+    if (spacePressed && shooter->onGround) {
+        shooter->velocityY = -JUMP_SPEED;
+        shooter->onGround = false;
+    }
+
+    if (!shooter->onGround) {
+        shooter->velocityY += GRAVITY * ctx->deltaTime;
+    }
+
+    // Apply vertical movement
+    shooter->y += shooter->velocityY * ctx->deltaTime;
+    bool collisionDetected = false;
+
+    // Check vertical collisions
+    for (int i = 0; i < ctx->numPlatforms; i++) {
+        Platform platform = ctx->platforms[i];
+
+        if (shooter->x + 50 >= platform.x && shooter->x <= platform.x + platform.width) {
+            if (collideFromAbove(previousY, platform, shooter) && shooter->velocityY > 0) {
+                shooter->y = platform.y - 100;
+                shooter->velocityY = 0;
+                shooter->onGround = true;
+                collisionDetected = true;
+            } else if (collideFromBelow(previousY, platform, shooter) && shooter->velocityY < 0) {
+                shooter->y = platform.y + platform.height;
+                shooter->velocityY = 0;
+                collisionDetected = true;
+            }
+        }
+    }
+
+    // Ground collision
+    if (!collisionDetected && shooter->y >= GROUND_LEVEL) {
+        shooter->y = GROUND_LEVEL;
+        shooter->velocityY = 0;
+        shooter->onGround = true;
+    } else if (!collisionDetected && shooter->y < GROUND_LEVEL) {
+        shooter->onGround = false;
+    }
+    if (shooter->x < worldStartX(ctx) + LEFT_BOUNDARY) {
+        shooter->x = worldStartX(ctx) + LEFT_BOUNDARY;
+    }
+}
+
+static void updateCollectibles(SimContext* ctx, Shooter* shooter) {
+    for (int i = 0; i < ctx->numCollectibles; i++) {
+        if (!ctx->collectibles[i].collected && checkCollectibleCollision(shooter, &ctx->collectibles[i])) {
+            ctx->collectibles[i].collected = true;
+            shooter->score += 5;
+            int player = (int)(shooter - ctx->shooters);
+            float x = ctx->collectibles[i].x + ctx->collectibles[i].width / 2.0f;
+            float y = ctx->collectibles[i].y + ctx->collectibles[i].height / 2.0f;
+            publishSimEvent(ctx, SIM_EVENT_PICKUP, player, 0, 0, x, y);
+            publishSimEvent(ctx, SIM_EVENT_SCORE, player, 0, 5, x, y);
+        }
+    }
+}
+
+static void updateAmmos(SimContext* ctx, Shooter* shooter) {
+    for (int i = 0; i < ctx->numAmmos; i++) {
+        if (!ctx->ammos[i].collected && checkCollectibleCollision(shooter, &ctx->ammos[i])) {
+            ctx->ammos[i].collected = true;
+            shooter->ammo += 3;
+            publishSimEvent(ctx, SIM_EVENT_PICKUP, (int)(shooter - ctx->shooters), 1, shooter->ammo,
+                            ctx->ammos[i].x + ctx->ammos[i].width / 2.0f, ctx->ammos[i].y + ctx->ammos[i].height / 2.0f);
+        }
+    }
+}
+
+// Enemies chase the current player, or the closest live one in versus mode
+static Shooter* enemyTarget(SimContext* ctx, float x) {
+    if (!ctx->sim->versus) return &ctx->shooters[ctx->sim->isPlayer1Turn? 0:1];
+    Shooter* a = &ctx->shooters[0];
+    Shooter* b = &ctx->shooters[1];
+    if (a->dead) return b;
+    if (b->dead) return a;
+    return fabsf(a->x - x) <= fabsf(b->x - x) ? a : b;
+}
+
+// Platform enemies only leave their span for a shooter this close
+#define ENEMY_CHASE_RANGE 400.0f
+
+// Finds the span a platform enemy starts on, false when it is not over one
+static bool resolveNavNode(SimContext* ctx, Enemy* enemy) {
+    if (enemy->navResolved) return true;
+    const NavGraph* nav = ctx->nav;
+    int node = -1;
+    if (enemy->platformIndex >= 0 && enemy->platformIndex < ctx->numPlatforms) {
+        node = navNodeForPlatform(nav, enemy->platformIndex);
+    }
+    if (node < 0) node = navNodeAt(nav, enemy->x + enemy->width / 2.0f, enemy->y + enemy->height);
+    if (node < 0) return false;
+    enemy->navNode = node;
+    enemy->navResolved = true;
+    enemy->jumping = false;
+    return true;
+}
+
+// Platform enemies walk their span towards the shooter and, when it stands on
+// another span close by, head for the graph's next jump and follow its arc across
+static void moveOnNavGraph(SimContext* ctx, Enemy* enemy, const Shooter* shooter) {
+    NavGraph* nav = ctx->nav;
+    float halfWidth = enemy->width / 2.0f;
+    // Nowhere to stand, it stays put
+    if (!resolveNavNode(ctx, enemy)) return;
+
+    if (enemy->jumping) {
+        const NavLink* link = &nav->links[enemy->navLink];
+        enemy->jumpTime += ctx->deltaTime;
+        if (enemy->jumpTime >= link->duration) {
+            enemy->jumping = false;
+            enemy->navNode = link->to;
+            enemy->platformIndex = nav->nodes[link->to].platform;
+            enemy->x = link->landingX - halfWidth;
+            enemy->y = nav->nodes[link->to].y - enemy->height;
+        } else {
+            float x, feetY;
+            navLinkPosition(nav, link, enemy->jumpTime, &x, &feetY);
+            enemy->x = x - halfWidth;
+            enemy->y = feetY - enemy->height;
+        }
+        return;
+    }
+
+    const NavNode* node = &nav->nodes[enemy->navNode];
+    int goal = navNodeAt(nav, shooter->x + shooter->width / 2.0f, shooter->y + shooter->height);
+    bool chasing = fabsf(shooter->x - enemy->x) < ENEMY_CHASE_RANGE;
+    const NavLink* link = chasing && goal != enemy->navNode ? navNextLink(nav, enemy->navNode, goal) : NULL;
+    float targetX = link ? link->takeoffX - halfWidth : shooter->x;
+    float dx = targetX - enemy->x;
+    float moveSpeed = enemy->speed * ctx->deltaTime;
+    if (fabs(dx) > moveSpeed) {
+        enemy->x += (dx > 0) ? moveSpeed : -moveSpeed;
+    } else if (link) {
+        enemy->x = targetX;
+        enemy->jumping = true;
+        enemy->navLink = (int)(link - nav->links);
+        enemy->jumpTime = 0.0f;
+    }
+    enemy->x = fmax(node->left, fmin(enemy->x, node->right - enemy->width));
+    enemy->y = node->y - enemy->height;
+}
+
+// Enemies within this many screen widths of the camera window are paced at the
+// medium tier, each one every LOD_MEDIUM_INTERVAL ticks, staggered by index
+#define LOD_MEDIUM_RANGE 1.0f
+#define LOD_MEDIUM_INTERVAL 4
+// Per-tick budgets: full-rate chases, medium-tier pacing steps and far-tier
+// catch-ups. Work over budget is deferred, never dropped: each tick starts at
+// the first enemy turned away the tick before, which is at least a budget's
+// worth of enemies on, so each gets its turn within a lap of the list (within
+// ceil(n / budget) ticks when only one tier has n enemies over its budget).
+#define LOD_FULL_BUDGET 512
+#define LOD_MEDIUM_BUDGET 128
+#define LOD_CATCHUP_BUDGET 32
+// Flyers off screen pace this far either side of where they left it
+#define LOD_FLYER_PATROL 150.0f
+
+// Left edge of the window player sees: its own camera in split screen, the shared one otherwise
+static float viewLeft(const SimContext* ctx, int player) {
+    return ctx->sim->splitScreen ? ctx->sim->splitCameraX[player] : ctx->sim->cameraX;
+}
+
+// Tier by the nearest camera window, so an enemy either split-screen view shows stays at full rate
+static SimLodTier enemyLodTier(const SimContext* ctx, const Enemy* enemy) {
+    float outside = 0.0f;
+    for (int v = 0; v < (ctx->sim->splitScreen ? 2 : 1); v++) {
+        float left = viewLeft(ctx, v);
+        float right = left + ctx->viewWidth;
+        if (enemy->x >= left && enemy->x <= right) return SIM_LOD_FULL;
+        float distance = enemy->x < left ? left - enemy->x : enemy->x - right;
+        if (v == 0 || distance < outside) outside = distance;
+    }
+    return outside <= ctx->viewWidth * LOD_MEDIUM_RANGE ? SIM_LOD_MEDIUM : SIM_LOD_FAR;
+}
+
+// Sets the range an enemy paces while it is off screen: its span for platform
+// enemies, landing any jump in progress first, and a stretch of air for flyers
+static void startPatrol(SimContext* ctx, Enemy* enemy, bool flyer) {
+    float left = enemy->x, right = enemy->x;
+    if (flyer) {
+        left = fmaxf(worldStartX(ctx) + LEFT_BOUNDARY, enemy->x - LOD_FLYER_PATROL);
+        right = fminf(worldEndX(ctx) - enemy->width, enemy->x + LOD_FLYER_PATROL);
+    } else if (ctx->nav && resolveNavNode(ctx, enemy)) {
+        const NavGraph* nav = ctx->nav;
+        if (enemy->jumping) {
+            const NavLink* link = &nav->links[enemy->navLink];
+            enemy->jumping = false;
+            enemy->navNode = link->to;
+            enemy->platformIndex = nav->nodes[link->to].platform;
+            enemy->x = link->landingX - enemy->width / 2.0f;
+        }
+        const NavNode* node = &nav->nodes[enemy->navNode];
+        enemy->y = node->y - enemy->height;
+        left = node->left;
+        right = node->right - enemy->width;
+    } else if (!ctx->nav && enemy->platformIndex >= 0 && enemy->platformIndex < ctx->numPlatforms) {
+        const Platform* platform = &ctx->platforms[enemy->platformIndex];
+        left = platform->x;
+        right = platform->x + platform->width - enemy->width;
+    }
+    enemy->patrolLeft = left;
+    enemy->patrolRight = fmaxf(left, right);
+    enemy->x = fmaxf(enemy->patrolLeft, fminf(enemy->x, enemy->patrolRight));
+    enemy->patrolDir = 1.0f;
+}
+
+// Closed-form pacing: unfolds the back-and-forth into a loop of twice the
+// range, so catching up any number of seconds costs the same as one tick
+static void advancePatrol(Enemy* enemy, double seconds) {
+    double range = enemy->patrolRight - enemy->patrolLeft;
+    if (range <= 0.0 || seconds <= 0.0) return;
+    double offset = enemy->x - enemy->patrolLeft;
+    double loop = enemy->patrolDir > 0.0f ? offset : 2.0 * range - offset;
+    loop = fmod(loop + enemy->speed * seconds, 2.0 * range);
+    if (loop < range) {
+        enemy->x = (float)(enemy->patrolLeft + loop);
+        enemy->patrolDir = 1.0f;
+    } else {
+        enemy->x = (float)(enemy->patrolLeft + 2.0 * range - loop);
+        enemy->patrolDir = -1.0f;
+    }
+}
+
+// Counts an enemy turned away by its tier's budget, remembering the first one
+// of the tick so the next starts there
+static void deferEnemy(SimContext* ctx, SimLodStats* stats, int index) {
+    stats->deferred++;
+    if (ctx->lodFirstDeferred < 0) ctx->lodFirstDeferred = index;
+}
+
+// Moves an enemy at its level of detail. True when it is on screen and due its
+// full-rate chase this tick, which the caller runs.
+static bool updateEnemyLod(SimContext* ctx, Enemy* enemy, int index, bool flyer) {
+    double now = ctx->sim->clock;
+    SimLodTier tier = enemyLodTier(ctx, enemy);
+    SimLodStats* stats = &ctx->lod[tier];
+    stats->enemies++;
+
+    if (tier == SIM_LOD_FULL) {
+        if (enemy->lodTier != SIM_LOD_FULL) {
+            // Back in view: catch up the pacing it skipped before it chases again
+            SimLodStats* catchup = &ctx->lod[SIM_LOD_FAR];
+            if (catchup->updates >= LOD_CATCHUP_BUDGET) {
+                deferEnemy(ctx, catchup, index);
+                return false;
+            }
+            catchup->updates++;
+            advancePatrol(enemy, now - enemy->lodClock);
+            enemy->lodTier = SIM_LOD_FULL;
+        }
+        enemy->lodClock = now;
+        if (stats->updates >= LOD_FULL_BUDGET) {
+            deferEnemy(ctx, stats, index);
+            return false;
+        }
+        stats->updates++;
+        return true;
+    }
+
+    if (enemy->lodTier == SIM_LOD_FULL) startPatrol(ctx, enemy, flyer);
+    enemy->lodTier = (uint8_t)tier;
+    // Due on its stagger slot, or as soon as budget allows once it has missed one
+    bool due = (index + ctx->sim->tick) % LOD_MEDIUM_INTERVAL == 0 ||
+               now - enemy->lodClock > LOD_MEDIUM_INTERVAL * ctx->deltaTime + 1e-6;
+    if (tier == SIM_LOD_MEDIUM && due) {
+        if (stats->updates >= LOD_MEDIUM_BUDGET) {
+            deferEnemy(ctx, stats, index);
+        } else {
+            stats->updates++;
+            advancePatrol(enemy, now - enemy->lodClock);
+            enemy->lodClock = now;
+        }
+    }
+    return false;
+}
+
+// Full-rate chase of a flyer along its shooter's flow field
+static void chaseFlyer(SimContext* ctx, Enemy* enemy, const FlowField* fields[2]) {
+    Shooter* shooter = enemyTarget(ctx, enemy->x);
+    const FlowField* field = fields[shooter - ctx->shooters];
+    float dirX, dirY;
+    if (field && sampleFlowField(field, enemy->x + enemy->width / 2,
+                                 enemy->y + enemy->height / 2, &dirX, &dirY)) {
+        enemy->x += dirX * enemy->speed * ctx->deltaTime;
+        enemy->y += dirY * enemy->speed * ctx->deltaTime;
+        return;
+    }
+    // In the shooter's cell, or boxed in: close in directly
+    float dx = shooter->x - enemy->x;
+    float dy = shooter->y - enemy->y;
+    float distance = sqrt(dx * dx + dy * dy);
+    
+    if (distance > 0) {
+        enemy->x += (dx / distance) * enemy->speed * ctx->deltaTime;
+        enemy->y += (dy / distance) * enemy->speed * ctx->deltaTime;
+    }
+}
+
+// Full-rate chase of a platform enemy, over the nav graph when there is one
+static void chaseWalker(SimContext* ctx, Enemy* enemy) {
+    if (ctx->nav) {
+        moveOnNavGraph(ctx, enemy, enemyTarget(ctx, enemy->x));
+        return;
+    }
+    // Without a graph, handle movement if on a valid platform
+    int pIndex = enemy->platformIndex;
+    if (pIndex >= 0 && pIndex < ctx->numPlatforms) {
+        Shooter* shooter = enemyTarget(ctx, enemy->x);
+        // Platform-specific logic
+        enemy->y = ctx->platforms[pIndex].y - enemy->height;
+
+        float targetX = shooter->x;
+        float dx = targetX - enemy->x;
+        float moveSpeed = enemy->speed * ctx->deltaTime;
+
+        if (fabs(dx) > moveSpeed) {
+            enemy->x += (dx > 0) ? moveSpeed : -moveSpeed;
+        }
+
+        // Restrict enemy movement to platform bounds
+        enemy->x = fmax(ctx->platforms[pIndex].x, 
+                        fmin(enemy->x, 
+                             ctx->platforms[pIndex].x + ctx->platforms[pIndex].width - enemy->width));
+    }
+}
+
+static void updateEnemies(SimContext* ctx) {
+    memset(ctx->lod, 0, sizeof(ctx->lod));
+    ctx->lodFirstDeferred = -1;
+
+    // Flyers follow a field shared per shooter, rebuilt only when that shooter changes cell
+    const FlowField* fields[2] = {NULL, NULL};
+    if (ctx->numEnemies1 > 0) {
+        for (int p = 0; p < 2; p++) {
+            if (ctx->sim->versus || p == (ctx->sim->isPlayer1Turn ? 0 : 1)) fields[p] = updateFlowField(ctx, p);
+        }
+    }
+
+    // Flyers then platform enemies as one list, walked from the first enemy the
+    // budgets turned away last tick so the ones over budget get their turn first
+    int total = ctx->numEnemies1 + ctx->numEnemies2;
+    if (total == 0) return;
+    int start = (int)(ctx->sim->lodCursor % (uint32_t)total);
+    for (int k = 0; k < total; k++) {
+        int index = (start + k) % total;
+        bool flyer = index < ctx->numEnemies1;
+        Enemy* enemy = flyer ? &ctx->enemies1[index] : &ctx->enemies2[index - ctx->numEnemies1];
+        if (!enemy->active) continue;
+        // move towards shooter if in screen
+        if (updateEnemyLod(ctx, enemy, index, flyer)) {
+            if (flyer) chaseFlyer(ctx, enemy, fields);
+            else chaseWalker(ctx, enemy);
+        }
+    }
+    if (ctx->lodFirstDeferred >= 0) ctx->sim->lodCursor = (uint32_t)ctx->lodFirstDeferred;
+}
+
+static void reportHit(SimContext* ctx, Shooter* shooter, int enemyType) {
+    int player = (int)(shooter - ctx->shooters);
+    float x = shooter->x + shooter->width / 2.0f;
+    float y = shooter->y + shooter->height / 2.0f;
+    publishSimEvent(ctx, SIM_EVENT_HIT, player, enemyType, shooter->health, x, y);
+    if (shooter->health <= 0) publishSimEvent(ctx, SIM_EVENT_DEATH, player, enemyType, 0, x, y);
+}
+
+static void handleEnemyCollisions(SimContext* ctx, Shooter* shooter) {
+    for (int i = 0; i < ctx->numEnemies1; i++) {
+        if (checkEnemyCollision(shooter, &ctx->enemies1[i])) {
+            shooter->health--;
+            reportHit(ctx, shooter, 1);
+            if (shooter->health <= 0) {
+                shooter->dead = true;
+                return;
+            }
+            shooter->x = worldStartX(ctx);
+            shooter->y = GROUND_LEVEL;
+            shooter->velocityY = 0.0f;
+            shooter->onGround = true; 
+            ctx->sim->cameraX = worldStartX(ctx);
+            break; 
+        }
+    }
+    
+    for (int i = 0; i < ctx->numEnemies2; i++) {
+        if (checkEnemyCollision(shooter, &ctx->enemies2[i])) {
+            shooter->health--;
+            reportHit(ctx, shooter, 2);
+            if (shooter->health <= 0) {
+                shooter->dead = true;
+                return;
+            }
+            shooter->x = worldStartX(ctx);
+            shooter->y = GROUND_LEVEL;
+            shooter->velocityY = 0.0f;
+            shooter->onGround = true; 
+            ctx->sim->cameraX = worldStartX(ctx);
+            break; 
+        }
+    }
+}
+
+// Bullets in flight are only ever in the slots the ammo on hand and in the level can fill
+static int bulletSlots(const SimContext* ctx) {
+    int slots = ctx->ammo + (ctx->numAmmos * 3);
+    return slots < SIM_MAX_BULLETS ? slots : SIM_MAX_BULLETS;
+}
+
+static void updateBullets(SimContext* ctx) {
+    int totalBulletSlots = bulletSlots(ctx);
+    
+    for (int i = 0; i < totalBulletSlots; i++) {
+        if (ctx->bullets[i].active) {
+            // Update bullet position
+            ctx->bullets[i].x += ctx->bullets[i].dirX * ctx->bullets[i].speed * ctx->deltaTime;
+            ctx->bullets[i].y += ctx->bullets[i].dirY * ctx->bullets[i].speed * ctx->deltaTime;
+            ctx->bullets[i].lifespan -= ctx->deltaTime;
+
+            // Check if bullet should be deactivated relative to camera position, the shooter's own in split screen
+            float left = viewLeft(ctx, ctx->bullets[i].owner);
+            bool shouldDeactivate = 
+                ctx->bullets[i].lifespan <= 0 || 
+                (ctx->bullets[i].x - left) > ctx->viewWidth || 
+                (ctx->bullets[i].x - left) < 0 ||
+                ctx->bullets[i].y > ctx->viewHeight || 
+                ctx->bullets[i].y < 0;
+
+            if (shouldDeactivate) {
+                ctx->bullets[i].active = false;
+                continue;
+            }
+
+            // Check bullet-platform collision
+            for (int j = 0; j < ctx->numPlatforms; j++) {
+                Platform platform = ctx->platforms[j];
+                if (ctx->bullets[i].x + 10 >= platform.x && 
+                    ctx->bullets[i].x <= platform.x + platform.width &&
+                    ctx->bullets[i].y + 10 >= platform.y && 
+                    ctx->bullets[i].y <= platform.y + platform.height) {
+                    ctx->bullets[i].active = false;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void reportKill(SimContext* ctx, int player, const Enemy* enemy, int enemyType, int points) {
+    float x = enemy->x + enemy->width / 2.0f;
+    float y = enemy->y + enemy->height / 2.0f;
+    publishSimEvent(ctx, SIM_EVENT_KILL, player, enemyType, 0, x, y);
+    publishSimEvent(ctx, SIM_EVENT_SCORE, player, 0, points, x, y);
+}
+
+static void handleBulletEnemyCollisions(SimContext* ctx) {
+    // Use same totalBulletSlots calculation as in updateBullets
+    int totalBulletSlots = bulletSlots(ctx);
+    
+    for (int i = 0; i < totalBulletSlots; i++) {
+        if (ctx->bullets[i].active) {
+            Shooter* shooter = &ctx->shooters[ctx->bullets[i].owner];
+            // Check collisions with type 1 enemies
+            for (int j = 0; j < ctx->numEnemies1; j++) {
+                if (ctx->enemies1[j].active && 
+                    checkBulletEnemyCollision(ctx->bullets[i].x, ctx->bullets[i].y, &ctx->enemies1[j])) {
+                    ctx->enemies1[j].active = false;
+                    ctx->bullets[i].active = false;
+                    reportKill(ctx, ctx->bullets[i].owner, &ctx->enemies1[j], 1, 15);
+                    shooter->score += 15;
+                    break;
+                }
+            }
+            
+            // Only check type 2 enemies if bullet is still active
+            if (ctx->bullets[i].active) {
+                for (int k = 0; k < ctx->numEnemies2; k++) {
+                    if (ctx->enemies2[k].active && 
+                        checkBulletEnemyCollision(ctx->bullets[i].x, ctx->bullets[i].y, &ctx->enemies2[k])) {
+                        ctx->enemies2[k].active = false;
+                        ctx->bullets[i].active = false;
+                        reportKill(ctx, ctx->bullets[i].owner, &ctx->enemies2[k], 2, 10);
+                        shooter->score += 10;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool shooterFinished(const SimContext* ctx, const Shooter* shooter) {
+    return streamOriginX(ctx->sim) + shooter->x + 100 >= ctx->sim->worldWidth;
+}
+
+static void updatePlayer(SimContext* ctx, Shooter* shooter, bool leftPressed, bool rightPressed, bool spacePressed) {
+    updateShooterPosition(ctx, shooter, leftPressed, rightPressed, spacePressed);
+    updateCollectibles(ctx, shooter);
+    updateAmmos(ctx, shooter);
+    updateEnemies(ctx);
+    handleEnemyCollisions(ctx, shooter);
+    // Update camera position based on current shooter
+    if (shooter->x - worldStartX(ctx) >= ctx->viewWidth / 2.0f) {
+        ctx->sim->cameraX = shooter->x - ctx->viewWidth / 2.0f;
+    }
+    updateBullets(ctx);
+    handleBulletEnemyCollisions(ctx);
+}
+
+
+// One fixed-step tick with both players live. Everything here depends only on
+// the sim state and the two inputs, so peers stepping the same inputs stay in sync.
+static SimStatus stepVersus(SimContext* ctx, const SimInput inputs[2]) {
+    for (int p = 0; p < 2; p++) {
+        Shooter* shooter = &ctx->shooters[p];
+        if (shooter->dead || shooterFinished(ctx, shooter)) continue;
+
+        const SimInput* input = &inputs[p];
+        if (input->buttons & INPUT_SHOOT) shootBulletFrom(ctx, shooter, input->aimX, input->aimY);
+        updateShooterPosition(ctx, shooter, input->buttons & INPUT_LEFT, input->buttons & INPUT_RIGHT, input->buttons & INPUT_JUMP);
+        updateCollectibles(ctx, shooter);
+        updateAmmos(ctx, shooter);
+        handleEnemyCollisions(ctx, shooter);
+        shooter->time += ctx->deltaTime;
+    }
+    updateEnemies(ctx);
+
+    // A streamed level only holds STREAM_RESIDENT chunks, the leader waits at the
+    // edge of what the trailing player still needs
+    float leadLimit = streamLeadLimit(ctx);
+    for (int p = 0; p < 2; p++) {
+        Shooter* shooter = &ctx->shooters[p];
+        if (!shooter->dead && !shooterFinished(ctx, shooter) && shooter->x > leadLimit) shooter->x = leadLimit;
+    }
+
+    // Shared camera follows whoever is furthest ahead
+    Shooter* leader = &ctx->shooters[ctx->shooters[1].x > ctx->shooters[0].x ? 1 : 0];
+    ctx->sim->cameraX = fmaxf(worldStartX(ctx), leader->x - ctx->viewWidth / 2.0f);
+    if (ctx->sim->splitScreen) {
+        // Each player's camera stays with them, and where they fell once they are out
+        for (int p = 0; p < 2; p++) {
+            if (!ctx->shooters[p].dead) ctx->sim->splitCameraX[p] = fmaxf(worldStartX(ctx), ctx->shooters[p].x - ctx->viewWidth / 2.0f);
+        }
+    }
+
+    updateBullets(ctx);
+    handleBulletEnemyCollisions(ctx);
+
+    bool over = true;
+    for (int p = 0; p < 2; p++) {
+        if (!ctx->shooters[p].dead && !shooterFinished(ctx, &ctx->shooters[p])) over = false;
+    }
+    ctx->sim->versusOver = over;
+    return over ? SIM_MATCH_OVER : SIM_RUNNING;
+}
+
+SimStatus sim_step(SimContext* ctx, const SimInput inputs[2]) {
+    ctx->sim->tick++;
+    ctx->sim->clock += ctx->deltaTime;
+    updateStreaming(ctx);
+    if (ctx->sim->versus) return stepVersus(ctx, inputs);
+
+    // Handoff mode: only the player whose turn it is moves
+    int current = ctx->sim->isPlayer1Turn ? 0 : 1;
+    Shooter* shooter = &ctx->shooters[current];
+    const SimInput* input = &inputs[current];
+    if (input->buttons & INPUT_SHOOT) shootBulletFrom(ctx, shooter, input->aimX, input->aimY);
+    updatePlayer(ctx, shooter, input->buttons & INPUT_LEFT, input->buttons & INPUT_RIGHT, input->buttons & INPUT_JUMP);
+    shooter->time += ctx->deltaTime;
+    return (shooter->dead || shooterFinished(ctx, shooter)) ? SIM_TURN_OVER : SIM_RUNNING;
+}
+
+SimContext* sim_create(const SimState* level, const Platform* platforms, int numPlatforms, uint32_t seed) {
+    SimContext* ctx = (SimContext*)calloc(1, sizeof(SimContext));
+    SimState* sim = snapshotSimState(level, NULL);
+    Platform* ownPlatforms = (Platform*)malloc((numPlatforms > 0 ? numPlatforms : 1) * sizeof(Platform));
+    if (!ctx || !sim || !ownPlatforms) {
+        free(ctx);
+        free(sim);
+        free(ownPlatforms);
+        return NULL;
+    }
+    if (numPlatforms > 0) memcpy(ownPlatforms, platforms, numPlatforms * sizeof(Platform));
+
+    bindSimState(ctx, sim);
+    seedSimState(sim, seed);
+    ctx->platforms = ownPlatforms;
+    ctx->numPlatforms = numPlatforms;
+    ctx->seed = seed;
+    ctx->deltaTime = SIM_DT;
+    ctx->viewWidth = SIM_VIEW_WIDTH;
+    ctx->viewHeight = SIM_VIEW_HEIGHT;
+    // Without a graph the platform enemies just keep to their own platforms
+    float left, right;
+    streamWindow(ctx, &left, &right);
+    ctx->nav = buildNavGraph(ownPlatforms, numPlatforms, left, right);
+    return ctx;
+}
+
+void sim_destroy(SimContext* ctx) {
+    if (ctx == NULL) return;
+    free(ctx->sim);
+    free(ctx->platforms);
+    free(ctx->flow);
+    free(ctx->nav);
+    free(ctx->consumed);
+    free(ctx);
+}
+
+#define LOD_BENCH_ON_SCREEN 2000
+#define LOD_BENCH_NEAR 1000
+#define LOD_BENCH_TICKS 240
+
+// Steps a crowd of flyers well over the LOD budgets, on screen and just off it,
+// and prints the longest any of them went without moving (--bench-lod). False
+// when that is more than a lap of the list, the most the budgets may defer one.
+bool runLodBenchmark(void) {
+    int total = LOD_BENCH_ON_SCREEN + LOD_BENCH_NEAR;
+    SimState* level = createSimState(total, 0, 0, 0);
+    if (level == NULL) {
+        printf("Out of memory\n");
+        return false;
+    }
+    Shooter* shooter = &level->shooters[0];
+    shooter->x = SIM_VIEW_WIDTH / 2.0f;
+    shooter->y = GROUND_LEVEL - 100;
+    shooter->width = shooter->height = 100;
+    shooter->health = MAX_HEALTH;
+    shooter->onGround = true;
+    level->isPlayer1Turn = true;
+    Enemy* enemies = (Enemy*)((char*)level + level->enemies1Offset);
+    for (int i = 0; i < total; i++) {
+        // On screen either side of the shooter, then just past its right edge, short of the world's end
+        float x = i < LOD_BENCH_ON_SCREEN ? 50.0f + (i % 2 ? SIM_VIEW_WIDTH / 2.0f + 150.0f : 0.0f) + (i / 2) % 600
+                                          : SIM_VIEW_WIDTH + 200.0f + (i - LOD_BENCH_ON_SCREEN) % 700;
+        enemies[i].x = x;
+        enemies[i].y = 100.0f + (i % 7) * 50.0f;
+        enemies[i].width = enemies[i].height = 40;
+        enemies[i].speed = 60.0f;
+        enemies[i].active = true;
+    }
+    SimContext* ctx = sim_create(level, NULL, 0, 1);
+    free(level);
+    float* lastX = (float*)malloc(total * sizeof(float));
+    int* still = (int*)calloc(total, sizeof(int));
+    if (ctx == NULL || lastX == NULL || still == NULL) {
+        printf("Out of memory\n");
+        sim_destroy(ctx);
+        free(lastX);
+        free(still);
+        return false;
+    }
+    for (int i = 0; i < total; i++) lastX[i] = ctx->enemies1[i].x;
+
+    int worst = 0;
+    SimLodStats busiest[SIM_LOD_TIERS] = {{0}};
+    for (int t = 0; t < LOD_BENCH_TICKS; t++) {
+        SimInput inputs[2] = {{0, 0, 0}, {0, 0, 0}};
+        sim_step(ctx, inputs);
+        for (int tier = 0; tier < SIM_LOD_TIERS; tier++) {
+            if (ctx->lod[tier].deferred > busiest[tier].deferred) busiest[tier] = ctx->lod[tier];
+        }
+        for (int i = 0; i < total; i++) {
+            Enemy* enemy = &ctx->enemies1[i];
+            still[i] = enemy->x != lastX[i] ? 0 : still[i] + 1;
+            lastX[i] = enemy->x;
+            if (enemy->active && still[i] > worst) worst = still[i];
+        }
+    }
+    int bound = (total + LOD_CATCHUP_BUDGET - 1) / LOD_CATCHUP_BUDGET;
+    const char* names[SIM_LOD_TIERS] = {"full", "medium", "far"};
+    for (int tier = 0; tier < SIM_LOD_TIERS; tier++) {
+        printf("%-8s %6d enemies %6d updates %6d deferred (busiest tick)\n", names[tier],
+               busiest[tier].enemies, busiest[tier].updates, busiest[tier].deferred);
+    }
+    printf("%d flyers over %d ticks: longest unmoved %d ticks, at most %d allowed\n", total, LOD_BENCH_TICKS, worst, bound);
+    free(lastX);
+    free(still);
+    sim_destroy(ctx);
+    return worst <= bound;
+}
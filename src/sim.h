@@ -0,0 +1,333 @@
+#ifndef SIM_H
+#define SIM_H
+
+// Simulation core (libamsim). No SDL here: tools and tests link this on its own.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WORLD_WIDTH 3000         // width of a level that is resident whole, streamed ones set their own
+#define SHOOTER_SPEED 200
+#define JUMP_SPEED 600
+#define GRAVITY 680
+#define GROUND_LEVEL (1080 - 100)
+#define LEFT_BOUNDARY 0
+#define MAX_BULLETS 10
+#define MAX_HEALTH 3
+
+// Default camera window of a context, the 1080p screen the levels are laid out for
+#define SIM_VIEW_WIDTH 1920
+#define SIM_VIEW_HEIGHT 1080
+
+typedef struct {
+    float x, y;
+    float width, height;
+} Platform;
+
+typedef struct {
+    float x, y;
+    int width, height;
+    float velocityY;
+    bool onGround;
+    int health;
+    int ammo;
+    int score;
+    double time;
+    int sprite;              // index into GameData.sprites
+    int currentFrame;
+    int frameWidth;          
+    int frameHeight;         
+    int totalFrames; 
+    float animationTimer;
+    float frameDelay;
+    bool dead;
+} Shooter;
+
+typedef struct {
+    float x, y;              
+    int width, height;       
+    bool active;   
+    int platformIndex;       
+    int currentFrame;        
+    float speed;      
+    int sprite;              // index into GameData.sprites
+    int frameWidth;          
+    int frameHeight;         
+    int totalFrames; 
+    float animationTimer;
+    float frameDelay;        
+    // Platform enemies on the nav graph, resolved from platformIndex on first move
+    bool navResolved;
+    bool jumping;
+    int navNode;             // span walked on, or the one being jumped from
+    int navLink;             // jump in progress
+    float jumpTime;          // seconds into that jump
+    // Level of detail off screen, see updateEnemies
+    uint8_t lodTier;         // SIM_LOD_* the enemy was simulated at last tick
+    double lodClock;         // sim clock the enemy has been brought up to
+    float patrolLeft, patrolRight;  // range of x paced while off screen
+    float patrolDir;         // +1 pacing right, -1 left
+} Enemy;
+
+typedef struct {
+    float x, y;
+    int width, height;
+    bool collected;
+} Collectible;
+
+typedef struct {
+    float x, y;  
+    float speed; 
+    bool active; 
+    float dirX, dirY;
+    float lifespan;
+    int owner;               // index of the shooter that fired it
+} Bullet;
+
+#define SIM_TICK_RATE 60
+#define SIM_DT (1.0f / SIM_TICK_RATE)
+
+#define INPUT_LEFT  0x01
+#define INPUT_RIGHT 0x02
+#define INPUT_JUMP  0x04
+#define INPUT_SHOOT 0x08
+
+// One player's input for one fixed simulation tick, aim in the state's coordinates
+// (relative to a streamed level's origin, so it stays in range however long the level)
+typedef struct {
+    uint8_t buttons;
+    int16_t aimX, aimY;
+} SimInput;
+
+#define SIM_MAX_BULLETS 100
+
+// Long levels are cut into chunks of STREAM_CHUNK_WIDTH pixels and only
+// STREAM_RESIDENT of them around the camera are in the state at once, each in
+// a slot of fixed capacity in the entity tables (see stream.h). The tables, and
+// so the block, are the same size however long the level is.
+#define STREAM_CHUNK_WIDTH 1024
+#define STREAM_RESIDENT 4
+#define STREAM_CHUNK_PLATFORMS 12
+#define STREAM_CHUNK_ENEMIES 16      // of each kind
+#define STREAM_CHUNK_PICKUPS 16      // collectibles, and as many ammo boxes
+
+// All mutable gameplay state in one contiguous, pointer-free block: this header
+// followed by the enemy, collectible and ammo arrays at the recorded offsets.
+// Snapshot and restore are a single memcpy of size bytes.
+typedef struct {
+    size_t size;            // bytes in the whole block, header included
+    uint32_t tick;
+    uint32_t random;        // PRNG state, part of the block so rollback replays it
+    double clock;           // seconds simulated, off-screen enemies catch up to it
+    uint32_t lodCursor;     // enemy the next tick's LOD budgets start from, see updateEnemies
+    float cameraX;
+    bool isPlayer1Turn;
+    bool versus;            // both shooters live at once (netplay)
+    bool versusOver;
+    bool splitScreen;       // versus on one screen, each shooter followed by its own camera
+    float splitCameraX[2];  // those cameras, each viewWidth wide
+    float worldWidth;       // finish line, WORLD_WIDTH unless the level is streamed
+    int numChunks;          // 0 when the whole level is resident
+    int residentChunk[STREAM_RESIDENT];     // chunk in each slot of the entity tables, -1 for none
+    int originChunk;        // positions are relative to the start of this chunk, see streamOriginX
+    int bulletFrame;
+    float bulletAnimationTimer;
+    Shooter shooters[2];
+    Bullet bullets[SIM_MAX_BULLETS];
+    int numEnemies1;
+    int numEnemies2;
+    int numCollectibles;
+    int numAmmos;
+    size_t enemies1Offset;
+    size_t enemies2Offset;
+    size_t collectiblesOffset;
+    size_t ammosOffset;
+    uint32_t consumedWrites;    // streamed levels: entries of the context's consumed log this state has seen, see stream.h
+} SimState;
+
+// Pursuit grid for the flyers over the level, or over the resident chunks of a
+// streamed one, in cells of FLOW_CELL_SIZE pixels
+#define FLOW_CELL_SIZE 50
+#define FLOW_WIDTH (WORLD_WIDTH > STREAM_CHUNK_WIDTH * STREAM_RESIDENT ? WORLD_WIDTH : STREAM_CHUNK_WIDTH * STREAM_RESIDENT)
+#define FLOW_COLS ((FLOW_WIDTH + FLOW_CELL_SIZE - 1) / FLOW_CELL_SIZE)
+#define FLOW_ROWS ((SIM_VIEW_HEIGHT + FLOW_CELL_SIZE - 1) / FLOW_CELL_SIZE)
+#define FLOW_CELLS (FLOW_COLS * FLOW_ROWS)
+
+// Shortest way around the platforms to one shooter's cell, shared by every flyer.
+// Derived from the platforms and the target cell only, so it is not part of the
+// snapshot: a rollback that moves the shooter to another cell rebuilds it.
+typedef struct {
+    int targetCell;                 // cell the field leads to, -1 until built
+    float originX;                  // world x of the grid's left edge
+    uint8_t blocked[FLOW_CELLS];    // cells overlapping a platform
+    uint16_t distance[FLOW_CELLS];  // steps to the target, FLOW_UNREACHABLE when cut off
+    uint8_t direction[FLOW_CELLS];  // neighbour to move towards, FLOW_DIRECT to steer straight
+} FlowField;
+
+// Enemies are simulated at full rate on screen, paced at a reduced tick rate
+// within a screen of it, and left alone further out until they come back into
+// view, when their pacing is caught up in one step
+typedef enum {
+    SIM_LOD_FULL,
+    SIM_LOD_MEDIUM,
+    SIM_LOD_FAR,
+    SIM_LOD_TIERS
+} SimLodTier;
+
+// Last tick's work per tier. For SIM_LOD_FAR, updates are catch-ups on
+// coming back into view and deferred ones wait for the next tick.
+typedef struct {
+    int enemies;
+    int updates;
+    int deferred;           // over the tier's per-tick budget
+} SimLodStats;
+
+// Gameplay events, published by the step into a ring in the context for any
+// number of readers (effects, HUD, telemetry) to drain, see eventbus.h.
+// Not part of the state: nothing in the sim reads them back.
+typedef enum {
+    SIM_EVENT_KILL,         // a bullet destroyed an enemy, kind is 1 for flyers, 2 for platform enemies
+    SIM_EVENT_HIT,          // an enemy caught a shooter, kind as for kills, value is the health left
+    SIM_EVENT_DEATH,        // the shooter ran out of health
+    SIM_EVENT_PICKUP,       // kind is 0 for a collectible, 1 for ammo
+    SIM_EVENT_SCORE,        // value is the points added
+    SIM_EVENT_SHOT          // value is the ammo left
+} SimEventType;
+
+// Plain data, 20 bytes, so it can be copied into queues and files as is
+typedef struct {
+    uint32_t tick;
+    float x, y;             // world position, centre of what was hit or picked up (not origin relative)
+    int32_t value;
+    uint8_t type;
+    uint8_t player;         // shooter the event happened to or was caused by
+    uint8_t kind;
+} SimEvent;
+
+// Ring size in events, a power of two. Readers further behind than this lose the oldest.
+#define SIM_EVENT_RING 1024
+
+// A walkable span: the top of a platform, or a stretch of ground between low platforms.
+// x is measured at the body's centre, y is where the feet rest.
+typedef struct {
+    float left, right;
+    float y;
+    int platform;           // index into the context's platforms, -1 for ground
+} NavNode;
+
+// A jump from one span to another along the shooter's arc: JUMP_SPEED up,
+// GRAVITY down and vx across, taking duration seconds from takeoff to landing
+typedef struct {
+    int from, to;
+    float takeoffX, landingX;
+    float vx;
+    float duration;
+} NavLink;
+
+// One chunk of a streamed level's graph, in chunk-local x, with platform and node
+// indices counting within the chunk. Room for every span its platforms can make.
+#define NAV_CHUNK_NODES (2 * STREAM_CHUNK_PLATFORMS + 1)
+#define NAV_CHUNK_LINKS 256
+typedef struct {
+    int numNodes;           // 0 until built
+    int numLinks;
+    NavNode nodes[NAV_CHUNK_NODES];
+    NavLink links[NAV_CHUNK_LINKS];
+} NavChunk;
+
+// Walkable spans and the jumps between them, see navgraph.h
+typedef struct NavGraph NavGraph;
+
+// One chunk of a streamed level as the loader decodes it, x relative to the
+// chunk's left edge. Enemy platformIndex counts within the chunk's own platforms.
+typedef struct {
+    int numPlatforms;
+    int numEnemies1;
+    int numEnemies2;
+    int numCollectibles;
+    int numAmmos;
+    Platform platforms[STREAM_CHUNK_PLATFORMS];
+    Enemy enemies1[STREAM_CHUNK_ENEMIES];
+    Enemy enemies2[STREAM_CHUNK_ENEMIES];
+    Collectible collectibles[STREAM_CHUNK_PICKUPS];
+    Collectible ammos[STREAM_CHUNK_PICKUPS];
+    NavChunk nav;           // built with the chunk, off the simulation thread where the provider can
+} LevelChunk;
+
+// Consumed mask of a chunk as it was evicted, see stream.h
+typedef struct {
+    int chunk;
+    uint64_t mask;
+} ChunkConsumed;
+
+// Fills out with a chunk of the level, false when there is nothing to be had
+// (the chunk then plays empty). Called on the simulation thread and must give
+// the same chunk every time: what comes in is part of the deterministic state.
+typedef bool (*ChunkProvider)(void* source, int chunk, LevelChunk* out);
+
+// Everything one simulation instance reads and writes. Nothing in the core is
+// static, so any number of contexts can run side by side in one process.
+// Shooter, enemy, collectible, ammo and bullet pointers point into sim and are
+// set by bindSimState.
+typedef struct {
+    SimState* sim;
+    Shooter* shooters;
+    Platform* platforms;    // level geometry, owned by the context
+    int numPlatforms;
+    Enemy* enemies1;
+    int numEnemies1;
+    Enemy* enemies2;
+    int numEnemies2;
+    Collectible* collectibles;
+    int numCollectibles;
+    Collectible* ammos;
+    int numAmmos;
+    Bullet* bullets;
+    int ammo;
+    uint32_t seed;          // level seed, also feeds the hill noise
+    float deltaTime;        // seconds advanced by the next step
+    int viewWidth;          // camera window: enemies outside it drop to a lower SIM_LOD tier, bullets leaving it expire
+                            // (one viewport's width in split screen, where either camera keeps an enemy at full rate)
+    int viewHeight;
+    FlowField* flow;        // one per shooter, allocated on first use, see flowfield.h
+    NavGraph* nav;          // built with the platforms, NULL leaves platform enemies on their own platform
+    // Streamed levels: where chunks come from, and the chunk whose platforms fill
+    // each slot of platforms. The step brings those in line with the state's
+    // resident set, so a rollback to another set reloads them.
+    ChunkProvider chunks;
+    void* chunkSource;
+    int platformChunk[STREAM_RESIDENT];     // chunk + 1, 0 for none loaded
+    int platformOrigin;                     // originChunk the platforms were placed for
+    NavChunk chunkNav[STREAM_RESIDENT];     // graphs of those chunks, stitched into nav
+    ChunkConsumed* consumed;                // log of evictions, the state's consumedWrites entries of it are live
+    int consumedCapacity;
+    uint32_t navBuilds;     // bumped each time nav is rebuilt, so holders of its links can drop them
+    SimLodStats lod[SIM_LOD_TIERS];
+    int lodFirstDeferred;   // first enemy over budget this tick, -1 for none
+    SimEvent events[SIM_EVENT_RING];
+    uint32_t eventsPublished;           // events ever published, the next goes in slot eventsPublished % SIM_EVENT_RING
+} SimContext;
+
+typedef enum {
+    SIM_RUNNING,
+    SIM_TURN_OVER,          // handoff mode: the current player died or reached the end
+    SIM_MATCH_OVER          // versus: both players are done
+} SimStatus;
+
+// Public API. sim_create copies the level (a template block and its platforms)
+// and seeds the PRNG; sim_step advances one tick of deltaTime (SIM_DT by default)
+// with one input per player, only the current player's is used in handoff mode.
+SimContext* sim_create(const SimState* level, const Platform* platforms, int numPlatforms, uint32_t seed);
+SimStatus sim_step(SimContext* ctx, const SimInput inputs[2]);
+void sim_destroy(SimContext* ctx);
+
+uint32_t simRandom(uint32_t* state);
+float simRandomFloat(uint32_t* state);
+
+void shootBulletFrom(SimContext* ctx, Shooter* shooter, float targetX, float targetY);
+bool shooterFinished(const SimContext* ctx, const Shooter* shooter);
+
+bool runLodBenchmark(void);
+
+#endif
@@ -0,0 +1,147 @@
+#include "simstate.h"
+#include "flowfield.h"
+#include "stream.h"
+
+// Keeps every array in the block aligned for its element types
+static size_t alignSize(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+// One allocation holds the header and all entity arrays, zero-initialised
+static SimState* allocateSimState(int numEnemies1, int numEnemies2, int numCollectibles, int numAmmos, int numChunks) {
+    size_t offset = alignSize(sizeof(SimState));
+    size_t enemies1Offset = offset;
+    offset += alignSize(numEnemies1 * sizeof(Enemy));
+    size_t enemies2Offset = offset;
+    offset += alignSize(numEnemies2 * sizeof(Enemy));
+    size_t collectiblesOffset = offset;
+    offset += alignSize(numCollectibles * sizeof(Collectible));
+    size_t ammosOffset = offset;
+    offset += alignSize(numAmmos * sizeof(Collectible));
+
+    SimState* sim = (SimState*)calloc(1, offset);
+    if (sim == NULL) return NULL;
+    sim->size = offset;
+    sim->random = 1;
+    sim->numEnemies1 = numEnemies1;
+    sim->numEnemies2 = numEnemies2;
+    sim->numCollectibles = numCollectibles;
+    sim->numAmmos = numAmmos;
+    sim->enemies1Offset = enemies1Offset;
+    sim->enemies2Offset = enemies2Offset;
+    sim->collectiblesOffset = collectiblesOffset;
+    sim->ammosOffset = ammosOffset;
+    sim->worldWidth = WORLD_WIDTH;
+    sim->numChunks = numChunks;
+    for (int s = 0; s < STREAM_RESIDENT; s++) sim->residentChunk[s] = -1;
+    return sim;
+}
+
+SimState* createSimState(int numEnemies1, int numEnemies2, int numCollectibles, int numAmmos) {
+    return allocateSimState(numEnemies1, numEnemies2, numCollectibles, numAmmos, 0);
+}
+
+// Tables sized for the resident slots, not the level: every entry starts parked
+// and updateStreaming fills the slots as chunks come in
+SimState* createStreamedSimState(int numChunks, float worldWidth) {
+    SimState* sim = allocateSimState(STREAM_RESIDENT * STREAM_CHUNK_ENEMIES, STREAM_RESIDENT * STREAM_CHUNK_ENEMIES,
+                                     STREAM_RESIDENT * STREAM_CHUNK_PICKUPS, STREAM_RESIDENT * STREAM_CHUNK_PICKUPS,
+                                     numChunks);
+    if (sim == NULL) return NULL;
+    sim->worldWidth = worldWidth;
+    SimContext ctx = {0};
+    bindSimState(&ctx, sim);
+    for (int s = 0; s < STREAM_RESIDENT; s++) parkChunkSlot(&ctx, s);
+    return sim;
+}
+
+// Points the context's entity tables at the arrays inside sim
+void bindSimState(SimContext* ctx, SimState* sim) {
+    char* base = (char*)sim;
+    ctx->sim = sim;
+    ctx->shooters = sim->shooters;
+    ctx->bullets = sim->bullets;
+    ctx->enemies1 = (Enemy*)(base + sim->enemies1Offset);
+    ctx->numEnemies1 = sim->numEnemies1;
+    ctx->enemies2 = (Enemy*)(base + sim->enemies2Offset);
+    ctx->numEnemies2 = sim->numEnemies2;
+    ctx->collectibles = (Collectible*)(base + sim->collectiblesOffset);
+    ctx->numCollectibles = sim->numCollectibles;
+    ctx->ammos = (Collectible*)(base + sim->ammosOffset);
+    ctx->numAmmos = sim->numAmmos;
+    // A new block usually means a new level, the pursuit fields go with the old platforms
+    invalidateFlowFields(ctx);
+}
+
+// Copies sim into snapshot, reallocating it when the block size differs.
+// Returns the snapshot, or NULL if it could not be allocated.
+SimState* snapshotSimState(const SimState* sim, SimState* snapshot) {
+    if (snapshot == NULL || snapshot->size != sim->size) {
+        SimState* resized = (SimState*)realloc(snapshot, sim->size);
+        if (resized == NULL) return NULL;
+        snapshot = resized;
+    }
+    memcpy(snapshot, sim, sim->size);
+    return snapshot;
+}
+
+// Copies a snapshot back over sim in place, so pointers bound to sim stay valid.
+// Fails when the snapshot was taken from a level with a different layout.
+// A streamed level's consumed masks are in its context's log, of which the
+// snapshot only records the length: restore it into the context it was taken
+// from, or one that has stepped through the same ticks.
+bool restoreSimState(SimState* sim, const SimState* snapshot) {
+    if (snapshot->size != sim->size ||
+        snapshot->enemies1Offset != sim->enemies1Offset ||
+        snapshot->enemies2Offset != sim->enemies2Offset ||
+        snapshot->collectiblesOffset != sim->collectiblesOffset ||
+        snapshot->ammosOffset != sim->ammosOffset) {
+        return false;
+    }
+    memcpy(sim, snapshot, snapshot->size);
+    return true;
+}
+
+// xorshift has no zero state, so seed 0 runs as 1
+void seedSimState(SimState* sim, uint32_t seed) {
+    sim->random = seed ? seed : 1;
+}
+
+#define BENCH_ITERATIONS 10000
+
+// Prints snapshot and restore cost for growing entity counts (--bench-snapshot)
+void runSnapshotBenchmark(void) {
+    const int counts[] = {0, 10, 100, 1000, 10000};
+
+    printf("%10s %12s %14s %14s\n", "entities", "bytes", "snapshot ns", "restore ns");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int n = counts[c];
+        SimState* sim = createSimState(n, n, n, n);
+        SimState* snapshot = snapshotSimState(sim, NULL);
+        if (sim == NULL || snapshot == NULL) {
+            printf("Out of memory at %d entities\n", n);
+            free(sim);
+            free(snapshot);
+            return;
+        }
+
+        clock_t start = clock();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            sim->tick = i;
+            snapshot = snapshotSimState(sim, snapshot);
+        }
+        clock_t mid = clock();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            snapshot->tick = i;
+            restoreSimState(sim, snapshot);
+        }
+        clock_t end = clock();
+
+        double snapshotNs = (double)(mid - start) * 1e9 / CLOCKS_PER_SEC / BENCH_ITERATIONS;
+        double restoreNs = (double)(end - mid) * 1e9 / CLOCKS_PER_SEC / BENCH_ITERATIONS;
+        printf("%10d %12zu %14.1f %14.1f\n", n * 4, sim->size, snapshotNs, restoreNs);
+
+        free(sim);
+        free(snapshot);
+    }
+}
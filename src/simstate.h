@@ -0,0 +1,18 @@
+#ifndef SIMSTATE_H
+#define SIMSTATE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+
+SimState* createSimState(int numEnemies1, int numEnemies2, int numCollectibles, int numAmmos);
+SimState* createStreamedSimState(int numChunks, float worldWidth);
+void bindSimState(SimContext* ctx, SimState* sim);
+SimState* snapshotSimState(const SimState* sim, SimState* snapshot);
+bool restoreSimState(SimState* sim, const SimState* snapshot);
+void seedSimState(SimState* sim, uint32_t seed);
+void runSnapshotBenchmark(void);
+
+#endif
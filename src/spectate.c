@@ -0,0 +1,624 @@
+// getaddrinfo and friends are POSIX, hidden by -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include "spectate.h"
+#include "shooter.h"
+#include "simstate.h"
+#include "netplay.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SPEC_FRAME_MAGIC 0x414D5346     // "AMSF", server to spectator
+#define SPEC_ACK_MAGIC 0x414D5341       // "AMSA", spectator to server, doubles as hello
+#define SPEC_NO_TICK 0xFFFFFFFFu
+#define SPEC_HEADER_SIZE 14
+
+#define SPEC_FLAG_PLAYER1_TURN 0x01
+#define SPEC_FLAG_VERSUS 0x02
+#define SPEC_FLAG_VERSUS_OVER 0x04
+
+static void write32(Uint8* p, Uint32 v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static Uint32 read32(const Uint8* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+// MSB-first bit packing into a zeroed buffer
+typedef struct {
+    Uint8* data;
+    int capacity;       // bytes
+    int bits;
+    bool overflow;
+} BitStream;
+
+static void writeBits(BitStream* w, Uint32 value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (w->bits >= w->capacity * 8) {
+            w->overflow = true;
+            return;
+        }
+        if ((value >> i) & 1) w->data[w->bits >> 3] |= 0x80 >> (w->bits & 7);
+        w->bits++;
+    }
+}
+
+static Uint32 readBits(BitStream* r, int count) {
+    Uint32 value = 0;
+    for (int i = 0; i < count; i++) {
+        if (r->bits >= r->capacity * 8) {
+            r->overflow = true;
+            return 0;
+        }
+        value = (value << 1) | ((r->data[r->bits >> 3] >> (7 - (r->bits & 7))) & 1);
+        r->bits++;
+    }
+    return value;
+}
+
+// Unchanged: 1 bit. Small move: 10 bits. Anything else: 18 bits.
+static void writeCoordinate(BitStream* w, Sint16 value, Sint16 base) {
+    int delta = value - base;
+    if (delta == 0) {
+        writeBits(w, 0, 1);
+        return;
+    }
+    writeBits(w, 1, 1);
+    if (delta >= -128 && delta <= 127) {
+        writeBits(w, 1, 1);
+        writeBits(w, (Uint32)(delta + 128), 8);
+    } else {
+        writeBits(w, 0, 1);
+        writeBits(w, (Uint16)value, 16);
+    }
+}
+
+static Sint16 readCoordinate(BitStream* r, Sint16 base) {
+    if (!readBits(r, 1)) return base;
+    if (readBits(r, 1)) return (Sint16)(base + (int)readBits(r, 8) - 128);
+    return (Sint16)readBits(r, 16);
+}
+
+static Sint16 quantize(float v) {
+    float q = v * SPEC_POS_SCALE;
+    if (q > 32767.0f) q = 32767.0f;
+    if (q < -32768.0f) q = -32768.0f;
+    return (Sint16)lrintf(q);
+}
+
+// Inactive entities are sent without position, so they are captured as zeros on both ends
+static void addEntity(SpecFrame* f, float x, float y, int frame, bool active) {
+    if (f->numEntities >= SPEC_MAX_ENTITIES) return;
+    SpecEntity* e = &f->entities[f->numEntities++];
+    e->active = active;
+    e->x = active ? quantize(x) : 0;
+    e->y = active ? quantize(y) : 0;
+    e->frame = active ? (Uint8)(frame & 31) : 0;
+}
+
+// Entity order: shooters, enemies1, enemies2, collectibles, ammos, bullets
+static void captureFrame(GameData* g, SpecFrame* f, Uint32 tick) {
+    f->tick = tick;
+    f->valid = true;
+    f->cameraX = lrintf(g->world.sim->cameraX * SPEC_POS_SCALE);
+    f->flags = (g->world.sim->isPlayer1Turn ? SPEC_FLAG_PLAYER1_TURN : 0) |
+               (g->world.sim->versus ? SPEC_FLAG_VERSUS : 0) |
+               (g->world.sim->versusOver ? SPEC_FLAG_VERSUS_OVER : 0);
+    f->numEntities = 0;
+    for (int i = 0; i < 2; i++) {
+        Shooter* s = &g->world.shooters[i];
+        f->score[i] = (Sint16)s->score;
+        f->health[i] = (Uint8)(s->health < 0 ? 0 : s->health);
+        f->ammo[i] = (Uint8)(s->ammo < 0 ? 0 : s->ammo > 255 ? 255 : s->ammo);
+        f->timeTenths[i] = (Uint16)(s->time * 10.0);
+        addEntity(f, s->x, s->y, s->currentFrame, !s->dead);
+    }
+    for (int i = 0; i < g->world.numEnemies1; i++) {
+        addEntity(f, g->world.enemies1[i].x, g->world.enemies1[i].y, g->world.enemies1[i].currentFrame, g->world.enemies1[i].active);
+    }
+    for (int i = 0; i < g->world.numEnemies2; i++) {
+        addEntity(f, g->world.enemies2[i].x, g->world.enemies2[i].y, g->world.enemies2[i].currentFrame, g->world.enemies2[i].active);
+    }
+    for (int i = 0; i < g->world.numCollectibles; i++) {
+        addEntity(f, g->world.collectibles[i].x, g->world.collectibles[i].y, 0, !g->world.collectibles[i].collected);
+    }
+    for (int i = 0; i < g->world.numAmmos; i++) {
+        addEntity(f, g->world.ammos[i].x, g->world.ammos[i].y, 0, !g->world.ammos[i].collected);
+    }
+    for (int i = 0; i < SIM_MAX_BULLETS; i++) {
+        addEntity(f, g->world.bullets[i].x, g->world.bullets[i].y, 0, g->world.bullets[i].active);
+    }
+}
+
+static const SpecEntity* nextEntity(const SpecFrame* f, int* index) {
+    return *index < f->numEntities ? &f->entities[(*index)++] : NULL;
+}
+
+// Mirrors captureFrame on the spectator's own copy of the level
+static void applyFrame(GameData* g, const SpecFrame* f) {
+    int n = 0;
+    const SpecEntity* e;
+    g->world.sim->cameraX = f->cameraX / (float)SPEC_POS_SCALE;
+    g->world.sim->isPlayer1Turn = f->flags & SPEC_FLAG_PLAYER1_TURN;
+    g->world.sim->versus = f->flags & SPEC_FLAG_VERSUS;
+    g->world.sim->versusOver = f->flags & SPEC_FLAG_VERSUS_OVER;
+    for (int i = 0; i < 2 && (e = nextEntity(f, &n)); i++) {
+        Shooter* s = &g->world.shooters[i];
+        s->score = f->score[i];
+        s->health = f->health[i];
+        s->ammo = f->ammo[i];
+        s->time = f->timeTenths[i] / 10.0;
+        s->dead = !e->active;
+        if (e->active) {
+            s->x = e->x / (float)SPEC_POS_SCALE;
+            s->y = e->y / (float)SPEC_POS_SCALE;
+            s->currentFrame = e->frame;
+        }
+    }
+    Enemy* enemyLists[2] = {g->world.enemies1, g->world.enemies2};
+    int enemyCounts[2] = {g->world.numEnemies1, g->world.numEnemies2};
+    for (int list = 0; list < 2; list++) {
+        for (int i = 0; i < enemyCounts[list] && (e = nextEntity(f, &n)); i++) {
+            Enemy* enemy = &enemyLists[list][i];
+            enemy->active = e->active;
+            if (e->active) {
+                enemy->x = e->x / (float)SPEC_POS_SCALE;
+                enemy->y = e->y / (float)SPEC_POS_SCALE;
+                enemy->currentFrame = e->frame;
+            }
+        }
+    }
+    Collectible* itemLists[2] = {g->world.collectibles, g->world.ammos};
+    int itemCounts[2] = {g->world.numCollectibles, g->world.numAmmos};
+    for (int list = 0; list < 2; list++) {
+        for (int i = 0; i < itemCounts[list] && (e = nextEntity(f, &n)); i++) {
+            itemLists[list][i].collected = !e->active;
+        }
+    }
+    for (int i = 0; i < SIM_MAX_BULLETS && (e = nextEntity(f, &n)); i++) {
+        g->world.bullets[i].active = e->active;
+        if (e->active) {
+            g->world.bullets[i].x = e->x / (float)SPEC_POS_SCALE;
+            g->world.bullets[i].y = e->y / (float)SPEC_POS_SCALE;
+        }
+    }
+}
+
+static bool sameGlobals(const SpecFrame* a, const SpecFrame* b) {
+    return a->cameraX == b->cameraX && a->flags == b->flags &&
+           memcmp(a->score, b->score, sizeof(a->score)) == 0 &&
+           memcmp(a->health, b->health, sizeof(a->health)) == 0 &&
+           memcmp(a->ammo, b->ammo, sizeof(a->ammo)) == 0 &&
+           memcmp(a->timeTenths, b->timeTenths, sizeof(a->timeTenths)) == 0;
+}
+
+static void writeGlobals(BitStream* w, const SpecFrame* f) {
+    writeBits(w, (Uint32)f->cameraX, 32);
+    writeBits(w, f->flags, 3);
+    for (int i = 0; i < 2; i++) {
+        writeBits(w, (Uint16)f->score[i], 16);
+        writeBits(w, f->health[i] > 15 ? 15 : f->health[i], 4);
+        writeBits(w, f->ammo[i], 8);
+        writeBits(w, f->timeTenths[i], 16);
+    }
+}
+
+static void readGlobals(BitStream* r, SpecFrame* f) {
+    f->cameraX = (Sint32)readBits(r, 32);
+    f->flags = (Uint8)readBits(r, 3);
+    for (int i = 0; i < 2; i++) {
+        f->score[i] = (Sint16)readBits(r, 16);
+        f->health[i] = (Uint8)readBits(r, 4);
+        f->ammo[i] = (Uint8)readBits(r, 8);
+        f->timeTenths[i] = (Uint16)readBits(r, 16);
+    }
+}
+
+// Header: magic, tick, base tick (SPEC_NO_TICK for a full frame), entity count.
+// Bits: globals-changed flag [+ globals], then per entity a changed flag and, when
+// changed, the active bit plus coordinate and frame deltas for active entities.
+static int encodeFrame(const SpecFrame* f, const SpecFrame* base, Uint8* packet, int capacity) {
+    static const SpecFrame empty;
+    const SpecFrame* b = base ? base : &empty;
+
+    memset(packet, 0, capacity);
+    write32(packet, SPEC_FRAME_MAGIC);
+    write32(packet + 4, f->tick);
+    write32(packet + 8, base ? base->tick : SPEC_NO_TICK);
+    packet[12] = f->numEntities & 0xFF;
+    packet[13] = f->numEntities >> 8;
+
+    BitStream w = {packet + SPEC_HEADER_SIZE, capacity - SPEC_HEADER_SIZE, 0, false};
+    bool globalsChanged = !base || !sameGlobals(f, b);
+    writeBits(&w, globalsChanged, 1);
+    if (globalsChanged) writeGlobals(&w, f);
+
+    for (int i = 0; i < f->numEntities; i++) {
+        const SpecEntity* e = &f->entities[i];
+        const SpecEntity* be = &b->entities[i];
+        bool changed = e->active != be->active || e->x != be->x || e->y != be->y || e->frame != be->frame;
+        writeBits(&w, changed, 1);
+        if (!changed) continue;
+        writeBits(&w, e->active, 1);
+        if (!e->active) continue;
+        writeCoordinate(&w, e->x, be->x);
+        writeCoordinate(&w, e->y, be->y);
+        if (e->frame == be->frame) {
+            writeBits(&w, 0, 1);
+        } else {
+            writeBits(&w, 1, 1);
+            writeBits(&w, e->frame, 5);
+        }
+    }
+    if (w.overflow) return -1;
+    return SPEC_HEADER_SIZE + (w.bits + 7) / 8;
+}
+
+static bool decodeFrame(const Uint8* packet, int length, const SpecFrame* base, SpecFrame* f) {
+    static const SpecFrame empty;
+    const SpecFrame* b = base ? base : &empty;
+
+    int numEntities = packet[12] | (packet[13] << 8);
+    if (numEntities > SPEC_MAX_ENTITIES) return false;
+    if (base && base->numEntities != numEntities) return false;
+
+    BitStream r = {(Uint8*)packet + SPEC_HEADER_SIZE, length - SPEC_HEADER_SIZE, 0, false};
+    SpecFrame decoded = *b;
+    decoded.tick = read32(packet + 4);
+    decoded.valid = true;
+    decoded.numEntities = numEntities;
+    if (readBits(&r, 1)) readGlobals(&r, &decoded);
+
+    for (int i = 0; i < numEntities; i++) {
+        SpecEntity* e = &decoded.entities[i];
+        if (!readBits(&r, 1)) continue;
+        e->active = readBits(&r, 1);
+        if (!e->active) {
+            e->x = e->y = 0;
+            e->frame = 0;
+            continue;
+        }
+        e->x = readCoordinate(&r, e->x);
+        e->y = readCoordinate(&r, e->y);
+        if (readBits(&r, 1)) e->frame = (Uint8)readBits(&r, 5);
+    }
+    if (r.overflow) return false;
+    *f = decoded;
+    return true;
+}
+
+static int openSocket(int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("Failed to create spectator socket");
+        return -1;
+    }
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        perror("Failed to bind spectator socket");
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+bool spectatorServerStart(SpectatorServer* s, int port) {
+    memset(s, 0, sizeof(*s));
+    s->socket = openSocket(port);
+    if (s->socket < 0) return false;
+    s->startTicks = SDL_GetTicks();
+    s->logJoins = true;
+    return true;
+}
+
+// Acks from known spectators move their baseline, unknown addresses join
+static void receiveAcks(SpectatorServer* s) {
+    Uint8 packet[16];
+    struct sockaddr_in from;
+    socklen_t fromLength = sizeof(from);
+    ssize_t length;
+
+    while ((length = recvfrom(s->socket, packet, sizeof(packet), 0, (struct sockaddr*)&from, &fromLength)) >= 0) {
+        fromLength = sizeof(from);
+        if (length < 8 || read32(packet) != SPEC_ACK_MAGIC) continue;
+
+        SpecClient* client = NULL;
+        for (int i = 0; i < s->numClients; i++) {
+            if (s->clients[i].address.sin_addr.s_addr == from.sin_addr.s_addr &&
+                s->clients[i].address.sin_port == from.sin_port) {
+                client = &s->clients[i];
+                break;
+            }
+        }
+        if (client == NULL) {
+            if (s->numClients >= SPEC_MAX_CLIENTS) continue;
+            client = &s->clients[s->numClients++];
+            memset(client, 0, sizeof(*client));
+            client->address = from;
+            if (s->logJoins) printf("Spectator joined from %s:%d (%d watching)\n",
+                   inet_ntoa(from.sin_addr), ntohs(from.sin_port), s->numClients);
+        }
+        client->lastHeard = SDL_GetTicks();
+
+        Uint32 ack = read32(packet + 4);
+        if (ack != SPEC_NO_TICK && (!client->hasAck || (Sint32)(ack - client->ackTick) > 0)) {
+            client->ackTick = ack;
+            client->hasAck = true;
+        }
+    }
+}
+
+// Sends this tick to every spectator as a delta against the last frame it acked.
+// Frames are numbered by the server, so level resets never alias old baselines.
+void spectatorServerBroadcast(SpectatorServer* s, GameData* g) {
+    if (g->world.sim == NULL) return;
+    // Frames carry neither the streaming origin nor the resident chunks, so a
+    // spectator's copy of a streamed level would put them in the wrong places
+    bool streamed = g->world.sim->numChunks > 0;
+    if (streamed != s->streamedLevel) {
+        if (streamed) printf("[spectate] Streamed level, not sent to spectators\n");
+        s->streamedLevel = streamed;
+    }
+    if (streamed) return;
+    Uint64 start = SDL_GetPerformanceCounter();
+    receiveAcks(s);
+
+    Uint32 tick = ++s->lastTick;
+    SpecFrame* frame = &s->history[tick % SPEC_HISTORY];
+    captureFrame(g, frame, tick);
+
+    Uint32 now = SDL_GetTicks();
+    Uint8 packet[SPEC_PACKET_SIZE];
+    for (int i = 0; i < s->numClients; ) {
+        SpecClient* client = &s->clients[i];
+        if (now - client->lastHeard > SPEC_CLIENT_TIMEOUT_MS) {
+            s->clients[i] = s->clients[--s->numClients];
+            continue;
+        }
+
+        const SpecFrame* base = NULL;
+        if (client->hasAck && tick - client->ackTick < SPEC_HISTORY) {
+            const SpecFrame* candidate = &s->history[client->ackTick % SPEC_HISTORY];
+            if (candidate->valid && candidate->tick == client->ackTick &&
+                candidate->numEntities == frame->numEntities) {
+                base = candidate;
+            }
+        }
+        if (base == NULL) s->fullFrames++;
+
+        int length = encodeFrame(frame, base, packet, sizeof(packet));
+        if (length > 0) {
+            sendto(s->socket, packet, length, 0, (struct sockaddr*)&client->address, sizeof(client->address));
+            client->bytesSent += length;
+            s->bytesSent += length;
+            s->packetsSent++;
+        }
+        i++;
+    }
+    s->frames++;
+    s->broadcastMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void spectatorServerStop(SpectatorServer* s) {
+    if (s->socket >= 0) close(s->socket);
+    s->socket = -1;
+    if (s->frames > 0) {
+        double seconds = (SDL_GetTicks() - s->startTicks) / 1000.0;
+        printf("[spectate] %llu frames, %llu packets (%llu full), %.1f kB/s total, %.3f ms broadcast per frame\n",
+               (unsigned long long)s->frames, (unsigned long long)s->packetsSent, (unsigned long long)s->fullFrames,
+               seconds > 0 ? s->bytesSent / 1024.0 / seconds : 0.0, s->broadcastMs / s->frames);
+    }
+}
+
+bool spectatorViewStart(SpectatorView* v, const char* host, int port) {
+    memset(v, 0, sizeof(*v));
+    v->socket = openSocket(0);
+    if (v->socket < 0) return false;
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0) {
+        fprintf(stderr, "Failed to resolve spectator server %s\n", host);
+        close(v->socket);
+        return false;
+    }
+    memcpy(&v->server, result->ai_addr, sizeof(v->server));
+    v->server.sin_port = htons(port);
+    freeaddrinfo(result);
+    v->startTicks = SDL_GetTicks();
+    return true;
+}
+
+// Drains received frames, acks the newest and applies it. Returns true on a new frame.
+bool spectatorViewUpdate(SpectatorView* v, GameData* g) {
+    Uint8 packet[SPEC_PACKET_SIZE];
+    ssize_t length;
+    bool updated = false;
+
+    while ((length = recv(v->socket, packet, sizeof(packet), 0)) >= 0) {
+        if (length < SPEC_HEADER_SIZE || read32(packet) != SPEC_FRAME_MAGIC) continue;
+        v->packetsReceived++;
+        v->bytesReceived += length;
+
+        Uint32 tick = read32(packet + 4);
+        Uint32 baseTick = read32(packet + 8);
+        const SpecFrame* base = NULL;
+        if (baseTick != SPEC_NO_TICK) {
+            base = &v->history[baseTick % SPEC_HISTORY];
+            if (!base->valid || base->tick != baseTick) {
+                v->missingBaselines++;
+                continue;
+            }
+        }
+
+        SpecFrame* frame = &v->history[tick % SPEC_HISTORY];
+        if (frame == base) continue;    // SPEC_HISTORY ticks behind, nothing to gain
+        if (!decodeFrame(packet, length, base, frame)) continue;
+        if (!v->hasFrame || (Sint32)(tick - v->latestTick) > 0) {
+            v->latestTick = tick;
+            v->hasFrame = true;
+            updated = true;
+        }
+    }
+
+    Uint8 ack[8];
+    write32(ack, SPEC_ACK_MAGIC);
+    write32(ack + 4, v->hasFrame ? v->latestTick : SPEC_NO_TICK);
+    sendto(v->socket, ack, sizeof(ack), 0, (struct sockaddr*)&v->server, sizeof(v->server));
+
+    if (updated && g && g->world.sim) applyFrame(g, &v->history[v->latestTick % SPEC_HISTORY]);
+    return updated;
+}
+
+void spectatorViewStop(SpectatorView* v) {
+    if (v->socket >= 0) close(v->socket);
+    v->socket = -1;
+}
+
+void drawSpectatorStats(SpectatorServer* s, SpectatorView* v) {
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse |
+                             ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing;
+    igSetNextWindowPos((ImVec2){10.0f, 560.0f}, ImGuiCond_FirstUseEver, (ImVec2){0.0f, 0.0f});
+    igBegin("Spectators", NULL, flags);
+    if (s) {
+        double seconds = (SDL_GetTicks() - s->startTicks) / 1000.0;
+        igText("Watching: %d", s->numClients);
+        igText("Sent: %.1f kB/s total, %llu full frames", seconds > 0 ? s->bytesSent / 1024.0 / seconds : 0.0,
+               (unsigned long long)s->fullFrames);
+        igText("Broadcast: %.3f ms/frame", s->frames ? s->broadcastMs / s->frames : 0.0);
+    }
+    if (v) {
+        double seconds = (SDL_GetTicks() - v->startTicks) / 1000.0;
+        igText("Frame %u, %.1f kB/s received", v->latestTick, seconds > 0 ? v->bytesReceived / 1024.0 / seconds : 0.0);
+        igText("Missing baselines: %llu", (unsigned long long)v->missingBaselines);
+    }
+    igEnd();
+}
+
+#define BENCH_TICKS 600
+#define BENCH_ENEMIES 24
+#define BENCH_ITEMS 16
+
+// Synthetic versus level so the benchmark needs no window, textures or level files
+static bool buildBenchLevel(GameData* g, Platform* platforms, int numPlatforms) {
+    memset(g, 0, sizeof(*g));
+    SimState* sim = createSimState(BENCH_ENEMIES, BENCH_ENEMIES / 2, BENCH_ITEMS, BENCH_ITEMS / 2);
+    if (sim == NULL) return false;
+    bindSimState(&g->world, sim);
+    sim->versus = true;
+    g->world.platforms = platforms;
+    g->world.numPlatforms = numPlatforms;
+
+    for (int p = 0; p < 2; p++) {
+        Shooter* s = &g->world.shooters[p];
+        s->x = 50.0f + p * 30.0f;
+        s->y = GROUND_LEVEL;
+        s->width = s->height = 100;
+        s->health = MAX_HEALTH;
+        s->ammo = 20;
+        s->onGround = true;
+        s->totalFrames = 4;
+        s->frameDelay = 0.1f;
+    }
+    for (int i = 0; i < g->world.numEnemies1; i++) {
+        Enemy* e = &g->world.enemies1[i];
+        e->x = 400.0f + i * 110.0f;
+        e->y = 300.0f + (i % 5) * 80.0f;
+        e->width = e->height = 60;
+        e->active = true;
+        e->speed = 50.0f + (i % 4) * 15.0f;
+        e->totalFrames = 4;
+    }
+    for (int i = 0; i < g->world.numEnemies2; i++) {
+        Enemy* e = &g->world.enemies2[i];
+        e->x = platforms[i % numPlatforms].x;
+        e->platformIndex = i % numPlatforms;
+        e->width = e->height = 60;
+        e->active = true;
+        e->speed = 80.0f;
+        e->totalFrames = 4;
+    }
+    for (int i = 0; i < g->world.numCollectibles; i++) {
+        g->world.collectibles[i] = (Collectible){300.0f + i * 170.0f, GROUND_LEVEL - 40.0f, 30, 30, false};
+    }
+    for (int i = 0; i < g->world.numAmmos; i++) {
+        g->world.ammos[i] = (Collectible){500.0f + i * 320.0f, GROUND_LEVEL - 40.0f, 30, 30, false};
+    }
+    return true;
+}
+
+// Serves N loopback spectators from one scripted versus match and prints
+// bandwidth and server CPU per client (--bench-spectate)
+void runSpectatorBenchmark(void) {
+    static Platform platforms[] = {{400, 800, 300, 40}, {900, 650, 300, 40}, {1500, 750, 400, 40}, {2200, 700, 300, 40}};
+    const int numPlatforms = sizeof(platforms) / sizeof(platforms[0]);
+    const int clientCounts[] = {8, 32, 128};
+
+    printf("%8s %12s %14s %14s %12s\n", "clients", "bytes/pkt", "kB/s/client", "us/client/tick", "full frames");
+    for (size_t c = 0; c < sizeof(clientCounts) / sizeof(clientCounts[0]); c++) {
+        int numClients = clientCounts[c];
+        GameData g;
+        SpectatorServer* server = (SpectatorServer*)malloc(sizeof(SpectatorServer));
+        SpectatorView* views = (SpectatorView*)malloc(numClients * sizeof(SpectatorView));
+        if (!server || !views || !buildBenchLevel(&g, platforms, numPlatforms) || !spectatorServerStart(server, 0)) {
+            printf("Failed to set up the spectator benchmark\n");
+            free(server);
+            free(views);
+            return;
+        }
+        server->logJoins = false;
+
+        struct sockaddr_in bound;
+        socklen_t boundLength = sizeof(bound);
+        getsockname(server->socket, (struct sockaddr*)&bound, &boundLength);
+        int opened = 0;
+        for (; opened < numClients; opened++) {
+            if (!spectatorViewStart(&views[opened], "127.0.0.1", ntohs(bound.sin_port))) break;
+            spectatorViewUpdate(&views[opened], NULL);
+        }
+
+        for (int tick = 0; tick < BENCH_TICKS; tick++) {
+            // Both players run right, hop now and then and fire at the enemies ahead
+            SimInput inputs[2] = {{0}, {0}};
+            for (int p = 0; p < 2; p++) {
+                inputs[p].buttons = INPUT_RIGHT | ((tick + p * 17) % 45 == 0 ? INPUT_JUMP : 0);
+                if ((tick + p * 11) % 20 == 0) {
+                    inputs[p].buttons |= INPUT_SHOOT;
+                    inputs[p].aimX = (Sint16)(g.world.shooters[p].x + 600);
+                    inputs[p].aimY = (Sint16)(g.world.shooters[p].y - 150);
+                }
+            }
+            updateVersus(&g, inputs, NET_VIEW_WIDTH, NET_VIEW_HEIGHT);
+            spectatorServerBroadcast(server, &g);
+            for (int i = 0; i < opened; i++) spectatorViewUpdate(&views[i], NULL);
+        }
+
+        double seconds = BENCH_TICKS / (double)SIM_TICK_RATE;
+        printf("%8d %12.1f %14.2f %14.2f %12llu\n", opened,
+               server->packetsSent ? (double)server->bytesSent / server->packetsSent : 0.0,
+               opened ? server->bytesSent / 1024.0 / seconds / opened : 0.0,
+               opened ? server->broadcastMs * 1000.0 / BENCH_TICKS / opened : 0.0,
+               (unsigned long long)server->fullFrames);
+
+        for (int i = 0; i < opened; i++) spectatorViewStop(&views[i]);
+        server->frames = 0;
+        spectatorServerStop(server);
+        free(g.world.sim);
+        free(server);
+        free(views);
+    }
+}
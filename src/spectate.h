@@ -0,0 +1,84 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <netinet/in.h>
+#include "init.h"
+
+#define SPEC_POS_SCALE 4            // positions are sent in quarter pixels
+#define SPEC_HISTORY 64             // frames kept as delta baselines, power of two
+#define SPEC_MAX_CLIENTS 128
+#define SPEC_MAX_ENTITIES 256       // worst case full frame still fits one datagram
+#define SPEC_PACKET_SIZE 1500
+#define SPEC_CLIENT_TIMEOUT_MS 3000
+
+// Quantized replicated fields of one shooter, enemy, collectible or bullet
+typedef struct {
+    Sint16 x, y;
+    Uint8 frame;
+    bool active;
+} SpecEntity;
+
+// Everything a spectator needs to draw one tick
+typedef struct {
+    Uint32 tick;
+    bool valid;
+    Sint32 cameraX;
+    Uint8 flags;
+    Sint16 score[2];
+    Uint8 health[2];
+    Uint8 ammo[2];
+    Uint16 timeTenths[2];
+    int numEntities;
+    SpecEntity entities[SPEC_MAX_ENTITIES];
+} SpecFrame;
+
+typedef struct {
+    struct sockaddr_in address;
+    Uint32 ackTick;
+    bool hasAck;
+    Uint32 lastHeard;
+    Uint64 bytesSent;
+} SpecClient;
+
+// Authoritative side: one delta per client per tick against the client's last acked frame
+typedef struct {
+    int socket;
+    SpecClient clients[SPEC_MAX_CLIENTS];
+    int numClients;
+    SpecFrame history[SPEC_HISTORY];
+    Uint32 lastTick;
+    bool logJoins;
+    bool streamedLevel;     // nothing is sent while a streamed level is played
+
+    Uint64 frames;
+    Uint64 bytesSent;
+    Uint64 packetsSent;
+    Uint64 fullFrames;
+    double broadcastMs;
+    Uint32 startTicks;
+} SpectatorServer;
+
+// Render-only client: applies received frames over a locally loaded copy of the level
+typedef struct {
+    int socket;
+    struct sockaddr_in server;
+    SpecFrame history[SPEC_HISTORY];
+    Uint32 latestTick;
+    bool hasFrame;
+
+    Uint64 bytesReceived;
+    Uint64 packetsReceived;
+    Uint64 missingBaselines;
+    Uint32 startTicks;
+} SpectatorView;
+
+bool spectatorServerStart(SpectatorServer* s, int port);
+void spectatorServerBroadcast(SpectatorServer* s, GameData* g);
+void spectatorServerStop(SpectatorServer* s);
+bool spectatorViewStart(SpectatorView* v, const char* host, int port);
+bool spectatorViewUpdate(SpectatorView* v, GameData* g);
+void spectatorViewStop(SpectatorView* v);
+void drawSpectatorStats(SpectatorServer* s, SpectatorView* v);
+void runSpectatorBenchmark(void);
+
+#endif
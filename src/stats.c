@@ -0,0 +1,150 @@
+#include "stats.h"
+
+static float msSince(Uint64 start, Uint64 end) {
+    return (float)((double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+// Attributes the CPU used since the previous frame to idle or active time
+static void sampleCpu(FrameStats* s, Uint64 now) {
+    clock_t cpu = clock();
+    if (s->lastSample != 0) {
+        double wall = (double)(now - s->lastSample) / (double)SDL_GetPerformanceFrequency();
+        double used = (double)(cpu - s->lastClock) / CLOCKS_PER_SEC;
+        if (s->idle) {
+            s->idleWallSec += wall;
+            s->idleCpuSec += used;
+        } else {
+            s->activeWallSec += wall;
+            s->activeCpuSec += used;
+        }
+
+        s->windowWallSec += wall;
+        s->windowCpuSec += used;
+        if (s->windowWallSec >= 1.0) {
+            s->cpuPercent = (float)(100.0 * s->windowCpuSec / s->windowWallSec);
+            s->windowWallSec = 0.0;
+            s->windowCpuSec = 0.0;
+        }
+    }
+    s->lastSample = now;
+    s->lastClock = cpu;
+}
+
+void statsBeginFrame(FrameStats* s) {
+    s->frameStart = SDL_GetPerformanceCounter();
+    sampleCpu(s, s->frameStart);
+}
+
+// The only place a frame is presented; records how long the present blocked
+// and the interval since the previous one
+void statsPresent(FrameStats* s, SDL_Window* window, SDL_Renderer* renderer) {
+    Uint64 before = SDL_GetPerformanceCounter();
+    s->workMs = msSince(s->frameStart, before);
+    if (renderer) {
+        SDL_RenderPresent(renderer);
+    } else {
+        SDL_GL_SwapWindow(window);
+    }
+    Uint64 after = SDL_GetPerformanceCounter();
+    s->totalPresents++;
+
+    // Idle frames are paced by input, not by the renderer, keep them out of the frame times
+    if (s->lastPresent != 0 && !s->idle) {
+        float frameMs = msSince(s->lastPresent, after);
+        float presentMs = msSince(before, after);
+        s->frameMs[s->head] = frameMs;
+        s->presentMs[s->head] = presentMs;
+        s->head = (s->head + 1) % STATS_HISTORY;
+        if (s->count < STATS_HISTORY) s->count++;
+
+        s->totalFrames++;
+        s->totalFrameMs += frameMs;
+        s->totalFrameMsSq += (double)frameMs * frameMs;
+        s->totalPresentMs += presentMs;
+        if (frameMs > s->worstFrameMs) s->worstFrameMs = frameMs;
+    }
+    s->lastPresent = after;
+}
+
+// Idle frames are left out of the range, as they are out of the frame times
+void statsInternalResolution(FrameStats* s, int width, int height, int upscale) {
+    s->internalWidth = width;
+    s->internalHeight = height;
+    s->upscale = upscale;
+    if (s->idle) return;
+    if (s->lowestHeight == 0 || height < s->lowestHeight) s->lowestHeight = height;
+    if (height > s->highestHeight) s->highestHeight = height;
+}
+
+static void historyAverages(FrameStats* s, float* avgFrame, float* avgPresent, float* maxFrame) {
+    float frameSum = 0.0f, presentSum = 0.0f, frameMax = 0.0f;
+    for (int i = 0; i < s->count; i++) {
+        frameSum += s->frameMs[i];
+        presentSum += s->presentMs[i];
+        if (s->frameMs[i] > frameMax) frameMax = s->frameMs[i];
+    }
+    *avgFrame = s->count > 0 ? frameSum / s->count : 0.0f;
+    *avgPresent = s->count > 0 ? presentSum / s->count : 0.0f;
+    *maxFrame = frameMax;
+}
+
+void drawStatsOverlay(FrameStats* s) {
+    if (!s->showOverlay) return;
+
+    ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                    ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav |
+                                    ImGuiWindowFlags_NoMove;
+
+    float avgFrame, avgPresent, maxFrame;
+    historyAverages(s, &avgFrame, &avgPresent, &maxFrame);
+
+    igSetNextWindowPos((ImVec2){10.0f, 200.0f}, ImGuiCond_Always, (ImVec2){0.0f, 0.0f});
+    igSetNextWindowBgAlpha(0.6f);
+    igBegin("Stats", NULL, window_flags);
+    igText("Backend: %s", s->backend);
+    if (s->upscale > 1) igText("Internal: %dx%d (x%d)", s->internalWidth, s->internalHeight, s->upscale);
+    igText("FPS: %.1f", avgFrame > 0.0f ? 1000.0f / avgFrame : 0.0f);
+    igText("Frame: %.2f ms avg, %.2f ms max", avgFrame, maxFrame);
+    igText("Present: %.2f ms avg", avgPresent);
+    igText("CPU: %.0f%%%s", s->cpuPercent, s->idle ? " (idle)" : "");
+    igText("Presents: %llu", (unsigned long long)s->totalPresents);
+    if (s->drawCalls > 0) igText("Sprites: %d in %d draw calls", s->sprites, s->drawCalls);
+    const SimLodStats* lod = s->lod;
+    igText("Enemies near: %d, %d updated, %d deferred", lod[SIM_LOD_FULL].enemies,
+           lod[SIM_LOD_FULL].updates, lod[SIM_LOD_FULL].deferred);
+    igText("Enemies mid: %d, %d paced, %d deferred", lod[SIM_LOD_MEDIUM].enemies,
+           lod[SIM_LOD_MEDIUM].updates, lod[SIM_LOD_MEDIUM].deferred);
+    igText("Enemies far: %d, %d caught up, %d waiting", lod[SIM_LOD_FAR].enemies,
+           lod[SIM_LOD_FAR].updates, lod[SIM_LOD_FAR].deferred);
+    if (s->splitItems > 0) igText("Split screen: %d entities, %d in both views", s->splitItems, s->splitShared);
+    igPlotLines_FloatPtr("##frametimes", s->frameMs, s->count, s->head % (s->count > 0 ? s->count : 1),
+                         NULL, 0.0f, 50.0f, (ImVec2){240.0f, 60.0f}, sizeof(float));
+    igEnd();
+}
+
+void printStatsSummary(FrameStats* s) {
+    if (s->idleWallSec > 0.0) {
+        printf("[%s] Idle: %.1f s, CPU %.1f%%\n", s->backend, s->idleWallSec, 100.0 * s->idleCpuSec / s->idleWallSec);
+    }
+    if (s->activeWallSec > 0.0) {
+        printf("[%s] Active: %.1f s, CPU %.1f%%\n", s->backend, s->activeWallSec, 100.0 * s->activeCpuSec / s->activeWallSec);
+    }
+    if (s->levelResets > 0) {
+        printf("[%s] Level resets from template: %d, %.3f ms avg\n", s->backend, s->levelResets,
+               s->levelResetMs / s->levelResets);
+    }
+    if (s->totalFrames == 0) return;
+    double avgFrame = s->totalFrameMs / (double)s->totalFrames;
+    double variance = s->totalFrameMsSq / (double)s->totalFrames - avgFrame * avgFrame;
+    printf("[%s] Frames: %llu, presents: %llu, avg frame %.2f ms, worst frame %.2f ms\n",
+           s->backend, (unsigned long long)s->totalFrames, (unsigned long long)s->totalPresents,
+           avgFrame, s->worstFrameMs);
+    if (s->lowestHeight == s->highestHeight && s->lowestHeight > 0) {
+        printf("[%s] Internal height: %d px\n", s->backend, s->lowestHeight);
+    } else if (s->lowestHeight > 0) {
+        printf("[%s] Internal height: %d to %d px\n", s->backend, s->lowestHeight, s->highestHeight);
+    }
+    // Present-to-present jitter and the share of it spent waiting on vsync
+    printf("[%s] Present interval: stddev %.2f ms, blocked in present %.2f ms avg\n",
+           s->backend, variance > 0.0 ? sqrt(variance) : 0.0, s->totalPresentMs / (double)s->totalFrames);
+}
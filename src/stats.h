@@ -0,0 +1,12 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "init.h"
+
+void statsBeginFrame(FrameStats* s);
+void statsPresent(FrameStats* s, SDL_Window* window, SDL_Renderer* renderer);
+void statsInternalResolution(FrameStats* s, int width, int height, int upscale);
+void drawStatsOverlay(FrameStats* s);
+void printStatsSummary(FrameStats* s);
+
+#endif
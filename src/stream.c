@@ -0,0 +1,390 @@
+#include "stream.h"
+#include "flowfield.h"
+#include "navgraph.h"
+#include "simstate.h"
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Latest mask logged for chunk up to the state's place in the log. A scan, but
+// it runs once per chunk coming in and the log grows by one entry per chunk left.
+static uint64_t consumedMask(const SimContext* ctx, int chunk) {
+    for (uint32_t i = ctx->sim->consumedWrites; i-- > 0; ) {
+        if (ctx->consumed[i].chunk == chunk) return ctx->consumed[i].mask;
+    }
+    return 0;
+}
+
+// Entries past the state's place are from a future a restore undid, the write
+// replaces them. On allocation failure the chunk comes back whole.
+static void logConsumed(SimContext* ctx, int chunk, uint64_t mask) {
+    SimState* sim = ctx->sim;
+    if ((int)sim->consumedWrites >= ctx->consumedCapacity) {
+        int capacity = ctx->consumedCapacity ? ctx->consumedCapacity * 2 : 64;
+        ChunkConsumed* grown = (ChunkConsumed*)realloc(ctx->consumed, capacity * sizeof(ChunkConsumed));
+        if (grown == NULL) return;
+        ctx->consumed = grown;
+        ctx->consumedCapacity = capacity;
+    }
+    ctx->consumed[sim->consumedWrites].chunk = chunk;
+    ctx->consumed[sim->consumedWrites].mask = mask;
+    sim->consumedWrites++;
+}
+
+static void parkEnemy(Enemy* enemy) {
+    memset(enemy, 0, sizeof(*enemy));
+    enemy->x = STREAM_PARKED_X;
+    enemy->platformIndex = -1;
+}
+
+static void parkPickup(Collectible* pickup) {
+    memset(pickup, 0, sizeof(*pickup));
+    pickup->x = STREAM_PARKED_X;
+    pickup->collected = true;
+}
+
+void parkChunkSlot(SimContext* ctx, int slot) {
+    for (int i = 0; i < STREAM_CHUNK_ENEMIES; i++) {
+        parkEnemy(&ctx->enemies1[slot * STREAM_CHUNK_ENEMIES + i]);
+        parkEnemy(&ctx->enemies2[slot * STREAM_CHUNK_ENEMIES + i]);
+    }
+    for (int i = 0; i < STREAM_CHUNK_PICKUPS; i++) {
+        parkPickup(&ctx->collectibles[slot * STREAM_CHUNK_PICKUPS + i]);
+        parkPickup(&ctx->ammos[slot * STREAM_CHUNK_PICKUPS + i]);
+    }
+}
+
+void streamWindow(const SimContext* ctx, float* left, float* right) {
+    const SimState* sim = ctx->sim;
+    int first = -1, last = -1;
+    for (int s = 0; s < STREAM_RESIDENT && sim->numChunks > 0; s++) {
+        int c = sim->residentChunk[s];
+        if (c < 0) continue;
+        if (first < 0 || c < first) first = c;
+        if (c > last) last = c;
+    }
+    double origin = streamOriginX(sim);
+    if (first < 0) {
+        *left = (float)(LEFT_BOUNDARY - origin);
+        *right = (float)(sim->worldWidth - origin);
+        return;
+    }
+    *left = (float)((first - sim->originChunk) * STREAM_CHUNK_WIDTH);
+    *right = (float)(fmin((double)(last + 1) * STREAM_CHUNK_WIDTH, sim->worldWidth) - origin);
+}
+
+double streamOriginX(const SimState* sim) {
+    return (double)sim->originChunk * STREAM_CHUNK_WIDTH;
+}
+
+// Entries the chunk no longer has are inactive or collected, entries past its
+// count are parked and set bits nobody reads. What came in already consumed was
+// left parked, so the mask is the chunk's whole history and replaces the last.
+static void evictChunk(SimContext* ctx, int slot) {
+    SimState* sim = ctx->sim;
+    uint64_t mask = 0;
+    for (int i = 0; i < STREAM_CHUNK_ENEMIES; i++) {
+        if (!ctx->enemies1[slot * STREAM_CHUNK_ENEMIES + i].active) mask |= 1ull << (STREAM_BIT_ENEMIES1 + i);
+        if (!ctx->enemies2[slot * STREAM_CHUNK_ENEMIES + i].active) mask |= 1ull << (STREAM_BIT_ENEMIES2 + i);
+    }
+    for (int i = 0; i < STREAM_CHUNK_PICKUPS; i++) {
+        if (ctx->collectibles[slot * STREAM_CHUNK_PICKUPS + i].collected) mask |= 1ull << (STREAM_BIT_COLLECTIBLES + i);
+        if (ctx->ammos[slot * STREAM_CHUNK_PICKUPS + i].collected) mask |= 1ull << (STREAM_BIT_AMMOS + i);
+    }
+    logConsumed(ctx, sim->residentChunk[slot], mask);
+    parkChunkSlot(ctx, slot);
+    sim->residentChunk[slot] = -1;
+}
+
+// Copies a chunk's entities into a slot, less those its mask says are gone.
+// Enemies start their level of detail clock now, not at the start of the level.
+static void activateChunk(SimContext* ctx, int slot, int chunkIndex) {
+    SimState* sim = ctx->sim;
+    LevelChunk chunk;
+    parkChunkSlot(ctx, slot);
+    sim->residentChunk[slot] = chunkIndex;
+    if (ctx->chunks == NULL || !ctx->chunks(ctx->chunkSource, chunkIndex, &chunk)) return;
+
+    float offset = (float)((chunkIndex - sim->originChunk) * STREAM_CHUNK_WIDTH);
+    uint64_t consumed = consumedMask(ctx, chunkIndex);
+    for (int i = 0; i < chunk.numEnemies1 && i < STREAM_CHUNK_ENEMIES; i++) {
+        if (consumed & (1ull << (STREAM_BIT_ENEMIES1 + i))) continue;
+        Enemy* enemy = &ctx->enemies1[slot * STREAM_CHUNK_ENEMIES + i];
+        *enemy = chunk.enemies1[i];
+        enemy->x += offset;
+        enemy->lodTier = SIM_LOD_FULL;
+        enemy->lodClock = sim->clock;
+    }
+    for (int i = 0; i < chunk.numEnemies2 && i < STREAM_CHUNK_ENEMIES; i++) {
+        if (consumed & (1ull << (STREAM_BIT_ENEMIES2 + i))) continue;
+        Enemy* enemy = &ctx->enemies2[slot * STREAM_CHUNK_ENEMIES + i];
+        int platform = chunk.enemies2[i].platformIndex;
+        *enemy = chunk.enemies2[i];
+        enemy->x += offset;
+        enemy->platformIndex = platform >= 0 && platform < chunk.numPlatforms && platform < STREAM_CHUNK_PLATFORMS ?
+                               slot * STREAM_CHUNK_PLATFORMS + platform : -1;
+        enemy->navResolved = false;
+        enemy->jumping = false;
+        enemy->lodTier = SIM_LOD_FULL;
+        enemy->lodClock = sim->clock;
+    }
+    for (int i = 0; i < chunk.numCollectibles && i < STREAM_CHUNK_PICKUPS; i++) {
+        if (consumed & (1ull << (STREAM_BIT_COLLECTIBLES + i))) continue;
+        ctx->collectibles[slot * STREAM_CHUNK_PICKUPS + i] = chunk.collectibles[i];
+        ctx->collectibles[slot * STREAM_CHUNK_PICKUPS + i].x += offset;
+    }
+    for (int i = 0; i < chunk.numAmmos && i < STREAM_CHUNK_PICKUPS; i++) {
+        if (consumed & (1ull << (STREAM_BIT_AMMOS + i))) continue;
+        ctx->ammos[slot * STREAM_CHUNK_PICKUPS + i] = chunk.ammos[i];
+        ctx->ammos[slot * STREAM_CHUNK_PICKUPS + i].x += offset;
+    }
+}
+
+// Platform enemies hold nav node indices, which a new graph renumbers. Jumps in
+// progress land first, on the graph they were planned on, and everyone finds
+// their span again from the platform they stand on, which keeps its index.
+void releaseNavNodes(SimContext* ctx) {
+    const NavGraph* nav = ctx->nav;
+    for (int i = 0; i < ctx->numEnemies2; i++) {
+        Enemy* enemy = &ctx->enemies2[i];
+        if (!enemy->navResolved) continue;
+        if (enemy->jumping && nav) {
+            const NavLink* link = &nav->links[enemy->navLink];
+            enemy->platformIndex = nav->nodes[link->to].platform;
+            enemy->x = link->landingX - enemy->width / 2.0f;
+            enemy->y = nav->nodes[link->to].y - enemy->height;
+        }
+        enemy->jumping = false;
+        enemy->navResolved = false;
+    }
+}
+
+// Derived from the resident set and the origin alone, so it is rebuilt the same
+// whether they changed by stepping or by restoring a snapshot
+static void syncChunkPlatforms(SimContext* ctx) {
+    const SimState* sim = ctx->sim;
+    if (ctx->chunks == NULL || ctx->numPlatforms < STREAM_RESIDENT * STREAM_CHUNK_PLATFORMS) return;
+
+    if (ctx->platformOrigin != sim->originChunk) {
+        memset(ctx->platformChunk, 0, sizeof(ctx->platformChunk));
+        ctx->platformOrigin = sim->originChunk;
+    }
+    bool changed = false;
+    for (int s = 0; s < STREAM_RESIDENT; s++) {
+        int c = sim->residentChunk[s];
+        if (ctx->platformChunk[s] == c + 1) continue;
+        Platform* platforms = &ctx->platforms[s * STREAM_CHUNK_PLATFORMS];
+        int count = 0;
+        LevelChunk chunk;
+        bool read = c >= 0 && ctx->chunks(ctx->chunkSource, c, &chunk);
+        if (read) {
+            float offset = (float)((c - sim->originChunk) * STREAM_CHUNK_WIDTH);
+            count = chunk.numPlatforms < STREAM_CHUNK_PLATFORMS ? chunk.numPlatforms : STREAM_CHUNK_PLATFORMS;
+            for (int i = 0; i < count; i++) {
+                platforms[i] = chunk.platforms[i];
+                platforms[i].x += offset;
+            }
+        }
+        for (int i = count; i < STREAM_CHUNK_PLATFORMS; i++) {
+            platforms[i] = (Platform){STREAM_PARKED_X, 0.0f, 0.0f, 0.0f};
+        }
+        // The provider normally hands the chunk's graph over built, only one that
+        // does not (or an unreadable chunk, which plays as bare ground) costs a build here
+        if (read && chunk.nav.numNodes > 0) {
+            ctx->chunkNav[s] = chunk.nav;
+        } else if (c >= 0) {
+            buildNavChunk(&ctx->chunkNav[s], read ? chunk.platforms : NULL, count);
+        }
+        ctx->platformChunk[s] = c + 1;
+        changed = true;
+    }
+    if (!changed) return;
+
+    float left, right;
+    streamWindow(ctx, &left, &right);
+    free(ctx->nav);
+    ctx->nav = stitchNavGraph(ctx->chunkNav, sim->residentChunk, sim->originChunk, ctx->platforms, ctx->numPlatforms, right);
+    ctx->navBuilds++;
+    invalidateFlowFields(ctx);
+}
+
+static void shiftX(float* x, float shift) {
+    if (*x != STREAM_PARKED_X) *x += shift;
+}
+
+// Moves the origin to the start of chunk. Every x in the state moves by the
+// same whole number of chunks, so distances between them come out unchanged.
+static void rebaseOrigin(SimContext* ctx, int chunk) {
+    SimState* sim = ctx->sim;
+    float shift = (float)((sim->originChunk - chunk) * STREAM_CHUNK_WIDTH);
+    for (int p = 0; p < 2; p++) {
+        ctx->shooters[p].x += shift;
+        sim->splitCameraX[p] += shift;
+    }
+    sim->cameraX += shift;
+    for (int i = 0; i < SIM_MAX_BULLETS; i++) ctx->bullets[i].x += shift;
+    for (int list = 0; list < 2; list++) {
+        Enemy* enemies = list ? ctx->enemies2 : ctx->enemies1;
+        int count = list ? ctx->numEnemies2 : ctx->numEnemies1;
+        for (int i = 0; i < count; i++) {
+            shiftX(&enemies[i].x, shift);
+            enemies[i].patrolLeft += shift;
+            enemies[i].patrolRight += shift;
+        }
+    }
+    for (int i = 0; i < ctx->numCollectibles; i++) shiftX(&ctx->collectibles[i].x, shift);
+    for (int i = 0; i < ctx->numAmmos; i++) shiftX(&ctx->ammos[i].x, shift);
+    sim->originChunk = chunk;
+}
+
+static bool shooterPlaying(const SimContext* ctx, const Shooter* shooter) {
+    return !shooter->dead && !shooterFinished(ctx, shooter);
+}
+
+// The camera that follows a shooter at x, as stepVersus places it
+static float cameraFor(const SimContext* ctx, float x) {
+    return fmaxf((float)-streamOriginX(ctx->sim), x - ctx->viewWidth / 2.0f);
+}
+
+// Leftmost and rightmost camera the window has to hold. Versus needs the
+// surroundings of every shooter still playing, not just the shared camera on
+// the leader; a player who is out keeps whatever is resident.
+static void cameraSpan(const SimContext* ctx, float* left, float* right) {
+    *left = *right = ctx->sim->cameraX;
+    if (!ctx->sim->versus) return;
+    bool any = false;
+    for (int p = 0; p < 2; p++) {
+        if (!shooterPlaying(ctx, &ctx->shooters[p])) continue;
+        float camera = cameraFor(ctx, ctx->shooters[p].x);
+        if (!any || camera < *left) *left = camera;
+        if (!any || camera > *right) *right = camera;
+        any = true;
+    }
+    if (!any) *left = *right = ctx->sim->cameraX;
+}
+
+float streamLeadLimit(const SimContext* ctx) {
+    const SimState* sim = ctx->sim;
+    if (sim->numChunks <= 0 || !sim->versus) return INFINITY;
+    float left, right;
+    cameraSpan(ctx, &left, &right);
+    // The trailing camera's chunk and the STREAM_RESIDENT - 1 after it, with
+    // the leader's whole view inside them
+    float chunkStart = floorf(left / STREAM_CHUNK_WIDTH) * STREAM_CHUNK_WIDTH;
+    return chunkStart + STREAM_RESIDENT * STREAM_CHUNK_WIDTH - ctx->viewWidth / 2.0f;
+}
+
+void updateStreaming(SimContext* ctx) {
+    SimState* sim = ctx->sim;
+    if (sim->numChunks <= 0) return;
+
+    // A restored snapshot may hold another set than the one the geometry was built for
+    syncChunkPlatforms(ctx);
+
+    // From the chunk behind the leftmost camera's, as far right as the slots go,
+    // inside the level. When the rightmost view needs the slot behind, it gets it
+    // (streamLeadLimit keeps it within the leftmost camera's chunk and the rest).
+    float left, right;
+    cameraSpan(ctx, &left, &right);
+    int leftChunk = sim->originChunk + (int)floorf(left / STREAM_CHUNK_WIDTH);
+    int rightChunk = sim->originChunk + (int)floorf((right + ctx->viewWidth - 1.0f) / STREAM_CHUNK_WIDTH);
+    int first = leftChunk - 1;
+    if (first < rightChunk - (STREAM_RESIDENT - 1)) first = rightChunk - (STREAM_RESIDENT - 1);
+    if (first > leftChunk) first = leftChunk;
+    if (first > sim->numChunks - STREAM_RESIDENT) first = sim->numChunks - STREAM_RESIDENT;
+    if (first < 0) first = 0;
+    int last = first + STREAM_RESIDENT - 1;
+    if (last >= sim->numChunks) last = sim->numChunks - 1;
+
+    bool changed = false;
+    if (first != sim->originChunk) {
+        releaseNavNodes(ctx);
+        rebaseOrigin(ctx, first);
+        changed = true;
+    }
+    for (int s = 0; s < STREAM_RESIDENT; s++) {
+        int c = sim->residentChunk[s];
+        if (c >= 0 && (c < first || c > last)) {
+            if (!changed) releaseNavNodes(ctx);
+            evictChunk(ctx, s);
+            changed = true;
+        }
+    }
+    for (int c = first; c <= last; c++) {
+        int empty = -1;
+        bool resident = false;
+        for (int s = 0; s < STREAM_RESIDENT; s++) {
+            if (sim->residentChunk[s] == c) resident = true;
+            if (empty < 0 && sim->residentChunk[s] < 0) empty = s;
+        }
+        if (resident || empty < 0) continue;
+        if (!changed) releaseNavNodes(ctx);
+        activateChunk(ctx, empty, c);
+        changed = true;
+    }
+    if (changed) syncChunkPlatforms(ctx);
+}
+
+#define PRECISION_START_X 1.0e7
+#define PRECISION_TICKS 4000
+
+// Flat ground all the way, so every step on it should be SHOOTER_SPEED * SIM_DT
+static bool emptyChunk(void* source, int chunk, LevelChunk* out) {
+    (void)source;
+    (void)chunk;
+    memset(out, 0, sizeof(*out));
+    return true;
+}
+
+// Walks a shooter right from x = 10^7 and prints the worst per-tick step error,
+// in world x rebuilt from the origin and as a float world x (--bench-precision)
+void runPrecisionBenchmark(void) {
+    int numChunks = (int)(PRECISION_START_X / STREAM_CHUNK_WIDTH) + 2 * STREAM_RESIDENT + PRECISION_TICKS / 100;
+    SimState* level = createStreamedSimState(numChunks, (float)numChunks * STREAM_CHUNK_WIDTH);
+    Platform* platforms = (Platform*)calloc(STREAM_RESIDENT * STREAM_CHUNK_PLATFORMS, sizeof(Platform));
+    if (level == NULL || platforms == NULL) {
+        printf("Out of memory\n");
+        free(level);
+        free(platforms);
+        return;
+    }
+    Shooter* start = &level->shooters[0];
+    start->x = (float)PRECISION_START_X;
+    start->y = GROUND_LEVEL;
+    start->width = start->height = 100;
+    start->health = 1;
+    start->onGround = true;
+    level->isPlayer1Turn = true;
+    level->cameraX = start->x - SIM_VIEW_WIDTH / 2.0f;
+    SimContext* ctx = sim_create(level, platforms, STREAM_RESIDENT * STREAM_CHUNK_PLATFORMS, 1);
+    free(level);
+    free(platforms);
+    if (ctx == NULL) {
+        printf("Out of memory\n");
+        return;
+    }
+    ctx->chunks = emptyChunk;
+
+    const double expected = SHOOTER_SPEED * SIM_DT;
+    double lastX = 0.0, worst = 0.0, worstFloat = 0.0;
+    float lastFloat = 0.0f;
+    int rebases = 0, lastOrigin = ctx->sim->originChunk;
+    for (int t = 0; t < PRECISION_TICKS; t++) {
+        SimInput inputs[2] = {{INPUT_RIGHT, 0, 0}, {0, 0, 0}};
+        sim_step(ctx, inputs);
+        if (ctx->sim->originChunk != lastOrigin) rebases++;
+        lastOrigin = ctx->sim->originChunk;
+        double x = streamOriginX(ctx->sim) + ctx->shooters[0].x;
+        float asFloat = (float)x;
+        if (t > 0 && ctx->shooters[0].onGround) {
+            worst = fmax(worst, fabs((x - lastX) - expected));
+            worstFloat = fmax(worstFloat, fabs((double)(asFloat - lastFloat) - expected));
+        }
+        lastX = x;
+        lastFloat = asFloat;
+    }
+    printf("Walked from x = %.0f to %.4f in %d ticks, %d origin moves\n", PRECISION_START_X, lastX, PRECISION_TICKS, rebases);
+    printf("Worst step error against %.4f px: %.6f px rebased, %.6f px as a float world x\n", expected, worst, worstFloat);
+    sim_destroy(ctx);
+}
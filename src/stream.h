@@ -0,0 +1,54 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "sim.h"
+
+// Streamed levels keep STREAM_RESIDENT chunks around the camera in fixed slots:
+// slot s owns entries [s * capacity, (s + 1) * capacity) of each entity table and
+// of the context's platforms. Unused entries are parked far off to the left,
+// inactive or collected, so every loop over the tables runs as for a whole level.
+#define STREAM_PARKED_X -1.0e6f
+
+// A chunk's consumed mask has a bit per enemy killed or pickup taken, by index
+// within the chunk, so it comes back without them after it has been evicted.
+// 64 bits: the per-chunk capacities in sim.h must stay at 16. Evictions append
+// the mask to a log in the context and the state keeps only how many entries
+// it has seen, so the block is the same size however long the level, and a
+// restored snapshot overwrites whatever was logged after it.
+#define STREAM_BIT_ENEMIES1 0
+#define STREAM_BIT_ENEMIES2 16
+#define STREAM_BIT_COLLECTIBLES 32
+#define STREAM_BIT_AMMOS 48
+
+// Brings the resident set in line with the camera: chunks that fell out of the
+// window write their consumed bits back and leave their slot, chunks coming into
+// it are read from the context's provider. Then rebuilds the platforms, stitches
+// the nav graph from the chunks' own and drops the flow fields if the set differs
+// from the one they were built for.
+// Runs at the start of every step and does nothing for a whole level.
+void updateStreaming(SimContext* ctx);
+// Empties a slot's entries in the state's tables
+void parkChunkSlot(SimContext* ctx, int slot);
+// Platform enemies let go of their nav nodes before the graph is replaced:
+// jumps land where they were headed and everyone resolves again from platformIndex
+void releaseNavNodes(SimContext* ctx);
+// Versus on a streamed level: furthest right a shooter may go, so the leader's
+// view and the trailing player's chunk fit in the resident slots together.
+// INFINITY for a whole level or handoff play.
+float streamLeadLimit(const SimContext* ctx);
+// x range covered by the resident chunks, the whole level when it is not streamed
+void streamWindow(const SimContext* ctx, float* left, float* right);
+
+// Far along a streamed level a float world x has whole pixel steps, so the
+// state keeps every x relative to the start of the first resident chunk
+// instead. When the window moves on, everything is shifted by whole chunks
+// (exact in a float) and the origin moves with it. This is the world x of the
+// state's 0: add it for anything kept outside the state, such as ghosts, effects
+// and the flag, in double. 0 for a whole level.
+double streamOriginX(const SimState* sim);
+
+// Walks a shooter across a flat streamed level from x = 10^7 and prints the worst
+// per-tick step error with the origin and without it, then returns
+void runPrecisionBenchmark(void);
+
+#endif
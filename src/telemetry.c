@@ -0,0 +1,152 @@
+#include "telemetry.h"
+
+static const char* eventNames[] = {"kill", "hit", "death", "pickup", "score", "shot"};
+
+static int writerThread(void* data) {
+    Telemetry* t = (Telemetry*)data;
+    SimEvent event;
+    while (true) {
+        if (popEventQueue(&t->queue, &event)) {
+            const char* name = event.type < sizeof(eventNames) / sizeof(eventNames[0]) ? eventNames[event.type] : "?";
+            fprintf(t->file, "%u,%s,%d,%d,%d,%.1f,%.1f\n", event.tick, name, event.player + 1, event.kind,
+                    event.value, event.x, event.y);
+        } else if (__atomic_load_n(&t->running, __ATOMIC_ACQUIRE)) {
+            SDL_Delay(2);
+        } else {
+            break;
+        }
+    }
+    return 0;
+}
+
+bool telemetryStart(Telemetry* t, const char* path) {
+    initEventQueue(&t->queue);
+    t->events.next = 0;
+    t->events.lost = 0;
+    t->forwarded = 0;
+    t->dropped = 0;
+    t->file = fopen(path, "w");
+    if (t->file == NULL) {
+        printf("Telemetry: cannot open %s\n", path);
+        return false;
+    }
+    fprintf(t->file, "tick,event,player,kind,value,x,y\n");
+    t->running = 1;
+    t->thread = SDL_CreateThread(writerThread, "telemetry", t);
+    if (t->thread == NULL) {
+        printf("Telemetry: cannot start the writer thread: %s\n", SDL_GetError());
+        fclose(t->file);
+        t->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+void telemetryForward(Telemetry* t, const SimContext* ctx) {
+    const SimEvent* event;
+    while ((event = nextSimEvent(ctx, &t->events)) != NULL) {
+        if (pushEventQueue(&t->queue, event)) {
+            t->forwarded++;
+        } else {
+            t->dropped++;
+        }
+    }
+}
+
+void telemetryStop(Telemetry* t) {
+    __atomic_store_n(&t->running, 0, __ATOMIC_RELEASE);
+    SDL_WaitThread(t->thread, NULL);
+    fclose(t->file);
+    printf("Telemetry: %llu events written, %llu dropped on a full queue, %u overwritten in the ring\n",
+           (unsigned long long)t->forwarded, (unsigned long long)t->dropped, t->events.lost);
+}
+
+#define BENCH_EVENTS 20000000
+
+typedef struct {
+    SimEventQueue* queue;
+    Uint64 sum;
+} BenchConsumer;
+
+static int benchConsumerThread(void* data) {
+    BenchConsumer* c = (BenchConsumer*)data;
+    SimEvent event;
+    for (int received = 0; received < BENCH_EVENTS; ) {
+        if (popEventQueue(c->queue, &event)) {
+            c->sum += event.tick;
+            received++;
+        } else {
+            // Give the producer the core on machines without a spare one
+            SDL_Delay(0);
+        }
+    }
+    return 0;
+}
+
+static double secondsSince(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+void runEventBenchmark(void) {
+    SimContext* ctx = (SimContext*)calloc(1, sizeof(SimContext));
+    SimState* sim = (SimState*)calloc(1, sizeof(SimState));
+    SimEventQueue* queue = (SimEventQueue*)malloc(sizeof(SimEventQueue));
+    if (!ctx || !sim || !queue) {
+        printf("Out of memory\n");
+        free(ctx);
+        free(sim);
+        free(queue);
+        return;
+    }
+    ctx->sim = sim;
+
+    // Publish into the ring, as the step does
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_EVENTS; i++) {
+        sim->tick = (uint32_t)i;
+        publishSimEvent(ctx, (SimEventType)(i % 6), i & 1, 1, i, (float)i, 0.0f);
+    }
+    double publish = secondsSince(start);
+
+    // A tick's worth published, then drained by one reader, as the frame does
+    SimEventCursor cursor;
+    attachEventCursor(ctx, &cursor);
+    Uint64 sum = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_EVENTS; i += 64) {
+        for (int k = 0; k < 64; k++) publishSimEvent(ctx, SIM_EVENT_SCORE, 0, 0, k, 0.0f, 0.0f);
+        const SimEvent* event;
+        while ((event = nextSimEvent(ctx, &cursor)) != NULL) sum += (Uint64)event->value;
+    }
+    double drain = secondsSince(start);
+
+    // Across threads through the lock-free queue
+    initEventQueue(queue);
+    BenchConsumer consumer = {queue, 0};
+    SimEvent event = {0};
+    start = SDL_GetPerformanceCounter();
+    SDL_Thread* thread = SDL_CreateThread(benchConsumerThread, "bench-events", &consumer);
+    double handoff = 0.0;
+    if (thread) {
+        for (int i = 0; i < BENCH_EVENTS; ) {
+            event.tick = (uint32_t)i;
+            if (pushEventQueue(queue, &event)) {
+                i++;
+            } else {
+                SDL_Delay(0);
+            }
+        }
+        SDL_WaitThread(thread, NULL);
+        handoff = secondsSince(start);
+    }
+
+    printf("%d events of %zu bytes (checksums %llu %llu)\n", BENCH_EVENTS, sizeof(SimEvent),
+           (unsigned long long)sum, (unsigned long long)consumer.sum);
+    printf("%24s %10.1f M events/s\n", "publish to ring", BENCH_EVENTS / publish / 1e6);
+    printf("%24s %10.1f M events/s\n", "publish + cursor drain", BENCH_EVENTS / drain / 1e6);
+    if (thread) printf("%24s %10.1f M events/s\n", "SPSC queue to thread", BENCH_EVENTS / handoff / 1e6);
+
+    free(queue);
+    free(sim);
+    free(ctx);
+}
@@ -0,0 +1,27 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "init.h"
+
+// Gameplay event log: the main thread forwards every event from the bus into a
+// lock-free queue and a writer thread turns them into CSV lines, so file I/O
+// never lands on the frame. Events that find the queue full are counted, not waited for.
+typedef struct {
+    SimEventQueue queue;
+    SimEventCursor events;
+    SDL_Thread* thread;
+    FILE* file;
+    int running;            // cleared to let the writer drain the queue and exit
+    Uint64 forwarded;
+    Uint64 dropped;
+} Telemetry;
+
+bool telemetryStart(Telemetry* t, const char* path);
+// Main thread, once per frame after the steps
+void telemetryForward(Telemetry* t, const SimContext* ctx);
+void telemetryStop(Telemetry* t);
+
+// Prints publish, cursor drain and cross-thread queue throughput, then returns
+void runEventBenchmark(void);
+
+#endif
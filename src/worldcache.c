@@ -0,0 +1,168 @@
+#include "worldcache.h"
+#include "render.h"
+#include "stream.h"
+
+// Destroys the tiles, the next render rebuilds them
+void invalidateWorldCache(WorldCache* cache) {
+    for (int i = 0; i < cache->numTiles; i++) {
+        if (cache->tiles[i]) SDL_DestroyTexture(cache->tiles[i]);
+    }
+    free(cache->tiles);
+    free(cache->tileIndex);
+    cache->tiles = NULL;
+    cache->tileIndex = NULL;
+    cache->numTiles = 0;
+    cache->worldTiles = 0;
+    cache->valid = false;
+
+    if (cache->frozenFrame) SDL_DestroyTexture(cache->frozenFrame);
+    cache->frozenFrame = NULL;
+    cache->frozenValid = false;
+}
+
+// Draws the layers into tile's slot as if the camera sat at the tile's left edge
+static void renderCacheTile(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, int tile) {
+    int slot = tile % cache->numTiles;
+    SDL_SetRenderTarget(renderer, cache->tiles[slot]);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    // g is a copy but sim is shared, put the live camera back afterwards
+    float cameraX = g.world.sim->cameraX;
+    g.world.sim->cameraX = (float)((double)tile * CACHE_TILE_WIDTH - streamOriginX(g.world.sim));
+    renderStaticLayers(g, renderer, hn, CACHE_TILE_WIDTH, cache->height);
+    g.world.sim->cameraX = cameraX;
+    cache->tileIndex[slot] = tile;
+}
+
+// Composites background, both hill layers and platforms into CACHE_TILE_WIDTH wide
+// render targets covering everything the camera can see in this level
+bool buildWorldCache(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height) {
+    invalidateWorldCache(cache);
+    if (!SDL_RenderTargetSupported(renderer)) return false;
+
+    // Camera follows the shooter up to the finish line, so the rightmost visible pixel is the level's width + screen_width
+    int extent = (int)g.world.sim->worldWidth + screen_width;
+    int worldTiles = (extent + CACHE_TILE_WIDTH - 1) / CACHE_TILE_WIDTH;
+    bool streamed = g.world.sim->numChunks > 0 && worldTiles > CACHE_STREAM_TILES;
+    int numTiles = streamed ? CACHE_STREAM_TILES : worldTiles;
+
+    cache->tiles = (SDL_Texture**)calloc(numTiles, sizeof(SDL_Texture*));
+    cache->tileIndex = (int*)malloc(numTiles * sizeof(int));
+    if (cache->tiles == NULL || cache->tileIndex == NULL) {
+        invalidateWorldCache(cache);
+        return false;
+    }
+    cache->numTiles = numTiles;
+    cache->worldTiles = worldTiles;
+    cache->width = screen_width;
+    cache->height = screen_height;
+
+    for (int i = 0; i < numTiles; i++) {
+        cache->tileIndex[i] = -1;
+        cache->tiles[i] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                            CACHE_TILE_WIDTH, screen_height);
+        if (cache->tiles[i] == NULL) {
+            printf("Failed to create world cache tile: %s\n", SDL_GetError());
+            invalidateWorldCache(cache);
+            return false;
+        }
+        SDL_SetTextureBlendMode(cache->tiles[i], SDL_BLENDMODE_NONE);
+    }
+
+    if (!streamed) {
+        SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+        for (int i = 0; i < numTiles; i++) renderCacheTile(cache, g, renderer, hn, i);
+        SDL_SetRenderTarget(renderer, previousTarget);
+    }
+    cache->valid = true;
+    return true;
+}
+
+// Builds the tiles a camera window needs that are not in their slots yet. Nothing
+// to do for a whole level; on a streamed one a tile or two whenever the camera
+// crosses into a new one. Call before any drawing, it switches render targets.
+// Tiles are numbered from the world's left edge, cameraX is the state's.
+void refreshWorldCache(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, float cameraX, int screen_width) {
+    double origin = streamOriginX(g.world.sim);
+    int camera = (int)(origin + cameraX);
+    int first = camera / CACHE_TILE_WIDTH;
+    int last = (camera + screen_width) / CACHE_TILE_WIDTH;
+    if (first < 0) first = 0;
+    if (last >= cache->worldTiles) last = cache->worldTiles - 1;
+
+    // A tile outside the resident chunks would be cached without its platforms,
+    // it waits (and shows black) until they stream in
+    float localLeft, localRight;
+    streamWindow(&g.world, &localLeft, &localRight);
+    double left = origin + localLeft, right = origin + localRight;
+    if (right >= g.world.sim->worldWidth) right = (double)cache->worldTiles * CACHE_TILE_WIDTH;
+
+    SDL_Texture* previousTarget = NULL;
+    bool switched = false;
+    for (int i = first; i <= last; i++) {
+        if (cache->tileIndex[i % cache->numTiles] == i) continue;
+        if ((double)i * CACHE_TILE_WIDTH < left || (double)(i + 1) * CACHE_TILE_WIDTH > right) continue;
+        if (!switched) previousTarget = SDL_GetRenderTarget(renderer);
+        switched = true;
+        renderCacheTile(cache, g, renderer, hn, i);
+    }
+    if (switched) SDL_SetRenderTarget(renderer, previousTarget);
+}
+
+// Copies only the two or three tiles that intersect the camera, at world x cameraX
+void drawWorldCache(WorldCache* cache, SDL_Renderer* renderer, double cameraX, int screen_width) {
+    int camera = (int)cameraX;
+    int first = camera / CACHE_TILE_WIDTH;
+    int last = (camera + screen_width) / CACHE_TILE_WIDTH;
+    if (first < 0) first = 0;
+    if (last >= cache->worldTiles) last = cache->worldTiles - 1;
+
+    for (int i = first; i <= last; i++) {
+        int slot = i % cache->numTiles;
+        if (cache->tileIndex[slot] != i) continue;
+        SDL_Rect dstRect = {i * CACHE_TILE_WIDTH - camera, 0, CACHE_TILE_WIDTH, cache->height};
+        SDL_RenderCopy(renderer, cache->tiles[slot], NULL, &dstRect);
+    }
+}
+
+// Renders the paused world once into an off-screen frame, static screens then just copy it
+bool freezeWorldFrame(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height) {
+    if (cache->frozenFrame && (cache->frozenWidth != screen_width || cache->frozenHeight != screen_height)) {
+        SDL_DestroyTexture(cache->frozenFrame);
+        cache->frozenFrame = NULL;
+        cache->frozenValid = false;
+    }
+    if (cache->frozenValid) return true;
+
+    if (cache->frozenFrame == NULL) {
+        if (!SDL_RenderTargetSupported(renderer)) return false;
+        cache->frozenFrame = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                               screen_width, screen_height);
+        if (cache->frozenFrame == NULL) {
+            printf("Failed to create frozen frame: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(cache->frozenFrame, SDL_BLENDMODE_NONE);
+        cache->frozenWidth = screen_width;
+        cache->frozenHeight = screen_height;
+    }
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, cache->frozenFrame);
+    g.deltaTime = 0.0f;
+    render(g, renderer, g.font, hn, screen_width, screen_height);
+    SDL_SetRenderTarget(renderer, previousTarget);
+
+    cache->frozenValid = true;
+    return true;
+}
+
+void drawFrozenFrame(WorldCache* cache, SDL_Renderer* renderer) {
+    SDL_RenderCopy(renderer, cache->frozenFrame, NULL, NULL);
+}
+
+// Gameplay resumed, the next freeze must capture a new frame
+void thawWorldFrame(WorldCache* cache) {
+    cache->frozenValid = false;
+}
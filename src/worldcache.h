@@ -0,0 +1,14 @@
+#ifndef WORLDCACHE_H
+#define WORLDCACHE_H
+
+#include "init.h"
+
+void invalidateWorldCache(WorldCache* cache);
+bool buildWorldCache(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height);
+void refreshWorldCache(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, float cameraX, int screen_width);
+void drawWorldCache(WorldCache* cache, SDL_Renderer* renderer, double cameraX, int screen_width);
+bool freezeWorldFrame(WorldCache* cache, GameData g, SDL_Renderer* renderer, HillNoise* hn, int screen_width, int screen_height);
+void drawFrozenFrame(WorldCache* cache, SDL_Renderer* renderer);
+void thawWorldFrame(WorldCache* cache);
+
+#endif